@@ -0,0 +1,95 @@
+#include "ascii.h"
+
+#include "simd.h"
+
+namespace string {
+
+namespace internal {
+
+namespace {
+
+// Flip the case of every byte in [data, data + n) within [first, first + 25].
+// The difference between upper and lower case ASCII letters is always 0x20.
+template <char first>
+void _FlipCase(char* data, size_t n) {
+  size_t i = 0;
+
+#ifdef CPPSTRING_HAVE_SSE2
+  // SSE2 only has signed comparisons, so shift the range [first, first + 25]
+  // down to [-128, -103] and then a single signed less-than tests for it.
+  const __m128i shift = _mm_set1_epi8(static_cast<char>(0x80 - first));
+  const __m128i limit = _mm_set1_epi8(-128 + 26);
+  const __m128i flip = _mm_set1_epi8(0x20);
+  for (; i + 16 <= n; i += 16) {
+    auto* p = reinterpret_cast<__m128i*>(data + i);
+    __m128i v = _mm_loadu_si128(p);
+    __m128i in_range = _mm_cmplt_epi8(_mm_add_epi8(v, shift), limit);
+    _mm_storeu_si128(p, _mm_xor_si128(v, _mm_and_si128(in_range, flip)));
+  }
+#endif  // CPPSTRING_HAVE_SSE2
+
+  for (; i < n; i++) {
+    if (static_cast<unsigned char>(data[i] - first) < 26) {
+      data[i] ^= 0x20;
+    }
+  }
+}
+
+}  // namespace
+
+void AsciiToLower(char* data, size_t n) { _FlipCase<'A'>(data, n); }
+
+void AsciiToUpper(char* data, size_t n) { _FlipCase<'a'>(data, n); }
+
+size_t AsciiPrefixLength(const char* data, size_t n) {
+  size_t i = 0;
+
+#ifdef CPPSTRING_HAVE_SSE2
+  // The top bit of each byte is set iff it is not ASCII, and movemask collects
+  // exactly those bits.
+  for (; i + 32 <= n; i += 32) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    __m128i b =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 16));
+    unsigned mask = _mm_movemask_epi8(a) | (_mm_movemask_epi8(b) << 16);
+    if (mask != 0) {
+      return i + LowestSetBit(mask);
+    }
+  }
+#endif  // CPPSTRING_HAVE_SSE2
+
+  for (; i < n; i++) {
+    if (static_cast<unsigned char>(data[i]) >= 0x80) {
+      return i;
+    }
+  }
+
+  return n;
+}
+
+bool AsciiEqualsIgnoreCase(const char* a, const char* b, size_t n) {
+  size_t i = 0;
+
+#ifdef CPPSTRING_HAVE_SSE2
+  for (; i + 16 <= n; i += 16) {
+    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    __m128i eq = _mm_cmpeq_epi8(AsciiFold128(va), AsciiFold128(vb));
+    if (_mm_movemask_epi8(eq) != 0xffff) {
+      return false;
+    }
+  }
+#endif  // CPPSTRING_HAVE_SSE2
+
+  for (; i < n; i++) {
+    if (AsciiFold(a[i]) != AsciiFold(b[i])) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}  // namespace internal
+
+}  // namespace string
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+
+namespace string {
+
+// Internal; don't use directly.
+namespace internal {
+
+// Convert all ASCII upper-case letters in [data, data + n) to lower-case, in
+// place. All other bytes (including non-ASCII bytes) are left untouched.
+void AsciiToLower(char* data, size_t n);
+
+// Convert all ASCII lower-case letters in [data, data + n) to upper-case, in
+// place. All other bytes (including non-ASCII bytes) are left untouched.
+void AsciiToUpper(char* data, size_t n);
+
+// Get the number of bytes at the start of [data, data + n) which are ASCII
+// (i.e. below 0x80). This checks 32 bytes at a time.
+size_t AsciiPrefixLength(const char* data, size_t n);
+
+// Fold an ASCII upper-case letter to lower-case. All other bytes are returned
+// unchanged.
+inline char AsciiFold(char c) {
+  return static_cast<unsigned char>(c - 'A') < 26 ? c | 0x20 : c;
+}
+
+// Compare [a, a + n) and [b, b + n), ignoring the case of ASCII letters.
+bool AsciiEqualsIgnoreCase(const char* a, const char* b, size_t n);
+
+}  // namespace internal
+
+}  // namespace string
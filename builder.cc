@@ -0,0 +1,122 @@
+#include "builder.h"
+
+#include <algorithm>
+
+namespace string {
+
+StringBuilder::~StringBuilder() {
+  if (!is_inline()) {
+    delete[] data_;
+  }
+}
+
+StringBuilder::StringBuilder(StringBuilder&& other) noexcept {
+  *this = std::move(other);
+}
+
+StringBuilder& StringBuilder::operator=(StringBuilder&& other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+
+  if (!is_inline()) {
+    delete[] data_;
+  }
+
+  if (other.is_inline()) {
+    std::char_traits<char>::copy(inline_, other.inline_, other.size_);
+    data_ = inline_;
+    capacity_ = kInlineCapacity;
+  } else {
+    data_ = other.data_;
+    capacity_ = other.capacity_;
+    other.data_ = other.inline_;
+    other.capacity_ = kInlineCapacity;
+  }
+
+  size_ = other.size_;
+  other.size_ = 0;
+  return *this;
+}
+
+void StringBuilder::Grow(size_t capacity, const char* str, size_t n) {
+  capacity = std::max(capacity, 2 * capacity_);
+  char* data = new char[capacity];
+  std::char_traits<char>::copy(data, data_, size_);
+  std::char_traits<char>::copy(data + size_, str, n);
+  size_ += n;
+  if (!is_inline()) {
+    delete[] data_;
+  }
+
+  data_ = data;
+  capacity_ = capacity;
+}
+
+StringBuilder& StringBuilder::AppendJoin(const std::vector<std::string>& list,
+                                         std::string_view sep) {
+  // Reserving below would free a separator taken from the contents.
+  if (Aliases(sep)) {
+    return AppendJoin(list, std::string(sep));
+  }
+
+  size_t size = list.empty() ? 0 : sep.size() * (list.size() - 1);
+  for (const auto& item : list) {
+    size += item.size();
+  }
+
+  reserve(size_ + size);
+  for (size_t i = 0; i < list.size(); i++) {
+    if (i > 0) {
+      append(sep);
+    }
+
+    append(list[i]);
+  }
+
+  return *this;
+}
+
+StringBuilder& StringBuilder::AppendReplace(std::string_view str,
+                                            std::string_view old,
+                                            std::string_view replacement,
+                                            int count) {
+  // The needle can only be borrowed if growing won't free it.
+  if (Aliases(old)) {
+    return AppendReplace(str, Searcher(old), replacement, count);
+  }
+
+  return AppendReplace(str, Searcher::Borrow(old), replacement, count);
+}
+
+StringBuilder& StringBuilder::AppendReplace(std::string_view str,
+                                            const Searcher& old,
+                                            std::string_view replacement,
+                                            int count) {
+  // Growing would free any input taken from the contents, so copy them first.
+  if (Aliases(str) || Aliases(replacement)) {
+    return AppendReplace(std::string(str), old, std::string(replacement),
+                         count);
+  }
+
+  reserve(size_ + str.size());
+
+  int n_replaced = 0;
+  size_t last_end = 0;
+  size_t start = old.Find(str);
+  while (start != std::string::npos && (count < 0 || n_replaced < count)) {
+    append(str.substr(last_end, start - last_end));
+    append(replacement);
+    last_end = start + old.size();
+    n_replaced++;
+
+    // An empty needle matches between every character, so step over one
+    // character to avoid matching at the same position forever.
+    start = old.Find(str, start + std::max<size_t>(old.size(), 1));
+  }
+
+  append(str.substr(last_end));
+  return *this;
+}
+
+}  // namespace string
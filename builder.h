@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "format.h"
+#include "search.h"
+
+namespace string {
+
+/**
+ * @brief      A growable output buffer for building strings out of many
+ *             pieces.
+ *
+ * @details    Short strings are built in an inline buffer without allocating
+ *             at all. Past that, the buffer grows geometrically, and clear()
+ *             keeps whatever capacity has been reached, so a builder which is
+ *             reused (e.g. one per thread) stops allocating once it has grown
+ *             to fit the largest output:
+ *
+ *                 thread_local StringBuilder builder;
+ *                 builder.clear();
+ *                 builder.AppendFormat("{}: ", {name});
+ *                 builder.AppendJoin(values, ", ");
+ *                 Write(builder.view());
+ *
+ *             The lowercase append, push_back, reserve and size members match
+ *             std::string, so a builder can be filled by anything which fills
+ *             a string.
+ */
+class StringBuilder {
+ public:
+  /**
+   * The number of bytes which can be built without allocating.
+   */
+  static constexpr size_t kInlineCapacity = 128;
+
+  StringBuilder() = default;
+
+  /**
+   * @brief      Create a builder with room for at least `capacity` bytes.
+   */
+  explicit StringBuilder(size_t capacity) { reserve(capacity); }
+
+  ~StringBuilder();
+
+  StringBuilder(StringBuilder&& other) noexcept;
+  StringBuilder& operator=(StringBuilder&& other) noexcept;
+
+  StringBuilder(const StringBuilder&) = delete;
+  StringBuilder& operator=(const StringBuilder&) = delete;
+
+  size_t size() const { return size_; }
+  size_t capacity() const { return capacity_; }
+  bool empty() const { return size_ == 0; }
+  const char* data() const { return data_; }
+
+  /**
+   * @brief      Get a view of the contents, which is valid until the builder
+   *             is next modified.
+   */
+  std::string_view view() const { return std::string_view(data_, size_); }
+
+  /**
+   * @brief      Copy the contents into a string.
+   */
+  std::string str() const { return std::string(data_, size_); }
+
+  /**
+   * @brief      Make sure that at least `capacity` bytes can be held without
+   *             reallocating.
+   */
+  void reserve(size_t capacity) {
+    if (capacity > capacity_) {
+      Grow(capacity);
+    }
+  }
+
+  /**
+   * @brief      Remove the contents, but keep the capacity.
+   */
+  void clear() { size_ = 0; }
+
+  void append(const char* str, size_t n) {
+    if (n > capacity_ - size_) {
+      Grow(size_ + n, str, n);
+      return;
+    }
+
+    std::char_traits<char>::copy(data_ + size_, str, n);
+    size_ += n;
+  }
+
+  void append(std::string_view str) { append(str.data(), str.size()); }
+
+  void push_back(char c) {
+    reserve(size_ + 1);
+    data_[size_++] = c;
+  }
+
+  /**
+   * @brief      Append a string or a character.
+   */
+  StringBuilder& Append(std::string_view str) {
+    append(str);
+    return *this;
+  }
+
+  StringBuilder& Append(char c) {
+    push_back(c);
+    return *this;
+  }
+
+  /**
+   * @brief      Append the result of Format(fmt, args).
+   * @see        Format
+   */
+  StringBuilder& AppendFormat(const std::string& fmt,
+                              const FormatListType& args);
+
+  /**
+   * @brief      Append the result of FormatMap(fmt, args, missing_tags_ok).
+   * @see        FormatMap
+   */
+  StringBuilder& AppendFormatMap(const std::string& fmt,
+                                 const FormatMapType& args,
+                                 bool missing_tags_ok = false);
+
+  /**
+   * @brief      Append the strings in `list`, separated by `sep`.
+   * @see        Join
+   */
+  StringBuilder& AppendJoin(const std::vector<std::string>& list,
+                            std::string_view sep);
+
+  /**
+   * @brief      Append the result of Replace(str, old, replacement, count).
+   *
+   * @details    Unlike Replace, the matches aren't collected up front; each
+   *             piece is appended as soon as it is found.
+   *
+   * @see        Replace
+   */
+  StringBuilder& AppendReplace(std::string_view str, std::string_view old,
+                               std::string_view replacement, int count = -1);
+  StringBuilder& AppendReplace(std::string_view str, const Searcher& old,
+                               std::string_view replacement, int count = -1);
+
+ private:
+  // Move to a heap buffer with room for at least `capacity` bytes, and append
+  // [str, str + n) to it. `str` may point into the old buffer, since that is
+  // only freed afterwards.
+  void Grow(size_t capacity, const char* str = nullptr, size_t n = 0);
+
+  bool is_inline() const { return data_ == inline_; }
+
+  // Check whether `str` points into the contents, so that it would be left
+  // dangling if the buffer grew.
+  bool Aliases(std::string_view str) const {
+    std::less<const char*> less;
+    return !less(str.data(), data_) && less(str.data(), data_ + size_);
+  }
+
+  char* data_ = inline_;
+  size_t size_ = 0;
+  size_t capacity_ = kInlineCapacity;
+  char inline_[kInlineCapacity];
+};
+
+}  // namespace string
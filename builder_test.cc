@@ -0,0 +1,120 @@
+#include "builder.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "split.h"
+#include "util.h"
+
+TEST(TestStringBuilder, TestAppend) {
+  string::StringBuilder builder;
+  ASSERT_TRUE(builder.empty());
+  ASSERT_EQ(string::StringBuilder::kInlineCapacity, builder.capacity());
+
+  builder.Append("hello").Append(',').Append(" world");
+  ASSERT_EQ("hello, world", builder.view());
+  ASSERT_EQ("hello, world", builder.str());
+  ASSERT_EQ(12, builder.size());
+}
+
+TEST(TestStringBuilder, TestGrowsPastInlineBuffer) {
+  string::StringBuilder builder;
+  std::string expected;
+  for (int i = 0; i < 1000; i++) {
+    builder.Append(std::to_string(i));
+    expected += std::to_string(i);
+  }
+
+  ASSERT_EQ(expected, builder.view());
+  ASSERT_GE(builder.capacity(), expected.size());
+}
+
+TEST(TestStringBuilder, TestClearKeepsCapacity) {
+  string::StringBuilder builder(10000);
+  size_t capacity = builder.capacity();
+  ASSERT_GE(capacity, 10000);
+
+  builder.Append(std::string(5000, 'x'));
+  const char* data = builder.data();
+  builder.clear();
+  ASSERT_TRUE(builder.empty());
+  ASSERT_EQ(capacity, builder.capacity());
+
+  builder.Append("again");
+  ASSERT_EQ("again", builder.view());
+  ASSERT_EQ(data, builder.data());
+}
+
+TEST(TestStringBuilder, TestMove) {
+  string::StringBuilder small;
+  small.Append("small");
+  string::StringBuilder moved_small(std::move(small));
+  ASSERT_EQ("small", moved_small.view());
+
+  string::StringBuilder big;
+  big.Append(std::string(1000, 'y'));
+  const char* data = big.data();
+  moved_small = std::move(big);
+  ASSERT_EQ(std::string(1000, 'y'), moved_small.view());
+  ASSERT_EQ(data, moved_small.data());
+  ASSERT_TRUE(big.empty());
+}
+
+TEST(TestStringBuilder, TestAppendFormat) {
+  string::StringBuilder builder;
+  builder.Append("> ");
+  builder.AppendFormat("{} + {} = {:d}", {1, 2, 3});
+  builder.AppendFormatMap(" ({name})", {{"name", "sum"}});
+  ASSERT_EQ("> 1 + 2 = 3 (sum)", builder.view());
+
+  ASSERT_THROW(builder.AppendFormatMap("{missing}", {}), std::out_of_range);
+}
+
+TEST(TestStringBuilder, TestAppendJoin) {
+  std::vector<std::string> list = {"a", "bb", "", "ccc"};
+  string::StringBuilder builder;
+  builder.AppendJoin(list, ", ");
+  builder.Append('|');
+  builder.AppendJoin({}, ", ");
+  ASSERT_EQ(string::Join(list, ", ") + "|", builder.view());
+}
+
+TEST(TestStringBuilder, TestAppendReplaceMatchesReplace) {
+  const std::vector<std::string> strs = {"", "aaa", "abcabcab", "xyz",
+                                         std::string(300, 'a')};
+  const std::vector<std::string> olds = {"", "a", "ab", "abc", "aaaa"};
+  for (const auto& str : strs) {
+    for (const auto& old : olds) {
+      for (int count : {-1, 0, 2}) {
+        string::StringBuilder builder;
+        builder.AppendReplace(str, old, "<>", count);
+        ASSERT_EQ(string::Replace(str, old, "<>", count), builder.view())
+            << str << " " << old << " " << count;
+      }
+    }
+  }
+}
+
+TEST(TestStringBuilder, TestAppendOwnContents) {
+  // Each append grows the heap buffer while reading from it.
+  string::StringBuilder builder;
+  builder.Append(std::string(200, 'x'));
+  std::string expected(200, 'x');
+  for (int i = 0; i < 4; i++) {
+    builder.append(builder.view());
+    expected += expected;
+  }
+
+  ASSERT_EQ(expected, builder.view());
+
+  builder.clear();
+  builder.Append(std::string(200, 'a')).Append(", ");
+  builder.AppendJoin({"b", "c"}, builder.view().substr(200));
+  builder.AppendReplace(builder.view().substr(0, 200), "a", builder.view());
+
+  expected = std::string(200, 'a') + ", b, c";
+  expected += string::Replace(expected.substr(0, 200), "a", expected);
+  ASSERT_EQ(expected, builder.view());
+}
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "constants.h"
+
+namespace string {
+
+/**
+ * Character classes which can be used as compile-time separator and token sets.
+ * @see        Split
+ * @see        Trim
+ */
+enum class CharClass {
+  Whitespace,
+  Digit,
+  HexDigit,
+  OctDigit,
+  Lowercase,
+  Uppercase,
+  Letter,
+  Punctuation,
+  Printable,
+};
+
+// Internal; don't use directly.
+namespace internal {
+
+// A set of bytes, stored as a 256-bit membership table. Lookups are a shift and
+// a mask, and the whole thing can be built at compile time.
+class CharSet {
+ public:
+  constexpr CharSet() : bits_{0, 0, 0, 0} {}
+
+  constexpr CharSet(const char* chars, size_t n) : bits_{0, 0, 0, 0} {
+    for (size_t i = 0; i < n; i++) {
+      Add(chars[i]);
+    }
+  }
+
+  constexpr explicit CharSet(std::string_view chars)
+      : CharSet(chars.data(), chars.size()) {}
+
+  constexpr void Add(char c) {
+    auto u = static_cast<unsigned char>(c);
+    bits_[u >> 6] |= uint64_t{1} << (u & 63);
+  }
+
+  constexpr bool Contains(char c) const {
+    auto u = static_cast<unsigned char>(c);
+    return (bits_[u >> 6] >> (u & 63)) & 1;
+  }
+
+  constexpr CharSet operator|(const CharSet& other) const {
+    CharSet result;
+    for (int i = 0; i < 4; i++) {
+      result.bits_[i] = bits_[i] | other.bits_[i];
+    }
+
+    return result;
+  }
+
+ private:
+  uint64_t bits_[4];
+};
+
+// Build a CharSet from a string literal.
+template <size_t N>
+constexpr CharSet MakeCharSet(const char (&chars)[N]) {
+  return CharSet(chars, N - 1);
+}
+
+// Build a CharSet from a list of characters.
+template <char... Chars>
+constexpr CharSet MakeCharSet() {
+  const char chars[] = {Chars..., '\0'};
+  return CharSet(chars, sizeof...(Chars));
+}
+
+// The membership tables for each CharClass.
+inline constexpr CharSet kWhitespaceSet(kWhitespace);
+inline constexpr CharSet kDigitSet(kDigits);
+inline constexpr CharSet kHexDigitSet(kHexDigits);
+inline constexpr CharSet kOctDigitSet(kOctDigits);
+inline constexpr CharSet kLowercaseSet(kAsciiLowercase);
+inline constexpr CharSet kUppercaseSet(kAsciiUppercase);
+inline constexpr CharSet kLetterSet(kAsciiLetters);
+inline constexpr CharSet kPunctuationSet(kPunctuation);
+inline constexpr CharSet kPrintableSet(kPrintable);
+
+// Get the CharSet representing the given CharClass.
+constexpr CharSet CharClassSet(CharClass cls) {
+  switch (cls) {
+    case CharClass::Whitespace:
+      return kWhitespaceSet;
+    case CharClass::Digit:
+      return kDigitSet;
+    case CharClass::HexDigit:
+      return kHexDigitSet;
+    case CharClass::OctDigit:
+      return kOctDigitSet;
+    case CharClass::Lowercase:
+      return kLowercaseSet;
+    case CharClass::Uppercase:
+      return kUppercaseSet;
+    case CharClass::Letter:
+      return kLetterSet;
+    case CharClass::Punctuation:
+      return kPunctuationSet;
+    case CharClass::Printable:
+      return kPrintableSet;
+  }
+
+  return CharSet();
+}
+
+// Find the first character at or after `pos` which is (or, if `negate` is set,
+// is not) in `set`. Returns std::string::npos if there is no such character.
+template <bool negate = false>
+size_t FindFirstOf(std::string_view str, const CharSet& set, size_t pos = 0) {
+  for (size_t i = pos; i < str.size(); i++) {
+    if (set.Contains(str[i]) != negate) {
+      return i;
+    }
+  }
+
+  return std::string::npos;
+}
+
+// Same as FindFirstOf, but searches backwards from the end of `str`.
+template <bool negate = false>
+size_t FindLastOf(std::string_view str, const CharSet& set) {
+  for (size_t i = str.size(); i > 0; i--) {
+    if (set.Contains(str[i - 1]) != negate) {
+      return i - 1;
+    }
+  }
+
+  return std::string::npos;
+}
+
+}  // namespace internal
+
+/**
+ * @brief      Check whether `c` is in the given CharClass.
+ *
+ * @details    Unlike the functions in <cctype>, these don't depend on the
+ *             current locale, and are a single table lookup.
+ */
+constexpr bool IsCharClass(char c, CharClass cls) {
+  return internal::CharClassSet(cls).Contains(c);
+}
+
+/**
+ * @brief      Check whether `c` is in `kWhitespace`.
+ */
+constexpr bool IsWhitespace(char c) {
+  return internal::kWhitespaceSet.Contains(c);
+}
+
+/**
+ * @brief      Check whether `c` is in `kDigits`.
+ */
+constexpr bool IsDigit(char c) { return internal::kDigitSet.Contains(c); }
+
+/**
+ * @brief      Check whether `c` is in `kHexDigits`.
+ */
+constexpr bool IsHexDigit(char c) {
+  return internal::kHexDigitSet.Contains(c);
+}
+
+/**
+ * @brief      Check whether `c` is in `kOctDigits`.
+ */
+constexpr bool IsOctDigit(char c) {
+  return internal::kOctDigitSet.Contains(c);
+}
+
+/**
+ * @brief      Check whether `c` is in `kAsciiLowercase`.
+ */
+constexpr bool IsLowercase(char c) {
+  return internal::kLowercaseSet.Contains(c);
+}
+
+/**
+ * @brief      Check whether `c` is in `kAsciiUppercase`.
+ */
+constexpr bool IsUppercase(char c) {
+  return internal::kUppercaseSet.Contains(c);
+}
+
+/**
+ * @brief      Check whether `c` is in `kAsciiLetters`.
+ */
+constexpr bool IsLetter(char c) { return internal::kLetterSet.Contains(c); }
+
+/**
+ * @brief      Check whether `c` is in `kPunctuation`.
+ */
+constexpr bool IsPunctuation(char c) {
+  return internal::kPunctuationSet.Contains(c);
+}
+
+/**
+ * @brief      Check whether `c` is in `kPrintable`.
+ */
+constexpr bool IsPrintable(char c) {
+  return internal::kPrintableSet.Contains(c);
+}
+
+/**
+ * @brief      Check whether every character of `str` is in the given CharClass.
+ *
+ * @details    Returns `false` for an empty string, like Python's str.isdigit()
+ *             and friends.
+ */
+constexpr bool IsAllCharClass(std::string_view str, CharClass cls) {
+  if (str.empty()) {
+    return false;
+  }
+
+  internal::CharSet set = internal::CharClassSet(cls);
+  for (char c : str) {
+    if (!set.Contains(c)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}  // namespace string
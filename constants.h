@@ -1,76 +1,88 @@
 #pragma once
 
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
 namespace string {
 
 /**
  * The lower-case, ASCII letters.
  */
-extern const std::string kAsciiLowercase;
+inline constexpr std::string_view kAsciiLowercase =
+    "abcdefghijklmnopqrstuvwxyz";
 
 /**
  * The upper-case, ASCII letters.
  */
-extern const std::string kAsciiUppercase;
+inline constexpr std::string_view kAsciiUppercase =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
 
 /**
  * All digits 0-9.
  */
-extern const std::string kDigits;
+inline constexpr std::string_view kDigits = "0123456789";
 
 /**
  * All digits that can be in hex numbers.
  */
-extern const std::string kHexDigits;
+inline constexpr std::string_view kHexDigits = "0123456789abcdefABCDEF";
 
 /**
  * All digits that can be in octal numbers.
  */
-extern const std::string kOctDigits;
+inline constexpr std::string_view kOctDigits = "01234567";
 
 /**
  * All punctuation characters.
  */
-extern const std::string kPunctuation;
+inline constexpr std::string_view kPunctuation =
+    "!\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
 
 /**
  * All whitespace characters.
  */
-extern const std::string kWhitespace;
+inline constexpr std::string_view kWhitespace = "\t\n\x0b\x0c\r ";
 
 // Generated based on the above.
 /**
  * `kAsciiLowercase` + `kAsciiUppercase`
  */
-extern const std::string kAsciiLetters;
+inline constexpr std::string_view kAsciiLetters =
+    "abcdefghijklmnopqrstuvwxyz"
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
 
 /**
  * `kDigits` + `kAsciiLetters` + `kPunctuation` + `kWhitespace`
  */
-extern const std::string kPrintable;
+inline constexpr std::string_view kPrintable =
+    "0123456789"
+    "abcdefghijklmnopqrstuvwxyz"
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+    "!\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~"
+    "\t\n\x0b\x0c\r ";
 
 // Colors.
 namespace color {
 
 // Magic color reset.
-extern const std::string kReset;
+inline constexpr std::string_view kReset = "\033[0m";
 
 // Color formats.
-extern const std::string kBold;
-extern const std::string kItalic;
+inline constexpr std::string_view kBold = "\033[1m";
+inline constexpr std::string_view kItalic = "\033[3m";
 
 // Colors.
-extern const std::string kBlack;
-extern const std::string kRed;
-extern const std::string kGreen;
-extern const std::string kYellow;
-extern const std::string kBlue;
-extern const std::string kMagenta;
-extern const std::string kCyan;
-extern const std::string kWhite;
-extern const std::string kGray;
+inline constexpr std::string_view kBlack = "\033[30m";
+inline constexpr std::string_view kRed = "\033[31m";
+inline constexpr std::string_view kGreen = "\033[32m";
+inline constexpr std::string_view kYellow = "\033[33m";
+inline constexpr std::string_view kBlue = "\033[34m";
+inline constexpr std::string_view kMagenta = "\033[35m";
+inline constexpr std::string_view kCyan = "\033[36m";
+inline constexpr std::string_view kWhite = "\033[37m";
+
+// `kBlack` + `kBold`
+inline constexpr std::string_view kGray = "\033[30m\033[1m";
 
 }  // namespace color
 
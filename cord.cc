@@ -0,0 +1,553 @@
+#include "cord.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "charset.h"
+
+namespace string {
+
+namespace internal {
+
+// A node of a Cord's tree. Leaves (height 0) refer to [offset, offset +
+// length) of a shared buffer; every other node is the concatenation of its two
+// children, whose heights differ by at most 1.
+struct CordNode {
+  size_t length;
+  int height;
+
+  std::shared_ptr<const CordNode> left;
+  std::shared_ptr<const CordNode> right;
+
+  std::shared_ptr<const std::string> data;
+  size_t offset;
+};
+
+}  // namespace internal
+
+namespace {
+
+using internal::CordNode;
+using NodePtr = std::shared_ptr<const CordNode>;
+
+// Appended views are copied into the last chunk if the result is at most this
+// long, so that many small appends don't each get a chunk of their own.
+constexpr size_t kMaxMergeLength = 512;
+
+int _Height(const NodePtr& node) {
+  return node->height;
+}
+
+NodePtr _MakeLeaf(std::shared_ptr<const std::string> data, size_t offset,
+                  size_t length) {
+  return std::make_shared<const CordNode>(
+      CordNode{length, 0, nullptr, nullptr, std::move(data), offset});
+}
+
+NodePtr _MakeLeaf(std::string str) {
+  size_t length = str.size();
+  return _MakeLeaf(std::make_shared<const std::string>(std::move(str)), 0,
+                   length);
+}
+
+NodePtr _MakeConcat(NodePtr left, NodePtr right) {
+  size_t length = left->length + right->length;
+  int height = std::max(left->height, right->height) + 1;
+  return std::make_shared<const CordNode>(
+      CordNode{length, height, std::move(left), std::move(right), nullptr, 0});
+}
+
+std::string_view _LeafView(const CordNode& leaf) {
+  return std::string_view(*leaf.data).substr(leaf.offset, leaf.length);
+}
+
+// Call `fn` with each chunk under `node` in order, until it returns false.
+// Returns false iff `fn` did.
+template <typename Fn>
+bool _ForEachChunk(const NodePtr& node, const Fn& fn) {
+  if (!node) {
+    return true;
+  }
+
+  if (node->height == 0) {
+    return fn(_LeafView(*node));
+  }
+
+  return _ForEachChunk(node->left, fn) && _ForEachChunk(node->right, fn);
+}
+
+const CordNode* _LastLeaf(const CordNode* node) {
+  while (node->height > 0) {
+    node = node->right.get();
+  }
+
+  return node;
+}
+
+NodePtr _RotateLeft(const NodePtr& node) {
+  const NodePtr& right = node->right;
+  return _MakeConcat(_MakeConcat(node->left, right->left), right->right);
+}
+
+NodePtr _RotateRight(const NodePtr& node) {
+  const NodePtr& left = node->left;
+  return _MakeConcat(left->left, _MakeConcat(left->right, node->right));
+}
+
+// Concatenate `a` and `b`, where `a` is more than one taller than `b`, by
+// walking down the right spine of `a` to a subtree of about the same height as
+// `b`, and rebalancing on the way back up.
+NodePtr _JoinRight(const NodePtr& a, const NodePtr& b) {
+  const NodePtr& left = a->left;
+  const NodePtr& middle = a->right;
+  if (_Height(middle) <= _Height(b) + 1) {
+    NodePtr joined = _MakeConcat(middle, b);
+    if (_Height(joined) <= _Height(left) + 1) {
+      return _MakeConcat(left, std::move(joined));
+    }
+
+    return _RotateLeft(_MakeConcat(left, _RotateRight(joined)));
+  }
+
+  NodePtr joined = _JoinRight(middle, b);
+  if (_Height(joined) <= _Height(left) + 1) {
+    return _MakeConcat(left, std::move(joined));
+  }
+
+  return _RotateLeft(_MakeConcat(left, std::move(joined)));
+}
+
+// The mirror image of _JoinRight, for when `b` is more than one taller.
+NodePtr _JoinLeft(const NodePtr& a, const NodePtr& b) {
+  const NodePtr& middle = b->left;
+  const NodePtr& right = b->right;
+  if (_Height(middle) <= _Height(a) + 1) {
+    NodePtr joined = _MakeConcat(a, middle);
+    if (_Height(joined) <= _Height(right) + 1) {
+      return _MakeConcat(std::move(joined), right);
+    }
+
+    return _RotateRight(_MakeConcat(_RotateLeft(joined), right));
+  }
+
+  NodePtr joined = _JoinLeft(a, middle);
+  if (_Height(joined) <= _Height(right) + 1) {
+    return _MakeConcat(std::move(joined), right);
+  }
+
+  return _RotateRight(_MakeConcat(std::move(joined), right));
+}
+
+// Concatenate two trees, in O(|height(a) - height(b)|) time.
+NodePtr _Join(const NodePtr& a, const NodePtr& b) {
+  if (!a) {
+    return b;
+  }
+
+  if (!b) {
+    return a;
+  }
+
+  if (_Height(a) > _Height(b) + 1) {
+    return _JoinRight(a, b);
+  }
+
+  if (_Height(b) > _Height(a) + 1) {
+    return _JoinLeft(a, b);
+  }
+
+  return _MakeConcat(a, b);
+}
+
+// Get the bytes in [begin, end) of `node`, or null if the range is empty.
+NodePtr _Substr(const NodePtr& node, size_t begin, size_t end) {
+  if (begin >= end) {
+    return nullptr;
+  }
+
+  if (begin == 0 && end == node->length) {
+    return node;
+  }
+
+  if (node->height == 0) {
+    return _MakeLeaf(node->data, node->offset + begin, end - begin);
+  }
+
+  size_t split = node->left->length;
+  if (end <= split) {
+    return _Substr(node->left, begin, end);
+  }
+
+  if (begin >= split) {
+    return _Substr(node->right, begin - split, end - split);
+  }
+
+  return _Join(_Substr(node->left, begin, split),
+               _Substr(node->right, 0, end - split));
+}
+
+// Call `on_match(pos)` with the position of each non-overlapping occurrence of
+// `needle` in `str`, from left to right, until it returns false. The needle
+// must not be empty.
+//
+// Matches which lie within a chunk are found by searching the chunk directly.
+// The last `needle.size() - 1` bytes which could still start a match are kept
+// in `pending`, and are searched along with the start of the next chunk to
+// find the matches which span chunk boundaries.
+template <typename MatchFn>
+void _ForEachMatch(const Cord& str, const Searcher& needle,
+                   const MatchFn& on_match) {
+  const size_t m = needle.size();
+
+  // `pending` holds the bytes of [pending_start, chunk_start).
+  std::string pending;
+  size_t pending_start = 0;
+  size_t chunk_start = 0;
+
+  for (std::string_view chunk : str.Chunks()) {
+    size_t resume = 0;
+    if (chunk.size() < m) {
+      // Too short to hold a match by itself, so just add it to the pending
+      // bytes and search those.
+      pending.append(chunk);
+      size_t pos = needle.Find(pending);
+      while (pos != std::string::npos) {
+        if (!on_match(pending_start + pos)) {
+          return;
+        }
+
+        resume = pos + m;
+        pos = needle.Find(pending, resume);
+      }
+
+      size_t keep = std::max(
+          resume, pending.size() > m - 1 ? pending.size() - (m - 1) : 0);
+      pending.erase(0, keep);
+      pending_start += keep;
+      chunk_start += chunk.size();
+      continue;
+    }
+
+    // Find the matches which start in the pending bytes. These all end within
+    // the first m - 1 bytes of this chunk.
+    if (!pending.empty()) {
+      size_t boundary = pending.size();
+      pending.append(chunk.substr(0, m - 1));
+      size_t pos = needle.Find(pending);
+      while (pos != std::string::npos && pos < boundary) {
+        if (!on_match(pending_start + pos)) {
+          return;
+        }
+
+        resume = pos + m - boundary;
+        pos = needle.Find(pending, pos + m);
+      }
+    }
+
+    size_t pos = needle.Find(chunk, resume);
+    while (pos != std::string::npos) {
+      if (!on_match(chunk_start + pos)) {
+        return;
+      }
+
+      resume = pos + m;
+      pos = needle.Find(chunk, resume);
+    }
+
+    size_t keep = std::max(resume, chunk.size() - (m - 1));
+    pending.assign(chunk.substr(keep));
+    pending_start = chunk_start + keep;
+    chunk_start += chunk.size();
+  }
+}
+
+}  // namespace
+
+Cord::Cord(std::string_view str) : Cord(std::string(str)) {}
+
+Cord::Cord(std::string&& str) {
+  if (!str.empty()) {
+    root_ = _MakeLeaf(std::move(str));
+  }
+}
+
+size_t Cord::size() const {
+  return root_ ? root_->length : 0;
+}
+
+int Cord::depth() const {
+  return root_ ? root_->height : 0;
+}
+
+char Cord::operator[](size_t i) const {
+  const CordNode* node = root_.get();
+  while (node->height > 0) {
+    if (i < node->left->length) {
+      node = node->left.get();
+    } else {
+      i -= node->left->length;
+      node = node->right.get();
+    }
+  }
+
+  return (*node->data)[node->offset + i];
+}
+
+void Cord::Append(const Cord& other) {
+  root_ = _Join(root_, other.root_);
+}
+
+void Cord::Append(std::string_view str) {
+  if (str.empty()) {
+    return;
+  }
+
+  if (root_ && str.size() <= kMaxMergeLength) {
+    const CordNode* last = _LastLeaf(root_.get());
+    if (last->length + str.size() <= kMaxMergeLength) {
+      std::string merged;
+      merged.reserve(last->length + str.size());
+      merged.append(_LeafView(*last));
+      merged.append(str);
+      root_ = _Join(_Substr(root_, 0, root_->length - last->length),
+                    _MakeLeaf(std::move(merged)));
+      return;
+    }
+  }
+
+  Append(Cord(str));
+}
+
+void Cord::Append(std::string&& str) {
+  Append(Cord(std::move(str)));
+}
+
+void Cord::Prepend(const Cord& other) {
+  root_ = _Join(other.root_, root_);
+}
+
+void Cord::Insert(size_t pos, const Cord& other) {
+  if (pos > size()) {
+    throw std::out_of_range("Cord insert position is out of range.");
+  }
+
+  if (!root_) {
+    root_ = other.root_;
+    return;
+  }
+
+  root_ = _Join(_Join(_Substr(root_, 0, pos), other.root_),
+                _Substr(root_, pos, root_->length));
+}
+
+Cord Cord::Substr(size_t pos, size_t n) const {
+  if (pos > size()) {
+    throw std::out_of_range("Cord substring position is out of range.");
+  }
+
+  if (!root_) {
+    return Cord();
+  }
+
+  size_t end = pos + std::min(n, root_->length - pos);
+  return Cord(_Substr(root_, pos, end));
+}
+
+std::vector<std::string_view> Cord::Chunks() const {
+  std::vector<std::string_view> chunks;
+  _ForEachChunk(root_, [&chunks](std::string_view chunk) {
+    chunks.push_back(chunk);
+    return true;
+  });
+
+  return chunks;
+}
+
+std::string Cord::ToString() const {
+  std::string result;
+  result.reserve(size());
+  _ForEachChunk(root_, [&result](std::string_view chunk) {
+    result.append(chunk);
+    return true;
+  });
+
+  return result;
+}
+
+bool operator==(const Cord& a, const Cord& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+
+  // Walk both lists of chunks at once, comparing the overlapping parts.
+  auto a_chunks = a.Chunks();
+  auto b_chunks = b.Chunks();
+  std::string_view a_rest, b_rest;
+  size_t i = 0, j = 0;
+  while (true) {
+    while (a_rest.empty() && i < a_chunks.size()) {
+      a_rest = a_chunks[i++];
+    }
+
+    while (b_rest.empty() && j < b_chunks.size()) {
+      b_rest = b_chunks[j++];
+    }
+
+    if (a_rest.empty() || b_rest.empty()) {
+      return true;
+    }
+
+    size_t n = std::min(a_rest.size(), b_rest.size());
+    if (a_rest.substr(0, n) != b_rest.substr(0, n)) {
+      return false;
+    }
+
+    a_rest.remove_prefix(n);
+    b_rest.remove_prefix(n);
+  }
+}
+
+bool operator==(const Cord& a, std::string_view b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+
+  size_t pos = 0;
+  for (std::string_view chunk : a.Chunks()) {
+    if (b.substr(pos, chunk.size()) != chunk) {
+      return false;
+    }
+
+    pos += chunk.size();
+  }
+
+  return true;
+}
+
+Cord Replace(const Cord& str, std::string_view old,
+             std::string_view replacement, int count) {
+  return Replace(str, Searcher::Borrow(old), replacement, count);
+}
+
+Cord Replace(const Cord& str, const Searcher& old, std::string_view replacement,
+             int count) {
+  // Every copy of the replacement shares the same chunk.
+  Cord replacement_cord(replacement);
+  Cord result;
+  size_t last_end = 0;
+  int n_replaced = 0;
+  auto replace = [&](size_t pos) {
+    if (count >= 0 && n_replaced >= count) {
+      return false;
+    }
+
+    result.Append(str.Substr(last_end, pos - last_end));
+    result.Append(replacement_cord);
+    last_end = pos + old.size();
+    n_replaced++;
+    return true;
+  };
+
+  if (old.empty()) {
+    // An empty needle matches between every character.
+    for (size_t pos = 0; pos <= str.size() && replace(pos); pos++) {
+    }
+  } else {
+    _ForEachMatch(str, old, replace);
+  }
+
+  result.Append(str.Substr(last_end));
+  return result;
+}
+
+int Count(const Cord& str, std::string_view sub) {
+  if (str.empty() || sub.empty()) {
+    return 0;
+  }
+
+  return Count(str, Searcher::Borrow(sub));
+}
+
+int Count(const Cord& str, const Searcher& sub) {
+  if (str.empty() || sub.empty()) {
+    return 0;
+  }
+
+  int count = 0;
+  _ForEachMatch(str, sub, [&count](size_t) {
+    count++;
+    return true;
+  });
+
+  return count;
+}
+
+bool In(const Cord& str, std::string_view needle) {
+  if (needle.empty()) {
+    return false;
+  }
+
+  return In(str, Searcher::Borrow(needle));
+}
+
+bool In(const Cord& str, const Searcher& needle) {
+  if (needle.empty()) {
+    return false;
+  }
+
+  bool found = false;
+  _ForEachMatch(str, needle, [&found](size_t) {
+    found = true;
+    return false;
+  });
+
+  return found;
+}
+
+std::vector<Cord> Split(const Cord& str, std::string_view sep,
+                        bool collapse_empty_groups, int maxsplit) {
+  const internal::CharSet seps(sep);
+  std::vector<Cord> pieces;
+  int n_splits = 0;
+  size_t start = 0, chunk_start = 0;
+
+  // The same as internal::SplitWith, but the separators are found a chunk at a
+  // time and each piece is a slice of `str`.
+  auto add_pieces = [&](std::string_view chunk) {
+    size_t sep_pos = internal::FindFirstOf(chunk, seps);
+    while (sep_pos != std::string::npos) {
+      size_t pos = chunk_start + sep_pos;
+      if (pos > start) {
+        pieces.push_back(str.Substr(start, pos - start));
+        n_splits++;
+      } else if (!collapse_empty_groups) {
+        pieces.emplace_back();
+        n_splits++;
+      }
+
+      start = pos + 1;
+      if (maxsplit >= 0 && n_splits >= maxsplit) {
+        return false;
+      }
+
+      sep_pos = internal::FindFirstOf(chunk, seps, sep_pos + 1);
+    }
+
+    chunk_start += chunk.size();
+    return true;
+  };
+
+  for (std::string_view chunk : str.Chunks()) {
+    if (!add_pieces(chunk)) {
+      break;
+    }
+  }
+
+  if (start < str.size() || !collapse_empty_groups) {
+    pieces.push_back(str.Substr(start));
+  }
+
+  return pieces;
+}
+
+}  // namespace string
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "constants.h"
+#include "search.h"
+
+namespace string {
+
+// Internal; don't use directly.
+namespace internal {
+
+struct CordNode;
+
+}  // namespace internal
+
+/**
+ * @brief      A string stored as a balanced tree of shared, immutable chunks.
+ *
+ * @details    Concatenating, slicing and inserting into a Cord take O(log n)
+ *             time, however long the strings involved are, because chunks are
+ *             shared between Cords instead of being copied. This makes Cords
+ *             a good fit for building large values out of many pieces:
+ *
+ *                 Cord body;
+ *                 for (const auto& row : rows) {
+ *                   body.Append(FormatMap("{name}: {value}\n", row));
+ *                 }
+ *
+ *                 body = Replace(body, "\n", "\r\n");
+ *                 for (std::string_view chunk : body.Chunks()) { ... }
+ *
+ *             The tree is kept height balanced (as an AVL tree), and small
+ *             views are copied into the last chunk as they are appended, so
+ *             that building a Cord a few bytes at a time doesn't leave it with
+ *             a chunk per append.
+ *
+ *             Cords are values; copying one is O(1), and modifying a copy never
+ *             affects the original. Slices keep the whole of the chunks they
+ *             refer to alive.
+ *
+ * @see        Replace(const Cord&, const Searcher&, std::string_view, int)
+ * @see        Split(const Cord&, std::string_view, bool, int)
+ */
+class Cord {
+ public:
+  /**
+   * @brief      Create an empty Cord.
+   */
+  Cord() = default;
+
+  /**
+   * @brief      Create a Cord holding a copy of `str`.
+   */
+  explicit Cord(std::string_view str);
+  explicit Cord(const char* str) : Cord(std::string_view(str)) {}
+
+  /**
+   * @brief      Create a Cord which takes ownership of `str`'s buffer, without
+   *             copying it.
+   */
+  explicit Cord(std::string&& str);
+
+  /**
+   * @brief      Get the length of the Cord, in bytes.
+   */
+  size_t size() const;
+
+  bool empty() const { return size() == 0; }
+
+  /**
+   * @brief      Get the height of the tree, which is 0 for a Cord with at
+   *             most one chunk, and O(log n) for a Cord with n chunks.
+   */
+  int depth() const;
+
+  /**
+   * @brief      Get the byte at position `i`, in O(log n) time.
+   *
+   * @details    Like std::string, `i` isn't checked; it must be less than
+   *             size(), so calling this on an empty Cord is undefined.
+   */
+  char operator[](size_t i) const;
+
+  /**
+   * @brief      Append to the end of the Cord.
+   *
+   * @details    Appending a Cord or adopting a std::string doesn't copy any
+   *             data. Appending a view copies it, but small appends are merged
+   *             into the last chunk where possible.
+   *
+   * @param[in]  other  The data to append.
+   */
+  void Append(const Cord& other);
+  void Append(std::string_view str);
+  void Append(std::string&& str);
+  void Append(const char* str) { Append(std::string_view(str)); }
+
+  /**
+   * @brief      Add `other` to the start of the Cord.
+   */
+  void Prepend(const Cord& other);
+
+  /**
+   * @brief      Insert `other` so that it starts at position `pos`.
+   *
+   * @param[in]  pos    The position to insert at.
+   * @param[in]  other  The Cord to insert.
+   *
+   * @throws     std::out_of_range Thrown if `pos > size()`.
+   */
+  void Insert(size_t pos, const Cord& other);
+
+  /**
+   * @brief      Get part of the Cord, without copying any data.
+   *
+   * @param[in]  pos   The position of the first byte to include.
+   * @param[in]  n     The maximum number of bytes to include.
+   *
+   * @return     The bytes in [pos, pos + n), or up to the end of the Cord.
+   *
+   * @throws     std::out_of_range Thrown if `pos > size()`.
+   */
+  Cord Substr(size_t pos, size_t n = std::string::npos) const;
+
+  /**
+   * @brief      Get views of each of the Cord's chunks, in order.
+   *
+   * @details    The views are valid as long as the Cord (or any Cord sharing
+   *             its chunks) is. This is suitable for building an iovec array
+   *             for writev.
+   */
+  std::vector<std::string_view> Chunks() const;
+
+  /**
+   * @brief      Copy the whole Cord into a single string.
+   */
+  std::string ToString() const;
+
+  friend bool operator==(const Cord& a, const Cord& b);
+  friend bool operator==(const Cord& a, std::string_view b);
+  friend bool operator!=(const Cord& a, const Cord& b) { return !(a == b); }
+  friend bool operator!=(const Cord& a, std::string_view b) {
+    return !(a == b);
+  }
+
+ private:
+  using NodePtr = std::shared_ptr<const internal::CordNode>;
+
+  explicit Cord(NodePtr root) : root_(std::move(root)) {}
+
+  NodePtr root_;
+};
+
+/**
+ * @brief      Replace occurrences of `old` in a Cord.
+ *
+ * @details    Matches are found chunk by chunk, including matches which span
+ *             chunk boundaries, and the result shares all of the unchanged
+ *             data with `str`, so the Cord is never flattened.
+ *
+ * @param[in]  str          The Cord to search.
+ * @param[in]  old          The string to replace.
+ * @param[in]  replacement  The string to replace it with.
+ * @param[in]  count        The maximum number of replacements to make. Set to
+ *                          -1 for unlimited.
+ *
+ * @return     A Cord with the replacements made.
+ * @see        Replace(std::string_view, std::string_view, std::string_view,
+ *             int)
+ */
+Cord Replace(const Cord& str, std::string_view old,
+             std::string_view replacement, int count = -1);
+
+/**
+ * @brief      Same as Replace, but with a precompiled needle.
+ */
+Cord Replace(const Cord& str, const Searcher& old, std::string_view replacement,
+             int count = -1);
+
+/**
+ * @brief      Count the number of non-overlapping occurrences of `sub` in a
+ *             Cord, without flattening it.
+ * @see        Count(std::string_view, std::string_view)
+ */
+int Count(const Cord& str, std::string_view sub);
+int Count(const Cord& str, const Searcher& sub);
+
+/**
+ * @brief      Check whether a Cord contains `needle`, without flattening it.
+ * @see        In(std::string_view, std::string_view)
+ */
+bool In(const Cord& str, std::string_view needle);
+bool In(const Cord& str, const Searcher& needle);
+
+/**
+ * @brief      Split a Cord into components based on a list of separators.
+ *
+ * @details    The same as Split, except that each piece is a slice of `str`
+ *             which shares its chunks, rather than a copy.
+ *
+ * @param[in]  str                     The Cord to split.
+ * @param[in]  sep                     The separators to split by.
+ * @param[in]  collapse_empty_groups   When true, collapse adjacent delimiters
+ *                                     into a single delimiter.
+ * @param[in]  maxsplit                The maximum number of splits to perform.
+ *                                     Set to -1 for unlimited.
+ *
+ * @return     A vector of Cords, which are the parts of `str`.
+ * @see        Split(const std::string&, std::string_view, bool, int)
+ */
+std::vector<Cord> Split(const Cord& str, std::string_view sep = kWhitespace,
+                        bool collapse_empty_groups = false, int maxsplit = -1);
+
+}  // namespace string
@@ -0,0 +1,208 @@
+#include "cord.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "split.h"
+#include "util.h"
+
+namespace {
+
+// Build a Cord out of chunks of 1 to 8 bytes, so that needles often span
+// chunk boundaries.
+string::Cord MakeChunkedCord(const std::string& str) {
+  string::Cord cord;
+  size_t pos = 0;
+  while (pos < str.size()) {
+    size_t n = 1 + rand() % 8;
+    cord.Append(string::Cord(str.substr(pos, n)));
+    pos += n;
+  }
+
+  return cord;
+}
+
+}  // namespace
+
+TEST(TestCord, TestBasics) {
+  string::Cord empty;
+  ASSERT_TRUE(empty.empty());
+  ASSERT_EQ("", empty.ToString());
+  ASSERT_TRUE(empty.Chunks().empty());
+
+  string::Cord cord("hello");
+  cord.Append(", ");
+  cord.Append(string::Cord("world"));
+  cord.Prepend(string::Cord(">> "));
+  ASSERT_EQ(">> hello, world", cord.ToString());
+  ASSERT_EQ(cord, ">> hello, world");
+  ASSERT_NE(cord, ">> hello, world!");
+  ASSERT_EQ('h', cord[3]);
+  ASSERT_EQ(15, cord.size());
+}
+
+TEST(TestCord, TestAdoptsStringsWithoutCopying) {
+  std::string big(10000, 'x');
+  const char* data = big.data();
+  string::Cord cord(std::move(big));
+  cord.Append(std::string(10000, 'y'));
+  ASSERT_EQ(2, cord.Chunks().size());
+  ASSERT_EQ(data, cord.Chunks()[0].data());
+
+  // Slices share the chunk too.
+  ASSERT_EQ(data + 10, cord.Substr(10, 20).Chunks()[0].data());
+}
+
+TEST(TestCord, TestSmallAppendsAreMerged) {
+  string::Cord cord;
+  for (int i = 0; i < 1000; i++) {
+    cord.Append("ab");
+  }
+
+  ASSERT_EQ(2000, cord.size());
+  ASSERT_LE(cord.Chunks().size(), 4);
+  ASSERT_EQ(std::string(2000 / 2, 'a'), string::Replace(cord.ToString(), "b",
+                                                        ""));
+}
+
+TEST(TestCord, TestStaysBalanced) {
+  string::Cord cord;
+  std::string expected;
+  for (int i = 0; i < 4096; i++) {
+    std::string chunk(1000, 'a' + i % 26);
+    expected += chunk;
+    if (i % 2 == 0) {
+      cord.Append(std::move(chunk));
+    } else {
+      cord.Insert(cord.size() / 2, string::Cord(chunk));
+      expected.erase(expected.size() - chunk.size());
+      expected.insert(expected.size() / 2, chunk);
+    }
+  }
+
+  // An AVL tree with n leaves is at most about 1.44 * log2(n) high.
+  ASSERT_LE(cord.depth(), 18);
+  ASSERT_EQ(expected, cord.ToString());
+}
+
+TEST(TestCord, TestSubstrAndInsertMatchString) {
+  srand(1);
+  string::Cord cord;
+  std::string expected;
+  for (int i = 0; i < 2000; i++) {
+    size_t pos = rand() % (expected.size() + 1);
+    switch (rand() % 3) {
+      case 0: {
+        std::string chunk(rand() % 700, 'a' + rand() % 26);
+        cord.Insert(pos, string::Cord(chunk));
+        expected.insert(pos, chunk);
+        break;
+      }
+
+      case 1: {
+        size_t n = rand() % 1000;
+        ASSERT_EQ(expected.substr(pos, n), cord.Substr(pos, n).ToString());
+        break;
+      }
+
+      case 2: {
+        // Move a slice to the front.
+        size_t n = rand() % 1000;
+        string::Cord slice = cord.Substr(pos, n);
+        slice.Append(cord);
+        cord = slice.Substr(0, expected.size());
+        expected = (expected.substr(pos, n) + expected)
+                       .substr(0, expected.size());
+        break;
+      }
+    }
+
+    ASSERT_EQ(expected.size(), cord.size());
+  }
+
+  ASSERT_EQ(expected, cord.ToString());
+  ASSERT_THROW(cord.Substr(cord.size() + 1), std::out_of_range);
+  ASSERT_THROW(cord.Insert(cord.size() + 1, cord), std::out_of_range);
+}
+
+TEST(TestCord, TestEquality) {
+  string::Cord a("hello world");
+  string::Cord b("hello");
+  b.Append(string::Cord(std::string(" world")));
+  ASSERT_EQ(a, b);
+  ASSERT_NE(a, string::Cord("hello World"));
+  ASSERT_NE(a, string::Cord("hello"));
+}
+
+TEST(TestCordSearch, TestMatchesSpanningChunks) {
+  srand(2);
+  const std::vector<std::string> needles = {"a", "ab", "aba", "abcab",
+                                            "bbbbbbbbbbbb"};
+  for (int i = 0; i < 300; i++) {
+    std::string str;
+    int n = rand() % 200;
+    for (int j = 0; j < n; j++) {
+      str += "abc"[rand() % 3];
+    }
+
+    string::Cord cord = MakeChunkedCord(str);
+    ASSERT_EQ(str, cord.ToString());
+    ASSERT_GE(cord.Chunks().size(), str.size() / 8);
+    for (const auto& needle : needles) {
+      ASSERT_EQ(string::Count(str, needle), string::Count(cord, needle))
+          << str << " " << needle;
+      ASSERT_EQ(string::In(str, needle), string::In(cord, needle));
+      ASSERT_EQ(string::Replace(str, needle, "XY"),
+                string::Replace(cord, needle, "XY").ToString());
+      ASSERT_EQ(string::Replace(str, needle, "", 2),
+                string::Replace(cord, needle, "", 2).ToString());
+    }
+
+    string::Searcher upper("AB", true);
+    ASSERT_EQ(string::Count(str, upper), string::Count(cord, upper));
+  }
+}
+
+TEST(TestCordSearch, TestEmptyNeedle) {
+  string::Cord cord("abc");
+  ASSERT_EQ(0, string::Count(cord, ""));
+  ASSERT_FALSE(string::In(cord, ""));
+  ASSERT_EQ("-a-b-c-", string::Replace(cord, "", "-").ToString());
+}
+
+TEST(TestCordSearch, TestReplaceSharesChunks) {
+  std::string big(100000, 'x');
+  const char* data = big.data();
+  string::Cord cord(std::move(big));
+  cord.Append(string::Cord(std::string(100000, 'y')));
+
+  string::Cord replaced = string::Replace(cord, "xy", "-");
+  ASSERT_EQ(199999, replaced.size());
+  ASSERT_EQ(data, replaced.Chunks()[0].data());
+}
+
+TEST(TestCordSplit, TestMatchesSplit) {
+  srand(3);
+  for (int i = 0; i < 300; i++) {
+    std::string str;
+    int n = rand() % 100;
+    for (int j = 0; j < n; j++) {
+      str += "ab,;"[rand() % 4];
+    }
+
+    string::Cord cord = MakeChunkedCord(str);
+    for (bool collapse : {false, true}) {
+      for (int maxsplit : {-1, 0, 1, 3}) {
+        auto expected = string::Split(str, ",;", collapse, maxsplit);
+        auto pieces = string::Split(cord, ",;", collapse, maxsplit);
+        ASSERT_EQ(expected.size(), pieces.size()) << str;
+        for (size_t k = 0; k < pieces.size(); k++) {
+          ASSERT_EQ(expected[k], pieces[k].ToString());
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,263 @@
+#include "distance.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace string {
+
+namespace {
+
+constexpr size_t kWordBits = 64;
+
+// Advance one block of a column by one character of the text. `pv` and `mv`
+// hold the positive and negative vertical deltas of the block, `eq` has a bit
+// set for each row of the block whose pattern character matches the text
+// character, and `hin` is the horizontal delta coming into the top of the
+// block. Returns the horizontal delta coming out of the row selected by `out`.
+inline int _AdvanceBlock(uint64_t& pv, uint64_t& mv, uint64_t eq, int hin,
+                         uint64_t out) {
+  uint64_t hin_neg = hin < 0 ? 1 : 0;
+  uint64_t xv = eq | mv;
+  eq |= hin_neg;
+  uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+  uint64_t ph = mv | ~(xh | pv);
+  uint64_t mh = pv & xh;
+
+  int hout = (ph & out) ? 1 : ((mh & out) ? -1 : 0);
+
+  ph = (ph << 1) | (hin > 0 ? 1 : 0);
+  mh = (mh << 1) | hin_neg;
+  pv = mh | ~(xv | ph);
+  mv = ph & xv;
+  return hout;
+}
+
+// The minimum number of edits needed to make the character counts of two
+// strings equal, which is a lower bound on their edit distance. `counts` holds
+// the character counts of the first string.
+size_t _CountDistance(const int32_t* counts, size_t size, std::string_view b) {
+  int32_t remaining[256];
+  std::copy(counts, counts + 256, remaining);
+
+  size_t common = 0;
+  for (char c : b) {
+    auto u = static_cast<unsigned char>(c);
+    if (remaining[u] > 0) {
+      remaining[u]--;
+      common++;
+    }
+  }
+
+  return std::max(size, b.size()) - common;
+}
+
+struct _MatchLess {
+  bool operator()(const EditMatch& a, const EditMatch& b) const {
+    return a.distance != b.distance ? a.distance < b.distance
+                                    : a.candidate < b.candidate;
+  }
+};
+
+// Find the best `k` matches among candidates [first, last), as a max-heap
+// ordered by _MatchLess.
+std::vector<EditMatch> _ClosestMatchesIn(
+    const internal::EditPattern& pattern, const int32_t* counts,
+    std::string_view query, const std::vector<std::string>& candidates,
+    size_t first, size_t last, size_t k, size_t max_distance) {
+  std::vector<EditMatch> best;
+  best.reserve(k + 1);
+
+  size_t bound = max_distance;
+  for (size_t i = first; i < last; i++) {
+    const std::string& candidate = candidates[i];
+    size_t length_diff = candidate.size() > query.size()
+                             ? candidate.size() - query.size()
+                             : query.size() - candidate.size();
+    if (length_diff > bound ||
+        _CountDistance(counts, query.size(), candidate) > bound) {
+      continue;
+    }
+
+    size_t distance = pattern.Distance(candidate, bound);
+    if (distance > bound) {
+      continue;
+    }
+
+    // Later candidates always lose ties, so once the heap is full, only
+    // strictly closer candidates can get in.
+    best.push_back({i, distance});
+    std::push_heap(best.begin(), best.end(), _MatchLess());
+    if (best.size() > k) {
+      std::pop_heap(best.begin(), best.end(), _MatchLess());
+      best.pop_back();
+    }
+
+    if (best.size() == k) {
+      if (best.front().distance == 0) {
+        break;
+      }
+
+      bound = best.front().distance - 1;
+    }
+  }
+
+  return best;
+}
+
+}  // namespace
+
+namespace internal {
+
+EditPattern::EditPattern(std::string_view pattern)
+    : size_(pattern.size()),
+      n_blocks_((pattern.size() + kWordBits - 1) / kWordBits),
+      peq_(256 * n_blocks_, 0) {
+  for (size_t i = 0; i < pattern.size(); i++) {
+    auto c = static_cast<unsigned char>(pattern[i]);
+    peq_[c * n_blocks_ + i / kWordBits] |= uint64_t{1} << (i % kWordBits);
+  }
+}
+
+size_t EditPattern::Distance(std::string_view text,
+                             size_t max_distance) const {
+  size_t m = size_;
+  size_t n = text.size();
+
+  // The distance is never more than the longer length, so this doesn't change
+  // the result, but keeps the arithmetic below from overflowing.
+  max_distance = std::min(max_distance, std::max(m, n));
+  if ((m > n ? m - n : n - m) > max_distance) {
+    return max_distance + 1;
+  }
+
+  if (m == 0) {
+    return n;
+  }
+
+  const uint64_t kLastRow = uint64_t{1} << ((m - 1) % kWordBits);
+  const uint64_t kHighRow = uint64_t{1} << (kWordBits - 1);
+
+  if (n_blocks_ == 1) {
+    uint64_t pv = ~uint64_t{0};
+    uint64_t mv = 0;
+    size_t score = m;
+    for (size_t j = 0; j < n; j++) {
+      auto c = static_cast<unsigned char>(text[j]);
+      score += _AdvanceBlock(pv, mv, peq_[c], 1, kLastRow);
+
+      // Each remaining character can lower the score by at most 1, and every
+      // cell in this column is at least score - (m - 1) (or j + 1, in row 0).
+      size_t remaining = n - j - 1;
+      if (score > max_distance + remaining ||
+          (j + 1 > max_distance && score > max_distance + m - 1)) {
+        return max_distance + 1;
+      }
+    }
+
+    return score;
+  }
+
+  // scores[b] is the value of the cell at the bottom of block b.
+  std::vector<uint64_t> pv(n_blocks_, ~uint64_t{0});
+  std::vector<uint64_t> mv(n_blocks_, 0);
+  std::vector<size_t> scores(n_blocks_);
+  for (size_t b = 0; b < n_blocks_; b++) {
+    scores[b] = std::min(m, (b + 1) * kWordBits);
+  }
+
+  for (size_t j = 0; j < n; j++) {
+    const uint64_t* eq =
+        &peq_[static_cast<unsigned char>(text[j]) * n_blocks_];
+
+    // The top row of the matrix goes up by 1 for every character. Cells in
+    // block b are at least scores[b] - 63, so if all of those and the top row
+    // are beyond max_distance then so is the result.
+    int hin = 1;
+    bool all_beyond = j + 1 > max_distance;
+    for (size_t b = 0; b < n_blocks_; b++) {
+      bool last = b == n_blocks_ - 1;
+      hin = _AdvanceBlock(pv[b], mv[b], eq[b], hin, last ? kLastRow : kHighRow);
+      scores[b] += hin;
+
+      size_t rows = last ? m - b * kWordBits : kWordBits;
+      all_beyond = all_beyond && scores[b] > max_distance + rows - 1;
+    }
+
+    if (all_beyond || scores.back() > max_distance + (n - j - 1)) {
+      return max_distance + 1;
+    }
+  }
+
+  return scores.back();
+}
+
+}  // namespace internal
+
+size_t EditDistance(std::string_view a, std::string_view b) {
+  return BoundedEditDistance(a, b, std::max(a.size(), b.size()));
+}
+
+size_t BoundedEditDistance(std::string_view a, std::string_view b,
+                           size_t max_distance) {
+  // The shorter string needs fewer blocks as the pattern.
+  if (a.size() > b.size()) {
+    std::swap(a, b);
+  }
+
+  return internal::EditPattern(a).Distance(b, max_distance);
+}
+
+std::vector<EditMatch> ClosestMatches(
+    std::string_view query, const std::vector<std::string>& candidates,
+    size_t k, size_t max_distance, unsigned n_threads) {
+  if (k == 0 || candidates.empty()) {
+    return {};
+  }
+
+  internal::EditPattern pattern(query);
+  int32_t counts[256] = {0};
+  for (char c : query) {
+    counts[static_cast<unsigned char>(c)]++;
+  }
+
+  if (n_threads == 0) {
+    n_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  n_threads = std::min<size_t>(n_threads, candidates.size());
+  size_t chunk = (candidates.size() + n_threads - 1) / n_threads;
+
+  // Each thread finds the best k matches in its own chunk, and then those are
+  // merged.
+  std::vector<std::vector<EditMatch>> results(n_threads);
+  auto search = [&](unsigned t) {
+    size_t first = t * chunk;
+    size_t last = std::min(candidates.size(), first + chunk);
+    results[t] = _ClosestMatchesIn(pattern, counts, query, candidates, first,
+                                   last, k, max_distance);
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned t = 1; t < n_threads; t++) {
+    threads.emplace_back(search, t);
+  }
+
+  search(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::vector<EditMatch> matches;
+  for (const auto& result : results) {
+    matches.insert(matches.end(), result.begin(), result.end());
+  }
+
+  std::sort(matches.begin(), matches.end(), _MatchLess());
+  if (matches.size() > k) {
+    matches.resize(k);
+  }
+
+  return matches;
+}
+
+}  // namespace string
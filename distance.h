@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace string {
+
+// Internal; don't use directly.
+namespace internal {
+
+// A string preprocessed for Myers' bit-parallel edit distance algorithm, as
+// extended to patterns longer than a machine word by Hyyrö. Each column of the
+// dynamic programming matrix is stored as bit vectors of the vertical deltas
+// between adjacent cells, in blocks of 64 rows, and a whole block is updated
+// with a handful of word operations.
+class EditPattern {
+ public:
+  explicit EditPattern(std::string_view pattern);
+
+  // Get the edit distance between the pattern and `text`, or
+  // `max_distance + 1` if it is larger than `max_distance`.
+  size_t Distance(std::string_view text, size_t max_distance) const;
+
+  size_t size() const { return size_; }
+
+ private:
+  size_t size_;
+  size_t n_blocks_;
+
+  // Bit i of peq_[c * n_blocks_ + b] is set iff pattern[64 * b + i] == c.
+  std::vector<uint64_t> peq_;
+};
+
+}  // namespace internal
+
+/**
+ * A candidate which is close to a query string.
+ * @see        ClosestMatches
+ */
+struct EditMatch {
+  // The index of the candidate.
+  size_t candidate;
+
+  // The edit distance between the query and the candidate.
+  size_t distance;
+};
+
+/**
+ * @brief      Get the edit (Levenshtein) distance between two strings.
+ *
+ * @details    This is the number of single byte insertions, deletions and
+ *             substitutions needed to turn `a` into `b`. For example:
+ *
+ *                 EditDistance("kitten", "sitting") -> 3
+ *
+ *             This uses Myers' bit-parallel algorithm, which takes
+ *             O(ceil(m / 64) * n) time for strings of length m <= n.
+ *
+ * @param[in]  a     The first string.
+ * @param[in]  b     The second string.
+ *
+ * @return     The edit distance between `a` and `b`.
+ * @see        BoundedEditDistance
+ */
+size_t EditDistance(std::string_view a, std::string_view b);
+
+/**
+ * @brief      Get the edit distance between two strings, if it is at most
+ *             `max_distance`.
+ *
+ * @details    This gives up as soon as the distance is known to be larger than
+ *             `max_distance`, which is much faster than EditDistance when most
+ *             strings are far apart. For example:
+ *
+ *                 BoundedEditDistance("kitten", "sitting", 2) -> 3
+ *                 BoundedEditDistance("kitten", "mitten", 2) -> 1
+ *
+ * @param[in]  a             The first string.
+ * @param[in]  b             The second string.
+ * @param[in]  max_distance  The largest distance of interest.
+ *
+ * @return     The edit distance between `a` and `b`, or `max_distance + 1` if
+ *             it is larger than `max_distance`.
+ * @see        EditDistance
+ */
+size_t BoundedEditDistance(std::string_view a, std::string_view b,
+                           size_t max_distance);
+
+/**
+ * @brief      Find the candidates with the smallest edit distance to `query`.
+ *
+ * @details    Candidates are first filtered by the difference in their length
+ *             and in their character counts, both of which give a lower bound
+ *             on the edit distance, and then by BoundedEditDistance. The bound
+ *             shrinks as better candidates are found. For example:
+ *
+ *                 ClosestMatches("--vrebose", {"--verbose", "--version",
+ *                                "--quiet"}, 2, 3) -> {{0, 2}}
+ *
+ *             Ties are broken by candidate index, so the result doesn't depend
+ *             on the number of threads.
+ *
+ * @param[in]  query         The string to match.
+ * @param[in]  candidates    The strings to match against.
+ * @param[in]  k             The maximum number of matches to return.
+ * @param[in]  max_distance  The largest distance to return a match for.
+ * @param[in]  n_threads     The number of threads to search with. If 0, one
+ *                           thread per hardware thread is used.
+ *
+ * @return     Up to `k` matches, sorted by distance and then by index.
+ */
+std::vector<EditMatch> ClosestMatches(
+    std::string_view query, const std::vector<std::string>& candidates,
+    size_t k, size_t max_distance, unsigned n_threads = 1);
+
+}  // namespace string
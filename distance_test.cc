@@ -0,0 +1,148 @@
+#include "distance.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+size_t NaiveEditDistance(const std::string& a, const std::string& b) {
+  std::vector<size_t> row(b.size() + 1);
+  for (size_t j = 0; j <= b.size(); j++) {
+    row[j] = j;
+  }
+
+  for (size_t i = 1; i <= a.size(); i++) {
+    size_t diagonal = row[0];
+    row[0] = i;
+    for (size_t j = 1; j <= b.size(); j++) {
+      size_t up = row[j];
+      row[j] = std::min({row[j] + 1, row[j - 1] + 1,
+                         diagonal + (a[i - 1] == b[j - 1] ? 0 : 1)});
+      diagonal = up;
+    }
+  }
+
+  return row[b.size()];
+}
+
+std::string RandomString(size_t length, int alphabet) {
+  std::string str;
+  for (size_t i = 0; i < length; i++) {
+    str += static_cast<char>('a' + rand() % alphabet);
+  }
+
+  return str;
+}
+
+}  // namespace
+
+TEST(TestEditDistance, TestSimpleCases) {
+  ASSERT_EQ(3, string::EditDistance("kitten", "sitting"));
+  ASSERT_EQ(0, string::EditDistance("same", "same"));
+  ASSERT_EQ(4, string::EditDistance("", "abcd"));
+  ASSERT_EQ(4, string::EditDistance("abcd", ""));
+  ASSERT_EQ(0, string::EditDistance("", ""));
+  ASSERT_EQ(1, string::EditDistance("flaw", "flow"));
+}
+
+TEST(TestEditDistance, TestAgainstNaiveImplementation) {
+  srand(1);
+  for (int i = 0; i < 2000; i++) {
+    // Cover single blocks, several blocks, and exact multiples of 64.
+    size_t lengths[] = {0, 1, 7, 63, 64, 65, 128, 150, 300};
+    std::string a = RandomString(lengths[rand() % 9] + rand() % 3, 4);
+    std::string b = RandomString(lengths[rand() % 9] + rand() % 3, 4);
+    ASSERT_EQ(NaiveEditDistance(a, b), string::EditDistance(a, b))
+        << a << " " << b;
+  }
+}
+
+TEST(TestEditDistance, TestSimilarLongStrings) {
+  srand(2);
+  for (int i = 0; i < 200; i++) {
+    std::string a = RandomString(200 + rand() % 100, 26);
+    std::string b = a;
+    for (int edits = rand() % 10; edits > 0; edits--) {
+      size_t pos = rand() % (b.size() + 1);
+      switch (rand() % 3) {
+        case 0:
+          b.insert(pos, 1, 'x');
+          break;
+        case 1:
+          b.erase(std::min(pos, b.size() - 1), 1);
+          break;
+        default:
+          b[std::min(pos, b.size() - 1)] = 'y';
+      }
+    }
+
+    ASSERT_EQ(NaiveEditDistance(a, b), string::EditDistance(a, b));
+  }
+}
+
+TEST(TestBoundedEditDistance, TestReturnsMaxPlusOneWhenTooFar) {
+  ASSERT_EQ(3, string::BoundedEditDistance("kitten", "sitting", 2));
+  ASSERT_EQ(1, string::BoundedEditDistance("kitten", "mitten", 2));
+  ASSERT_EQ(1, string::BoundedEditDistance("a", "abcdefgh", 0));
+  ASSERT_EQ(8, string::BoundedEditDistance("", "abcdefgh", SIZE_MAX));
+}
+
+TEST(TestBoundedEditDistance, TestAgainstNaiveImplementation) {
+  srand(3);
+  for (int i = 0; i < 3000; i++) {
+    std::string a = RandomString(rand() % 200, 3);
+    std::string b = RandomString(rand() % 200, 3);
+    size_t max_distance = rand() % 120;
+    size_t expected = std::min(NaiveEditDistance(a, b), max_distance + 1);
+    ASSERT_EQ(expected, string::BoundedEditDistance(a, b, max_distance));
+  }
+}
+
+TEST(TestClosestMatches, TestFindsClosestCandidates) {
+  std::vector<std::string> flags = {"--verbose", "--version", "--quiet",
+                                    "--verbosity"};
+  auto matches = string::ClosestMatches("--vrebose", flags, 2, 3);
+  ASSERT_EQ(1, matches.size());
+  ASSERT_EQ(0, matches[0].candidate);
+  ASSERT_EQ(2, matches[0].distance);
+
+  ASSERT_TRUE(string::ClosestMatches("--vrebose", flags, 0, 3).empty());
+  ASSERT_TRUE(string::ClosestMatches("--vrebose", {}, 2, 3).empty());
+}
+
+TEST(TestClosestMatches, TestAgainstBruteForce) {
+  srand(4);
+  std::vector<std::string> candidates;
+  for (int i = 0; i < 3000; i++) {
+    candidates.push_back(RandomString(rand() % 20, 4));
+  }
+
+  for (int i = 0; i < 20; i++) {
+    std::string query = RandomString(rand() % 20, 4);
+    size_t k = 1 + rand() % 10;
+    size_t max_distance = rand() % 8;
+
+    std::vector<std::pair<size_t, size_t>> expected;
+    for (size_t c = 0; c < candidates.size(); c++) {
+      size_t distance = NaiveEditDistance(query, candidates[c]);
+      if (distance <= max_distance) {
+        expected.emplace_back(distance, c);
+      }
+    }
+
+    std::sort(expected.begin(), expected.end());
+    expected.resize(std::min(expected.size(), k));
+
+    for (unsigned n_threads : {1u, 4u, 0u}) {
+      auto matches =
+          string::ClosestMatches(query, candidates, k, max_distance, n_threads);
+      ASSERT_EQ(expected.size(), matches.size());
+      for (size_t m = 0; m < matches.size(); m++) {
+        ASSERT_EQ(expected[m].first, matches[m].distance);
+        ASSERT_EQ(expected[m].second, matches[m].candidate);
+      }
+    }
+  }
+}
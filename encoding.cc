@@ -0,0 +1,539 @@
+#include "encoding.h"
+
+#include <cstdint>
+
+#include <string.h>
+
+#include "constants.h"
+#include "simd.h"
+
+namespace string {
+
+namespace {
+
+// The value of each character in an alphabet, or -1 for characters which
+// aren't in it.
+struct _DecodeTable {
+  int8_t values[256];
+};
+
+constexpr _DecodeTable _MakeHexTable() {
+  _DecodeTable table = {};
+  for (int c = 0; c < 256; c++) {
+    table.values[c] = -1;
+  }
+
+  for (int i = 0; i < 16; i++) {
+    table.values[static_cast<unsigned char>(kHexDigits[i])] = i;
+  }
+
+  for (int i = 10; i < 16; i++) {
+    table.values[static_cast<unsigned char>(kHexDigits[i + 6])] = i;
+  }
+
+  return table;
+}
+
+constexpr _DecodeTable _MakeBase64Table(std::string_view chars) {
+  _DecodeTable table = {};
+  for (int c = 0; c < 256; c++) {
+    table.values[c] = -1;
+  }
+
+  for (int i = 0; i < 64; i++) {
+    table.values[static_cast<unsigned char>(chars[i])] = i;
+  }
+
+  return table;
+}
+
+constexpr _DecodeTable kHexTable = _MakeHexTable();
+
+constexpr std::string_view kBase64Standard =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+constexpr std::string_view kBase64UrlSafe =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+constexpr _DecodeTable kBase64StandardTable = _MakeBase64Table(kBase64Standard);
+constexpr _DecodeTable kBase64UrlSafeTable = _MakeBase64Table(kBase64UrlSafe);
+
+std::string_view _Base64Chars(Base64Alphabet alphabet) {
+  return alphabet == Base64Alphabet::kUrlSafe ? kBase64UrlSafe
+                                              : kBase64Standard;
+}
+
+const _DecodeTable& _Base64Table(Base64Alphabet alphabet) {
+  return alphabet == Base64Alphabet::kUrlSafe ? kBase64UrlSafeTable
+                                              : kBase64StandardTable;
+}
+
+// Each kernel below handles as much of its input as it can in whole blocks,
+// and returns how many input bytes it used. The rest is left to the scalar
+// code, which also finds the exact position of any error.
+
+void _HexEncodeScalar(const uint8_t* data, size_t n, char* out,
+                      const char* digits) {
+  for (size_t i = 0; i < n; i++) {
+    out[2 * i] = digits[data[i] >> 4];
+    out[2 * i + 1] = digits[data[i] & 0x0f];
+  }
+}
+
+bool _HexDecodeScalar(const char* hex, size_t n, uint8_t* out) {
+  for (size_t i = 0; i < n; i += 2) {
+    int hi = kHexTable.values[static_cast<unsigned char>(hex[i])];
+    int lo = kHexTable.values[static_cast<unsigned char>(hex[i + 1])];
+    if (hi < 0 || lo < 0) {
+      return false;
+    }
+
+    out[i / 2] = static_cast<uint8_t>(hi << 4 | lo);
+  }
+
+  return true;
+}
+
+#ifdef CPPSTRING_HAVE_SSE2
+
+// SSE2 has no byte shuffle to look the digits up with, so compute them as
+// `nibble + '0'`, plus the gap up to 'a' or 'A' for nibbles above 9.
+size_t _HexEncodeSse2(const uint8_t* data, size_t n, char* out,
+                      bool uppercase) {
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  const __m128i zero = _mm_set1_epi8('0');
+  const __m128i gap = _mm_set1_epi8(uppercase ? 'A' - '9' - 1 : 'a' - '9' - 1);
+  const __m128i nine = _mm_set1_epi8(9);
+
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+    __m128i lo = _mm_and_si128(v, mask);
+    hi = _mm_add_epi8(_mm_add_epi8(hi, zero),
+                      _mm_and_si128(_mm_cmpgt_epi8(hi, nine), gap));
+    lo = _mm_add_epi8(_mm_add_epi8(lo, zero),
+                      _mm_and_si128(_mm_cmpgt_epi8(lo, nine), gap));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i),
+                     _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 16),
+                     _mm_unpackhi_epi8(hi, lo));
+  }
+
+  return i;
+}
+
+size_t _HexDecodeSse2(const char* hex, size_t n, uint8_t* out) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hex + i));
+    __m128i digit = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+    __m128i letter = _mm_sub_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20)),
+                                  _mm_set1_epi8('a'));
+    __m128i is_digit = internal::AtMost128(digit, 9);
+    __m128i is_letter = internal::AtMost128(letter, 5);
+    if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) != 0xffff) {
+      break;
+    }
+
+    __m128i nibbles = _mm_or_si128(
+        _mm_and_si128(is_digit, digit),
+        _mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+
+    // Each 16-bit lane holds a high nibble in its low byte, and a low nibble
+    // in its high byte.
+    __m128i bytes = _mm_or_si128(
+        _mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00ff)), 4),
+        _mm_srli_epi16(nibbles, 8));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i / 2),
+                     _mm_packus_epi16(bytes, bytes));
+  }
+
+  return i;
+}
+
+#endif  // CPPSTRING_HAVE_SSE2
+
+#ifdef CPPSTRING_HAVE_AVX2_DISPATCH
+
+CPPSTRING_TARGET_AVX2 inline __m256i _InRange256(__m256i v, char lo,
+                                                 char width) {
+  return internal::AtMost256(_mm256_sub_epi8(v, _mm256_set1_epi8(lo)),
+                             width);
+}
+
+CPPSTRING_TARGET_AVX2 size_t _HexEncodeAvx2(const uint8_t* data, size_t n,
+                                            char* out, const char* digits) {
+  const __m256i lookup = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(digits)));
+  const __m256i mask = _mm256_set1_epi8(0x0f);
+
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    __m256i hi = _mm256_shuffle_epi8(
+        lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+    __m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, mask));
+
+    // Unpacking works within each 128-bit lane, so `first` holds the digits
+    // of bytes [0, 8) and [16, 24), and `second` those of [8, 16) and
+    // [24, 32).
+    __m256i first = _mm256_unpacklo_epi8(hi, lo);
+    __m256i second = _mm256_unpackhi_epi8(hi, lo);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i),
+                        _mm256_permute2x128_si256(first, second, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i + 32),
+                        _mm256_permute2x128_si256(first, second, 0x31));
+  }
+
+  return i;
+}
+
+CPPSTRING_TARGET_AVX2 size_t _HexDecodeAvx2(const char* hex, size_t n,
+                                            uint8_t* out) {
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hex + i));
+    __m256i digit = _mm256_sub_epi8(v, _mm256_set1_epi8('0'));
+    __m256i letter = _mm256_sub_epi8(
+        _mm256_or_si256(v, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    __m256i is_digit = internal::AtMost256(digit, 9);
+    __m256i is_letter = internal::AtMost256(letter, 5);
+    if (_mm256_movemask_epi8(_mm256_or_si256(is_digit, is_letter)) != -1) {
+      break;
+    }
+
+    __m256i nibbles = _mm256_or_si256(
+        _mm256_and_si256(is_digit, digit),
+        _mm256_and_si256(is_letter,
+                         _mm256_add_epi8(letter, _mm256_set1_epi8(10))));
+
+    // Multiply each high nibble by 16 and add its low nibble, then pack the
+    // 16-bit results of both lanes into the low 16 bytes.
+    __m256i bytes =
+        _mm256_maddubs_epi16(nibbles, _mm256_set1_epi16(0x0110));
+    __m256i packed = _mm256_permute4x64_epi64(
+        _mm256_packus_epi16(bytes, bytes), 0x08);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i / 2),
+                     _mm256_castsi256_si128(packed));
+  }
+
+  return i;
+}
+
+// Split each 3 bytes of a block of 24 into four 6-bit indices, and convert
+// them to characters. `data` must have 28 readable bytes.
+CPPSTRING_TARGET_AVX2 size_t _Base64EncodeAvx2(const uint8_t* data, size_t n,
+                                               char* out,
+                                               std::string_view chars) {
+  // Every index in [0, 26) gets 'A' added, every index in [26, 52) gets
+  // 'a' - 26, and so on. The indices are reduced to a position in this table
+  // below.
+  const __m256i offsets = _mm256_setr_epi8(
+      'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, '0' - 52, chars[62] - 62, chars[63] - 63,
+      'A', 0, 0, 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, chars[62] - 62,
+      chars[63] - 63, 'A', 0, 0);
+
+  // Put each group of 3 bytes into a 32-bit lane, in the order which lets the
+  // multiplies below shift each index into its own byte.
+  const __m256i spread = _mm256_setr_epi8(
+      1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10, 1, 0, 2, 1, 4, 3, 5,
+      4, 7, 6, 8, 7, 10, 9, 11, 10);
+
+  size_t i = 0, o = 0;
+  for (; i + 28 <= n; i += 24, o += 32) {
+    __m256i v = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 12)), 1);
+    v = _mm256_shuffle_epi8(v, spread);
+
+    __m256i ac = _mm256_mulhi_epu16(
+        _mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00)),
+        _mm256_set1_epi32(0x04000040));
+    __m256i bd = _mm256_mullo_epi16(
+        _mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0)),
+        _mm256_set1_epi32(0x01000010));
+    __m256i indices = _mm256_or_si256(ac, bd);
+
+    // [0, 52) -> 0, [52, 62) -> [1, 11), 62 -> 11, 63 -> 12, and then
+    // [0, 26) -> 13.
+    __m256i reduced =
+        _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+    __m256i is_upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+    reduced = _mm256_or_si256(
+        reduced, _mm256_and_si256(is_upper, _mm256_set1_epi8(13)));
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(out + o),
+        _mm256_add_epi8(indices, _mm256_shuffle_epi8(offsets, reduced)));
+  }
+
+  return i;
+}
+
+// Decode blocks of 32 characters into 24 bytes. `out` must have 32 writable
+// bytes for each block.
+CPPSTRING_TARGET_AVX2 size_t _Base64DecodeAvx2(const char* str, size_t n,
+                                               uint8_t* out,
+                                               std::string_view chars) {
+  const __m256i char62 = _mm256_set1_epi8(chars[62]);
+  const __m256i char63 = _mm256_set1_epi8(chars[63]);
+
+  size_t i = 0, o = 0;
+  for (; i + 32 <= n; i += 32, o += 24) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + i));
+    __m256i is_upper = _InRange256(v, 'A', 25);
+    __m256i is_lower = _InRange256(v, 'a', 25);
+    __m256i is_digit = _InRange256(v, '0', 9);
+    __m256i is_62 = _mm256_cmpeq_epi8(v, char62);
+    __m256i is_63 = _mm256_cmpeq_epi8(v, char63);
+    __m256i valid = _mm256_or_si256(
+        _mm256_or_si256(is_upper, is_lower),
+        _mm256_or_si256(is_digit, _mm256_or_si256(is_62, is_63)));
+    if (_mm256_movemask_epi8(valid) != -1) {
+      break;
+    }
+
+    __m256i offset = _mm256_or_si256(
+        _mm256_and_si256(is_upper, _mm256_set1_epi8(-'A')),
+        _mm256_and_si256(is_lower, _mm256_set1_epi8(26 - 'a')));
+    offset = _mm256_or_si256(
+        offset, _mm256_and_si256(is_digit, _mm256_set1_epi8(52 - '0')));
+    offset = _mm256_or_si256(
+        offset, _mm256_and_si256(is_62, _mm256_set1_epi8(62 - chars[62])));
+    offset = _mm256_or_si256(
+        offset, _mm256_and_si256(is_63, _mm256_set1_epi8(63 - chars[63])));
+    __m256i values = _mm256_add_epi8(v, offset);
+
+    // Merge each 4 indices into 24 bits in a 32-bit lane, put the bytes in
+    // order, and move the 24 used bytes to the front.
+    __m256i merged = _mm256_madd_epi16(
+        _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140)),
+        _mm256_set1_epi32(0x00011000));
+    merged = _mm256_shuffle_epi8(
+        merged, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1,
+                                 -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14,
+                                 13, 12, -1, -1, -1, -1));
+    merged = _mm256_permutevar8x32_epi32(
+        merged, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + o), merged);
+  }
+
+  return i;
+}
+
+#endif  // CPPSTRING_HAVE_AVX2_DISPATCH
+
+void _Base64EncodeScalar(const uint8_t* data, size_t n, char* out,
+                         std::string_view chars, bool pad) {
+  size_t i = 0;
+  for (; i + 3 <= n; i += 3) {
+    uint32_t group = data[i] << 16 | data[i + 1] << 8 | data[i + 2];
+    *out++ = chars[group >> 18];
+    *out++ = chars[(group >> 12) & 0x3f];
+    *out++ = chars[(group >> 6) & 0x3f];
+    *out++ = chars[group & 0x3f];
+  }
+
+  if (i == n) {
+    return;
+  }
+
+  uint32_t group = data[i] << 16 | (i + 1 < n ? data[i + 1] << 8 : 0);
+  *out++ = chars[group >> 18];
+  *out++ = chars[(group >> 12) & 0x3f];
+  if (i + 1 < n) {
+    *out++ = chars[(group >> 6) & 0x3f];
+  } else if (pad) {
+    *out++ = '=';
+  }
+
+  if (pad) {
+    *out++ = '=';
+  }
+}
+
+// Decode `n` characters, which doesn't include any padding.
+bool _Base64DecodeScalar(const char* str, size_t n, uint8_t* out,
+                         const _DecodeTable& table) {
+  uint32_t group = 0;
+  for (size_t i = 0; i < n; i++) {
+    int value = table.values[static_cast<unsigned char>(str[i])];
+    if (value < 0) {
+      return false;
+    }
+
+    group = group << 6 | value;
+    if (i % 4 == 3) {
+      *out++ = static_cast<uint8_t>(group >> 16);
+      *out++ = static_cast<uint8_t>(group >> 8);
+      *out++ = static_cast<uint8_t>(group);
+      group = 0;
+    }
+  }
+
+  // A final group of 2 or 3 characters holds 1 or 2 bytes, and the bits left
+  // over must be zero.
+  switch (n % 4) {
+    case 0:
+      return true;
+    case 2:
+      *out = static_cast<uint8_t>(group >> 4);
+      return (group & 0x0f) == 0;
+    case 3:
+      *out++ = static_cast<uint8_t>(group >> 10);
+      *out = static_cast<uint8_t>(group >> 2);
+      return (group & 0x03) == 0;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+void AppendHexEncode(std::string_view data, std::string& out,
+                     bool uppercase) {
+  // kHexDigits is "0123456789abcdefABCDEF".
+  char digits[16];
+  memcpy(digits, kHexDigits.data(), 10);
+  memcpy(digits + 10, kHexDigits.data() + (uppercase ? 16 : 10), 6);
+
+  size_t start = out.size();
+  out.resize(start + 2 * data.size());
+  auto* in = reinterpret_cast<const uint8_t*>(data.data());
+  char* dest = &out[start];
+
+  size_t i = 0;
+#ifdef CPPSTRING_HAVE_AVX2_DISPATCH
+  if (internal::CpuHasAvx2()) {
+    i = _HexEncodeAvx2(in, data.size(), dest, digits);
+  }
+#endif  // CPPSTRING_HAVE_AVX2_DISPATCH
+
+#ifdef CPPSTRING_HAVE_SSE2
+  i += _HexEncodeSse2(in + i, data.size() - i, dest + 2 * i, uppercase);
+#endif  // CPPSTRING_HAVE_SSE2
+
+  _HexEncodeScalar(in + i, data.size() - i, dest + 2 * i, digits);
+}
+
+std::string HexEncode(std::string_view data, bool uppercase) {
+  std::string result;
+  AppendHexEncode(data, result, uppercase);
+  return result;
+}
+
+bool AppendHexDecode(std::string_view hex, std::string& out) {
+  if (hex.size() % 2 != 0) {
+    return false;
+  }
+
+  size_t start = out.size();
+  out.resize(start + hex.size() / 2);
+  auto* dest = reinterpret_cast<uint8_t*>(&out[start]);
+
+  size_t i = 0;
+#ifdef CPPSTRING_HAVE_AVX2_DISPATCH
+  if (internal::CpuHasAvx2()) {
+    i = _HexDecodeAvx2(hex.data(), hex.size(), dest);
+  }
+#endif  // CPPSTRING_HAVE_AVX2_DISPATCH
+
+#ifdef CPPSTRING_HAVE_SSE2
+  i += _HexDecodeSse2(hex.data() + i, hex.size() - i, dest + i / 2);
+#endif  // CPPSTRING_HAVE_SSE2
+
+  if (!_HexDecodeScalar(hex.data() + i, hex.size() - i, dest + i / 2)) {
+    out.resize(start);
+    return false;
+  }
+
+  return true;
+}
+
+std::optional<std::string> HexDecode(std::string_view hex) {
+  std::string result;
+  if (!AppendHexDecode(hex, result)) {
+    return std::nullopt;
+  }
+
+  return result;
+}
+
+void AppendBase64Encode(std::string_view data, std::string& out,
+                        Base64Alphabet alphabet, bool pad) {
+  size_t length = data.size() / 3 * 4;
+  if (data.size() % 3 != 0) {
+    length += pad ? 4 : data.size() % 3 + 1;
+  }
+
+  size_t start = out.size();
+  out.resize(start + length);
+  auto* in = reinterpret_cast<const uint8_t*>(data.data());
+  char* dest = &out[start];
+  std::string_view chars = _Base64Chars(alphabet);
+
+  size_t i = 0;
+#ifdef CPPSTRING_HAVE_AVX2_DISPATCH
+  if (internal::CpuHasAvx2()) {
+    i = _Base64EncodeAvx2(in, data.size(), dest, chars);
+  }
+#endif  // CPPSTRING_HAVE_AVX2_DISPATCH
+
+  _Base64EncodeScalar(in + i, data.size() - i, dest + i / 3 * 4, chars, pad);
+}
+
+std::string Base64Encode(std::string_view data, Base64Alphabet alphabet,
+                         bool pad) {
+  std::string result;
+  AppendBase64Encode(data, result, alphabet, pad);
+  return result;
+}
+
+bool AppendBase64Decode(std::string_view str, std::string& out,
+                        Base64Alphabet alphabet) {
+  // Padding is only allowed if it makes the length a multiple of 4. Any other
+  // "=" is rejected as an invalid character.
+  if (str.size() % 4 == 0) {
+    for (int i = 0; i < 2 && !str.empty() && str.back() == '='; i++) {
+      str.remove_suffix(1);
+    }
+  }
+
+  size_t length = str.size() / 4 * 3 + (str.size() % 4) * 3 / 4;
+  size_t start = out.size();
+
+  // The AVX2 kernel writes 8 bytes past the end of each block.
+  out.resize(start + length + 8);
+  auto* dest = reinterpret_cast<uint8_t*>(&out[start]);
+  std::string_view chars = _Base64Chars(alphabet);
+
+  size_t i = 0;
+#ifdef CPPSTRING_HAVE_AVX2_DISPATCH
+  if (internal::CpuHasAvx2()) {
+    i = _Base64DecodeAvx2(str.data(), str.size(), dest, chars);
+  }
+#endif  // CPPSTRING_HAVE_AVX2_DISPATCH
+
+  if (!_Base64DecodeScalar(str.data() + i, str.size() - i, dest + i / 4 * 3,
+                           _Base64Table(alphabet))) {
+    out.resize(start);
+    return false;
+  }
+
+  out.resize(start + length);
+  return true;
+}
+
+std::optional<std::string> Base64Decode(std::string_view str,
+                                        Base64Alphabet alphabet) {
+  std::string result;
+  if (!AppendBase64Decode(str, result, alphabet)) {
+    return std::nullopt;
+  }
+
+  return result;
+}
+
+}  // namespace string
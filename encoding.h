@@ -0,0 +1,138 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace string {
+
+/**
+ * The two base64 alphabets of RFC 4648. They differ only in the characters for
+ * 62 and 63: "+/" for kStandard, and "-_" for kUrlSafe.
+ */
+enum class Base64Alphabet {
+  kStandard,
+  kUrlSafe,
+};
+
+/**
+ * @brief      Encode bytes as hex, with two digits per byte.
+ *
+ * @details    For example:
+ *
+ *                 HexEncode("\x01\xab") -> "01ab"
+ *                 HexEncode("\x01\xab", true) -> "01AB"
+ *
+ *             The digits are looked up 32 bytes at a time with AVX2, or
+ *             computed 16 bytes at a time with SSE2, where the CPU supports
+ *             them.
+ *
+ * @param[in]  data       The bytes to encode.
+ * @param[in]  uppercase  When true, use "A-F" rather than "a-f".
+ *
+ * @return     The hex encoding of `data`.
+ * @see        HexDecode
+ */
+std::string HexEncode(std::string_view data, bool uppercase = false);
+
+/**
+ * @brief      Same as HexEncode, but appends the result to `out`.
+ * @see        HexEncode
+ */
+void AppendHexEncode(std::string_view data, std::string& out,
+                     bool uppercase = false);
+
+/**
+ * @brief      Decode a hex string into bytes.
+ *
+ * @details    Upper and lower-case digits are both accepted. Anything else,
+ *             including whitespace, a "0x" prefix or an odd number of digits,
+ *             is an error. For example:
+ *
+ *                 HexDecode("01aB") -> "\x01\xab"
+ *                 HexDecode("01a") -> std::nullopt
+ *
+ * @param[in]  hex   The hex digits to decode.
+ *
+ * @return     The decoded bytes, or std::nullopt if `hex` isn't valid hex.
+ * @see        HexEncode
+ */
+std::optional<std::string> HexDecode(std::string_view hex);
+
+/**
+ * @brief      Same as HexDecode, but appends the result to `out`.
+ *
+ * @return     True if `hex` was valid hex. Otherwise, `out` is left as it was.
+ * @see        HexDecode
+ */
+bool AppendHexDecode(std::string_view hex, std::string& out);
+
+/**
+ * @brief      Encode bytes as base64.
+ *
+ * @details    For example:
+ *
+ *                 Base64Encode("hi?") -> "aGk/"
+ *                 Base64Encode("hi?", Base64Alphabet::kUrlSafe) -> "aGk_"
+ *                 Base64Encode("h") -> "aA=="
+ *                 Base64Encode("h", Base64Alphabet::kStandard, false) -> "aA"
+ *
+ *             With AVX2, 24 bytes are encoded at a time by splitting them
+ *             into 6-bit indices and looking up the offset to each index's
+ *             character.
+ *
+ * @param[in]  data      The bytes to encode.
+ * @param[in]  alphabet  The alphabet to encode with.
+ * @param[in]  pad       When true, pad the result with "=" to a multiple of
+ *                       4 characters.
+ *
+ * @return     The base64 encoding of `data`.
+ * @see        Base64Decode
+ */
+std::string Base64Encode(std::string_view data,
+                         Base64Alphabet alphabet = Base64Alphabet::kStandard,
+                         bool pad = true);
+
+/**
+ * @brief      Same as Base64Encode, but appends the result to `out`.
+ * @see        Base64Encode
+ */
+void AppendBase64Encode(std::string_view data, std::string& out,
+                        Base64Alphabet alphabet = Base64Alphabet::kStandard,
+                        bool pad = true);
+
+/**
+ * @brief      Decode a base64 string into bytes.
+ *
+ * @details    Decoding is strict: `str` may only contain characters from
+ *             `alphabet`, and either be unpadded or padded with "=" to a
+ *             multiple of 4 characters. Whitespace, characters from the other
+ *             alphabet, and encodings whose unused trailing bits aren't zero
+ *             are all errors, so each decoded string has exactly one padded
+ *             and one unpadded encoding. For example:
+ *
+ *                 Base64Decode("aGk/") -> "hi?"
+ *                 Base64Decode("aA") -> "h"
+ *                 Base64Decode("aB==") -> std::nullopt
+ *                 Base64Decode("aGk_") -> std::nullopt
+ *
+ * @param[in]  str       The base64 string to decode.
+ * @param[in]  alphabet  The alphabet `str` was encoded with.
+ *
+ * @return     The decoded bytes, or std::nullopt if `str` isn't valid base64.
+ * @see        Base64Encode
+ */
+std::optional<std::string> Base64Decode(
+    std::string_view str, Base64Alphabet alphabet = Base64Alphabet::kStandard);
+
+/**
+ * @brief      Same as Base64Decode, but appends the result to `out`.
+ *
+ * @return     True if `str` was valid base64. Otherwise, `out` is left as it
+ *             was.
+ * @see        Base64Decode
+ */
+bool AppendBase64Decode(std::string_view str, std::string& out,
+                        Base64Alphabet alphabet = Base64Alphabet::kStandard);
+
+}  // namespace string
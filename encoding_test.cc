@@ -0,0 +1,215 @@
+#include "encoding.h"
+
+#include <gtest/gtest.h>
+
+using string::Base64Alphabet;
+
+namespace {
+
+// Random bytes of every length up to `max`, to land on each side of every
+// block boundary.
+std::vector<std::string> RandomStrings(size_t max) {
+  std::vector<std::string> strings;
+  srand(1);
+  for (size_t n = 0; n <= max; n++) {
+    std::string str(n, '\0');
+    for (char& c : str) {
+      c = static_cast<char>(rand());
+    }
+
+    strings.push_back(str);
+  }
+
+  return strings;
+}
+
+// Simple reference encoders, which handle one bit at a time.
+std::string HexEncodeReference(const std::string& data) {
+  std::string hex;
+  for (unsigned char c : data) {
+    hex += "0123456789abcdef"[c >> 4];
+    hex += "0123456789abcdef"[c & 0x0f];
+  }
+
+  return hex;
+}
+
+std::string Base64EncodeReference(const std::string& data,
+                                  const std::string& chars) {
+  std::string result;
+  uint32_t bits = 0;
+  int n_bits = 0;
+  for (unsigned char c : data) {
+    bits = (bits << 8 | c) & 0xffff;
+    n_bits += 8;
+    while (n_bits >= 6) {
+      n_bits -= 6;
+      result += chars[(bits >> n_bits) & 0x3f];
+    }
+  }
+
+  if (n_bits > 0) {
+    result += chars[(bits << (6 - n_bits)) & 0x3f];
+  }
+
+  while (result.size() % 4 != 0) {
+    result += '=';
+  }
+
+  return result;
+}
+
+}  // namespace
+
+TEST(TestHex, TestHexEncode) {
+  ASSERT_EQ("", string::HexEncode(""));
+  ASSERT_EQ("01ab", string::HexEncode("\x01\xab"));
+  ASSERT_EQ("01AB", string::HexEncode("\x01\xab", true));
+  ASSERT_EQ("00ff7f80", string::HexEncode(std::string("\0\xff\x7f\x80", 4)));
+}
+
+TEST(TestHex, TestHexDecode) {
+  ASSERT_EQ("", string::HexDecode(""));
+  ASSERT_EQ("\x01\xab\xcd", string::HexDecode("01aBCd"));
+  ASSERT_EQ(std::nullopt, string::HexDecode("01a"));
+  ASSERT_EQ(std::nullopt, string::HexDecode("0x01"));
+  ASSERT_EQ(std::nullopt, string::HexDecode("01 a"));
+  ASSERT_EQ(std::nullopt, string::HexDecode("0g"));
+}
+
+TEST(TestHex, TestHexDecodeRejectsErrorsInEveryBlock) {
+  std::string hex(100, 'a');
+  for (size_t i = 0; i < hex.size(); i++) {
+    for (char c : {'g', 'G', '/', ':', '@', '`', '\0', '\xe1'}) {
+      std::string bad = hex;
+      bad[i] = c;
+      ASSERT_EQ(std::nullopt, string::HexDecode(bad)) << i << " " << c;
+    }
+  }
+}
+
+TEST(TestHex, TestAgainstReference) {
+  for (const std::string& data : RandomStrings(200)) {
+    std::string hex = string::HexEncode(data);
+    ASSERT_EQ(HexEncodeReference(data), hex);
+    ASSERT_EQ(data, string::HexDecode(hex));
+
+    std::string upper = string::HexEncode(data, true);
+    for (char& c : hex) {
+      c = toupper(c);
+    }
+
+    ASSERT_EQ(hex, upper);
+    ASSERT_EQ(data, string::HexDecode(upper));
+  }
+}
+
+TEST(TestHex, TestAppend) {
+  std::string out = "id=";
+  string::AppendHexEncode("\xde\xad", out);
+  ASSERT_EQ("id=dead", out);
+
+  ASSERT_TRUE(string::AppendHexDecode("4142", out));
+  ASSERT_EQ("id=deadAB", out);
+
+  // A failed decode leaves `out` as it was.
+  ASSERT_FALSE(string::AppendHexDecode("41zz", out));
+  ASSERT_EQ("id=deadAB", out);
+}
+
+TEST(TestBase64, TestBase64Encode) {
+  ASSERT_EQ("", string::Base64Encode(""));
+  ASSERT_EQ("aA==", string::Base64Encode("h"));
+  ASSERT_EQ("aGk=", string::Base64Encode("hi"));
+  ASSERT_EQ("aGk/", string::Base64Encode("hi?"));
+  ASSERT_EQ("aGk_", string::Base64Encode("hi?", Base64Alphabet::kUrlSafe));
+  ASSERT_EQ("aA", string::Base64Encode("h", Base64Alphabet::kStandard, false));
+  ASSERT_EQ("aGk", string::Base64Encode("hi", Base64Alphabet::kUrlSafe, false));
+  ASSERT_EQ("+/8=", string::Base64Encode("\xfb\xff"));
+  ASSERT_EQ("-_8", string::Base64Encode("\xfb\xff", Base64Alphabet::kUrlSafe,
+                                        false));
+}
+
+TEST(TestBase64, TestBase64Decode) {
+  ASSERT_EQ("", string::Base64Decode(""));
+  ASSERT_EQ("h", string::Base64Decode("aA=="));
+  ASSERT_EQ("h", string::Base64Decode("aA"));
+  ASSERT_EQ("hi", string::Base64Decode("aGk="));
+  ASSERT_EQ("hi", string::Base64Decode("aGk"));
+  ASSERT_EQ("hi?", string::Base64Decode("aGk/"));
+  ASSERT_EQ("hi?", string::Base64Decode("aGk_", Base64Alphabet::kUrlSafe));
+}
+
+TEST(TestBase64, TestBase64DecodeIsStrict) {
+  // Characters from the other alphabet.
+  ASSERT_EQ(std::nullopt, string::Base64Decode("aGk_"));
+  ASSERT_EQ(std::nullopt,
+            string::Base64Decode("aGk/", Base64Alphabet::kUrlSafe));
+
+  // Bad padding.
+  ASSERT_EQ(std::nullopt, string::Base64Decode("aA="));
+  ASSERT_EQ(std::nullopt, string::Base64Decode("aA==="));
+  ASSERT_EQ(std::nullopt, string::Base64Decode("a==="));
+  ASSERT_EQ(std::nullopt, string::Base64Decode("===="));
+  ASSERT_EQ(std::nullopt, string::Base64Decode("aA==aGk="));
+  ASSERT_EQ(std::nullopt, string::Base64Decode("a"));
+  ASSERT_EQ(std::nullopt, string::Base64Decode("aGk/a"));
+
+  // Unused bits which aren't zero.
+  ASSERT_EQ(std::nullopt, string::Base64Decode("aB=="));
+  ASSERT_EQ(std::nullopt, string::Base64Decode("aGl="));
+
+  // Whitespace.
+  ASSERT_EQ(std::nullopt, string::Base64Decode("aGk/\n"));
+  ASSERT_EQ(std::nullopt, string::Base64Decode("aG k/"));
+}
+
+TEST(TestBase64, TestBase64DecodeRejectsErrorsInEveryBlock) {
+  std::string str(128, 'A');
+  for (size_t i = 0; i < str.size(); i++) {
+    for (char c : {'=', '-', '_', '.', '@', '[', '`', '{', '\0', '\xc3'}) {
+      // A single "=" at the end is valid padding.
+      if (c == '=' && i == str.size() - 1) {
+        continue;
+      }
+
+      std::string bad = str;
+      bad[i] = c;
+      ASSERT_EQ(std::nullopt, string::Base64Decode(bad)) << i << " " << c;
+    }
+  }
+}
+
+TEST(TestBase64, TestAgainstReference) {
+  const std::string standard =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  const std::string url_safe =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+  for (const std::string& data : RandomStrings(200)) {
+    std::string encoded = string::Base64Encode(data);
+    ASSERT_EQ(Base64EncodeReference(data, standard), encoded);
+    ASSERT_EQ(data, string::Base64Decode(encoded));
+
+    std::string unpadded = encoded.substr(0, encoded.find('='));
+    ASSERT_EQ(unpadded,
+              string::Base64Encode(data, Base64Alphabet::kStandard, false));
+    ASSERT_EQ(data, string::Base64Decode(unpadded));
+
+    std::string url = string::Base64Encode(data, Base64Alphabet::kUrlSafe);
+    ASSERT_EQ(Base64EncodeReference(data, url_safe), url);
+    ASSERT_EQ(data, string::Base64Decode(url, Base64Alphabet::kUrlSafe));
+  }
+}
+
+TEST(TestBase64, TestAppend) {
+  std::string out = "data:";
+  string::AppendBase64Encode("hi?", out);
+  ASSERT_EQ("data:aGk/", out);
+
+  ASSERT_TRUE(string::AppendBase64Decode("aGk=", out));
+  ASSERT_EQ("data:aGk/hi", out);
+
+  ASSERT_FALSE(string::AppendBase64Decode(std::string(64, 'A') + "!", out));
+  ASSERT_EQ("data:aGk/hi", out);
+}
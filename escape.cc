@@ -0,0 +1,621 @@
+#include "escape.h"
+
+#include <cstdint>
+
+#include <string.h>
+
+#include "constants.h"
+#include "simd.h"
+#include "utf8.h"
+
+namespace string {
+
+namespace {
+
+enum class _Escaping {
+  kC,
+  kJson,
+  kHtml,
+};
+
+// The length of the escaped form of each byte, which is 1 for bytes which
+// don't need escaping.
+struct _EscapeTable {
+  uint8_t length[256];
+};
+
+constexpr _EscapeTable _MakeEscapeTable(_Escaping escaping) {
+  _EscapeTable table = {};
+  for (int c = 0; c < 256; c++) {
+    switch (escaping) {
+      case _Escaping::kC:
+        table.length[c] = (c < 0x20 || c >= 0x7f) ? 4 : 1;
+        break;
+      case _Escaping::kJson:
+        table.length[c] = c < 0x20 ? 6 : 1;
+        break;
+      case _Escaping::kHtml:
+        table.length[c] = 1;
+        break;
+    }
+  }
+
+  switch (escaping) {
+    case _Escaping::kC:
+      for (char c : {'\a', '\b', '\f', '\n', '\r', '\t', '\v', '"', '\'',
+                     '\\'}) {
+        table.length[static_cast<unsigned char>(c)] = 2;
+      }
+
+      break;
+    case _Escaping::kJson:
+      for (char c : {'\b', '\f', '\n', '\r', '\t', '"', '\\'}) {
+        table.length[static_cast<unsigned char>(c)] = 2;
+      }
+
+      break;
+    case _Escaping::kHtml:
+      table.length['&'] = 5;   // &amp;
+      table.length['<'] = 4;   // &lt;
+      table.length['>'] = 4;   // &gt;
+      table.length['"'] = 6;   // &quot;
+      table.length['\''] = 5;  // &#39;
+      break;
+  }
+
+  return table;
+}
+
+constexpr _EscapeTable kEscapeTables[] = {
+    _MakeEscapeTable(_Escaping::kC),
+    _MakeEscapeTable(_Escaping::kJson),
+    _MakeEscapeTable(_Escaping::kHtml),
+};
+
+template <_Escaping kEscaping>
+constexpr const _EscapeTable& _Table() {
+  return kEscapeTables[static_cast<int>(kEscaping)];
+}
+
+template <_Escaping kEscaping>
+bool _NeedsEscape(char c) {
+  return _Table<kEscaping>().length[static_cast<unsigned char>(c)] != 1;
+}
+
+// The kernels below return the position of the first byte at or after `i`
+// which needs escaping, or the position they stopped at if they ran out of
+// whole blocks first.
+
+#ifdef CPPSTRING_HAVE_SSE2
+
+inline __m128i _Is128(__m128i v, char c) {
+  return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+}
+
+template <_Escaping kEscaping>
+unsigned _EscapeMask128(__m128i v) {
+  if constexpr (kEscaping == _Escaping::kC) {
+    // Everything outside [0x20, 0x7e] is escaped.
+    __m128i printable =
+        internal::AtMost128(_mm_sub_epi8(v, _mm_set1_epi8(0x20)), 0x5e);
+    __m128i quote = _mm_or_si128(_Is128(v, '"'), _Is128(v, '\''));
+    __m128i special = _mm_or_si128(quote, _Is128(v, '\\'));
+    return (~_mm_movemask_epi8(printable) & 0xffff) |
+           _mm_movemask_epi8(special);
+  } else if constexpr (kEscaping == _Escaping::kJson) {
+    __m128i control = internal::AtMost128(v, 0x1f);
+    __m128i special = _mm_or_si128(_Is128(v, '"'), _Is128(v, '\\'));
+    return _mm_movemask_epi8(_mm_or_si128(control, special));
+  } else {
+    __m128i tag = _mm_or_si128(_Is128(v, '<'), _Is128(v, '>'));
+    __m128i quote = _mm_or_si128(_Is128(v, '"'), _Is128(v, '\''));
+    __m128i special = _mm_or_si128(tag, quote);
+    return _mm_movemask_epi8(_mm_or_si128(special, _Is128(v, '&')));
+  }
+}
+
+template <_Escaping kEscaping>
+size_t _FindEscapeSse2(const char* data, size_t n, size_t i) {
+  for (; i + 16 <= n; i += 16) {
+    unsigned mask = _EscapeMask128<kEscaping>(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+    if (mask != 0) {
+      return i + internal::LowestSetBit(mask);
+    }
+  }
+
+  return i;
+}
+
+#endif  // CPPSTRING_HAVE_SSE2
+
+#ifdef CPPSTRING_HAVE_AVX2_DISPATCH
+
+CPPSTRING_TARGET_AVX2 inline __m256i _Is256(__m256i v, char c) {
+  return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c));
+}
+
+template <_Escaping kEscaping>
+CPPSTRING_TARGET_AVX2 unsigned _EscapeMask256(__m256i v) {
+  if constexpr (kEscaping == _Escaping::kC) {
+    __m256i printable =
+        internal::AtMost256(_mm256_sub_epi8(v, _mm256_set1_epi8(0x20)), 0x5e);
+    __m256i quote = _mm256_or_si256(_Is256(v, '"'), _Is256(v, '\''));
+    __m256i special = _mm256_or_si256(quote, _Is256(v, '\\'));
+    return ~_mm256_movemask_epi8(printable) | _mm256_movemask_epi8(special);
+  } else if constexpr (kEscaping == _Escaping::kJson) {
+    __m256i control = internal::AtMost256(v, 0x1f);
+    __m256i special = _mm256_or_si256(_Is256(v, '"'), _Is256(v, '\\'));
+    return _mm256_movemask_epi8(_mm256_or_si256(control, special));
+  } else {
+    __m256i tag = _mm256_or_si256(_Is256(v, '<'), _Is256(v, '>'));
+    __m256i quote = _mm256_or_si256(_Is256(v, '"'), _Is256(v, '\''));
+    __m256i special = _mm256_or_si256(tag, quote);
+    return _mm256_movemask_epi8(_mm256_or_si256(special, _Is256(v, '&')));
+  }
+}
+
+template <_Escaping kEscaping>
+CPPSTRING_TARGET_AVX2 size_t _FindEscapeAvx2(const char* data, size_t n,
+                                             size_t i) {
+  for (; i + 32 <= n; i += 32) {
+    unsigned mask = _EscapeMask256<kEscaping>(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+    if (mask != 0) {
+      return i + internal::LowestSetBit(mask);
+    }
+  }
+
+  return i;
+}
+
+#endif  // CPPSTRING_HAVE_AVX2_DISPATCH
+
+// Find the first byte at or after `i` which needs escaping, or `n` if there is
+// none.
+template <_Escaping kEscaping>
+size_t _FindEscape(const char* data, size_t n, size_t i) {
+#ifdef CPPSTRING_HAVE_AVX2_DISPATCH
+  if (internal::CpuHasAvx2()) {
+    i = _FindEscapeAvx2<kEscaping>(data, n, i);
+  }
+#endif  // CPPSTRING_HAVE_AVX2_DISPATCH
+
+#ifdef CPPSTRING_HAVE_SSE2
+  i = _FindEscapeSse2<kEscaping>(data, n, i);
+#endif  // CPPSTRING_HAVE_SSE2
+
+  while (i < n && !_NeedsEscape<kEscaping>(data[i])) {
+    i++;
+  }
+
+  return i;
+}
+
+// The characters which C and JSON escape with a backslash and a letter, and
+// those letters.
+constexpr std::string_view kCShortEscapes = "\a\b\f\n\r\t\v\"'\\";
+constexpr std::string_view kCShortForms = "abfnrtv\"'\\";
+constexpr std::string_view kJsonShortEscapes = "\b\f\n\r\t\"\\";
+constexpr std::string_view kJsonShortForms = "bfnrt\"\\";
+
+// Write the escaped form of `c` to `out`, and return the end of it.
+template <_Escaping kEscaping>
+char* _WriteEscape(char c, char* out);
+
+template <>
+char* _WriteEscape<_Escaping::kC>(char c, char* out) {
+  *out++ = '\\';
+  size_t short_form = kCShortEscapes.find(c);
+  if (short_form != std::string_view::npos) {
+    *out++ = kCShortForms[short_form];
+    return out;
+  }
+
+  auto byte = static_cast<unsigned char>(c);
+  *out++ = kOctDigits[byte >> 6];
+  *out++ = kOctDigits[(byte >> 3) & 7];
+  *out++ = kOctDigits[byte & 7];
+  return out;
+}
+
+template <>
+char* _WriteEscape<_Escaping::kJson>(char c, char* out) {
+  *out++ = '\\';
+  size_t short_form = kJsonShortEscapes.find(c);
+  if (short_form != std::string_view::npos) {
+    *out++ = kJsonShortForms[short_form];
+    return out;
+  }
+
+  memcpy(out, "u00", 3);
+  out[3] = kHexDigits[c >> 4];
+  out[4] = kHexDigits[c & 0x0f];
+  return out + 5;
+}
+
+template <>
+char* _WriteEscape<_Escaping::kHtml>(char c, char* out) {
+  std::string_view reference;
+  switch (c) {
+    case '&':
+      reference = "&amp;";
+      break;
+    case '<':
+      reference = "&lt;";
+      break;
+    case '>':
+      reference = "&gt;";
+      break;
+    case '"':
+      reference = "&quot;";
+      break;
+    default:
+      reference = "&#39;";
+      break;
+  }
+
+  memcpy(out, reference.data(), reference.size());
+  return out + reference.size();
+}
+
+// Append `str` to `out`, escaped. `first` is the position of the first byte
+// which needs escaping.
+template <_Escaping kEscaping>
+void _AppendEscaped(std::string_view str, size_t first, std::string& out) {
+  const _EscapeTable& table = _Table<kEscaping>();
+  size_t size = first;
+  for (size_t i = first; i < str.size(); i++) {
+    size += table.length[static_cast<unsigned char>(str[i])];
+  }
+
+  size_t start = out.size();
+  out.resize(start + size);
+  char* dest = &out[start];
+  memcpy(dest, str.data(), first);
+  dest += first;
+
+  // Copy each run of bytes which don't need escaping in one go.
+  size_t i = first;
+  while (i < str.size()) {
+    dest = _WriteEscape<kEscaping>(str[i++], dest);
+    size_t next = _FindEscape<kEscaping>(str.data(), str.size(), i);
+    memcpy(dest, str.data() + i, next - i);
+    dest += next - i;
+    i = next;
+  }
+}
+
+template <_Escaping kEscaping>
+void _AppendEscape(std::string_view str, std::string& out) {
+  size_t first = _FindEscape<kEscaping>(str.data(), str.size(), 0);
+  if (first == str.size()) {
+    out.append(str);
+  } else {
+    _AppendEscaped<kEscaping>(str, first, out);
+  }
+}
+
+template <_Escaping kEscaping>
+std::string_view _EscapeView(std::string_view str, std::string& buffer) {
+  size_t first = _FindEscape<kEscaping>(str.data(), str.size(), 0);
+  if (first == str.size()) {
+    return str;
+  }
+
+  buffer.clear();
+  _AppendEscaped<kEscaping>(str, first, buffer);
+  return buffer;
+}
+
+// Get the value of the hex digit `c`, or -1 if it isn't one.
+int _HexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+
+  c |= 0x20;
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+
+  return -1;
+}
+
+// Parse the 4 hex digits of a JSON "\u" escape at `pos`.
+bool _ParseJsonHex4(std::string_view str, size_t pos, char32_t* value) {
+  if (pos + 4 > str.size()) {
+    return false;
+  }
+
+  *value = 0;
+  for (size_t i = pos; i < pos + 4; i++) {
+    int digit = _HexValue(str[i]);
+    if (digit < 0) {
+      return false;
+    }
+
+    *value = *value << 4 | digit;
+  }
+
+  return true;
+}
+
+// Unescape the escape which starts with the '\\' at `*pos`, and move `*pos`
+// past it.
+bool _UnescapeJsonAt(std::string_view str, size_t* pos, std::string& out) {
+  size_t i = *pos + 1;
+  if (i >= str.size()) {
+    return false;
+  }
+
+  char c = str[i++];
+  size_t short_form = kJsonShortForms.find(c);
+  if (short_form != std::string_view::npos) {
+    out.push_back(kJsonShortEscapes[short_form]);
+  } else if (c == '/') {
+    out.push_back(c);
+  } else if (c == 'u') {
+    char32_t cp;
+    if (!_ParseJsonHex4(str, i, &cp)) {
+      return false;
+    }
+
+    i += 4;
+    if (cp >= 0xdc00 && cp <= 0xdfff) {
+      return false;
+    }
+
+    // A high surrogate must be followed by an escaped low surrogate.
+    if (cp >= 0xd800 && cp <= 0xdbff) {
+      char32_t low;
+      if (str.substr(i, 2) != "\\u" || !_ParseJsonHex4(str, i + 2, &low) ||
+          low < 0xdc00 || low > 0xdfff) {
+        return false;
+      }
+
+      i += 6;
+      cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+    }
+
+    internal::AppendUtf8(cp, out);
+  } else {
+    return false;
+  }
+
+  *pos = i;
+  return true;
+}
+
+// The same as _UnescapeJsonAt, for C escapes.
+bool _UnescapeCAt(std::string_view str, size_t* pos, std::string& out) {
+  size_t i = *pos + 1;
+  if (i >= str.size()) {
+    return false;
+  }
+
+  char c = str[i++];
+  size_t short_form = kCShortForms.find(c);
+  if (short_form != std::string_view::npos) {
+    out.push_back(kCShortEscapes[short_form]);
+  } else if (c == '?') {
+    out.push_back(c);
+  } else if (c == 'x') {
+    // Hex escapes take as many digits as there are, but the value must still
+    // fit in a byte.
+    int value = 0;
+    size_t digits_start = i;
+    for (; i < str.size() && _HexValue(str[i]) >= 0; i++) {
+      value = value << 4 | _HexValue(str[i]);
+      if (value > 0xff) {
+        return false;
+      }
+    }
+
+    if (i == digits_start) {
+      return false;
+    }
+
+    out.push_back(static_cast<char>(value));
+  } else if (c >= '0' && c <= '7') {
+    // Octal escapes take up to three digits.
+    int value = c - '0';
+    for (size_t end = i + 2; i < end && i < str.size(); i++) {
+      if (str[i] < '0' || str[i] > '7') {
+        break;
+      }
+
+      value = value << 3 | (str[i] - '0');
+    }
+
+    if (value > 0xff) {
+      return false;
+    }
+
+    out.push_back(static_cast<char>(value));
+  } else {
+    return false;
+  }
+
+  *pos = i;
+  return true;
+}
+
+// Unescape the character reference which starts with the '&' at `*pos`, and
+// move `*pos` past it. Returns false if it isn't a reference this knows.
+bool _UnescapeHtmlAt(std::string_view str, size_t* pos, std::string& out) {
+  // The longest reference understood is "&#x10ffff;".
+  size_t end = str.substr(*pos, 10).find(';');
+  if (end == std::string_view::npos) {
+    return false;
+  }
+
+  std::string_view name = str.substr(*pos + 1, end - 1);
+  char c = 0;
+  if (name == "amp") {
+    c = '&';
+  } else if (name == "lt") {
+    c = '<';
+  } else if (name == "gt") {
+    c = '>';
+  } else if (name == "quot") {
+    c = '"';
+  } else if (name == "apos") {
+    c = '\'';
+  }
+
+  if (c != 0) {
+    out.push_back(c);
+    *pos += end + 1;
+    return true;
+  }
+
+  if (name.size() < 2 || name[0] != '#') {
+    return false;
+  }
+
+  bool hex = name[1] == 'x' || name[1] == 'X';
+  std::string_view digits = name.substr(hex ? 2 : 1);
+  if (digits.empty()) {
+    return false;
+  }
+
+  char32_t cp = 0;
+  for (char digit : digits) {
+    int value = _HexValue(digit);
+    if (!hex && value > 9) {
+      value = -1;
+    }
+
+    if (value < 0) {
+      return false;
+    }
+
+    cp = cp * (hex ? 16 : 10) + value;
+  }
+
+  if (cp == 0 || cp > 0x10ffff || (cp >= 0xd800 && cp <= 0xdfff)) {
+    return false;
+  }
+
+  internal::AppendUtf8(cp, out);
+  *pos += end + 1;
+  return true;
+}
+
+// Append `str` to `out`, with each escape starting with `introducer` replaced
+// by `unescape_at`. Strings with no escapes at all are appended in one go.
+template <typename UnescapeAtFn>
+bool _AppendUnescaped(std::string_view str, char introducer,
+                      const UnescapeAtFn& unescape_at, std::string& out) {
+  size_t start = out.size();
+  size_t i = 0;
+  while (i < str.size()) {
+    size_t next = str.find(introducer, i);
+    if (next == std::string_view::npos) {
+      next = str.size();
+    }
+
+    out.append(str.data() + i, next - i);
+    i = next;
+    if (i < str.size() && !unescape_at(str, &i, out)) {
+      out.resize(start);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}  // namespace
+
+std::string EscapeJson(std::string_view str) {
+  std::string result;
+  AppendEscapeJson(str, result);
+  return result;
+}
+
+std::string EscapeHtml(std::string_view str) {
+  std::string result;
+  AppendEscapeHtml(str, result);
+  return result;
+}
+
+std::string EscapeC(std::string_view str) {
+  std::string result;
+  AppendEscapeC(str, result);
+  return result;
+}
+
+void AppendEscapeJson(std::string_view str, std::string& out) {
+  _AppendEscape<_Escaping::kJson>(str, out);
+}
+
+void AppendEscapeHtml(std::string_view str, std::string& out) {
+  _AppendEscape<_Escaping::kHtml>(str, out);
+}
+
+void AppendEscapeC(std::string_view str, std::string& out) {
+  _AppendEscape<_Escaping::kC>(str, out);
+}
+
+std::string_view EscapeJsonView(std::string_view str, std::string& buffer) {
+  return _EscapeView<_Escaping::kJson>(str, buffer);
+}
+
+std::string_view EscapeHtmlView(std::string_view str, std::string& buffer) {
+  return _EscapeView<_Escaping::kHtml>(str, buffer);
+}
+
+std::string_view EscapeCView(std::string_view str, std::string& buffer) {
+  return _EscapeView<_Escaping::kC>(str, buffer);
+}
+
+std::optional<std::string> UnescapeJson(std::string_view str) {
+  std::string result;
+  if (!AppendUnescapeJson(str, result)) {
+    return std::nullopt;
+  }
+
+  return result;
+}
+
+std::string UnescapeHtml(std::string_view str) {
+  std::string result;
+  AppendUnescapeHtml(str, result);
+  return result;
+}
+
+std::optional<std::string> UnescapeC(std::string_view str) {
+  std::string result;
+  if (!AppendUnescapeC(str, result)) {
+    return std::nullopt;
+  }
+
+  return result;
+}
+
+bool AppendUnescapeJson(std::string_view str, std::string& out) {
+  return _AppendUnescaped(str, '\\', _UnescapeJsonAt, out);
+}
+
+void AppendUnescapeHtml(std::string_view str, std::string& out) {
+  // Anything which isn't a known reference is copied as it is.
+  _AppendUnescaped(
+      str, '&',
+      [](std::string_view str, size_t* pos, std::string& out) {
+        if (!_UnescapeHtmlAt(str, pos, out)) {
+          out.push_back('&');
+          ++*pos;
+        }
+
+        return true;
+      },
+      out);
+}
+
+bool AppendUnescapeC(std::string_view str, std::string& out) {
+  return _AppendUnescaped(str, '\\', _UnescapeCAt, out);
+}
+
+}  // namespace string
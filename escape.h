@@ -0,0 +1,198 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace string {
+
+/**
+ * @brief      Escape a string for use inside a JSON string literal.
+ *
+ * @details    '"', '\\' and control characters are escaped, using the short
+ *             forms ("\\n", "\\t", ...) where JSON has them and "\\u00XX"
+ *             otherwise. Everything else, including UTF-8, is copied as it is.
+ *             For example:
+ *
+ *                 EscapeJson("say \"hi\"\n") -> "say \\\"hi\\\"\\n"
+ *
+ *             The string is scanned 32 bytes at a time with AVX2, or 16 with
+ *             SSE2, for the first character which needs escaping. If there is
+ *             none, it is copied as it is. Otherwise, the exact length of the
+ *             result is worked out before anything is written.
+ *
+ * @param[in]  str   The string to escape.
+ *
+ * @return     The escaped string.
+ * @see        UnescapeJson
+ * @see        EscapeJsonView
+ */
+std::string EscapeJson(std::string_view str);
+
+/**
+ * @brief      Escape a string for use in HTML text or a quoted attribute.
+ *
+ * @details    '&', '<', '>', '"' and '\'' are replaced by character
+ *             references. For example:
+ *
+ *                 EscapeHtml("<a href='x'>") -> "&lt;a href=&#39;x&#39;&gt;"
+ *
+ * @param[in]  str   The string to escape.
+ *
+ * @return     The escaped string.
+ * @see        EscapeJson
+ * @see        UnescapeHtml
+ */
+std::string EscapeHtml(std::string_view str);
+
+/**
+ * @brief      Escape a string for use inside a C or C++ string literal.
+ *
+ * @details    '"', '\'' and '\\' are escaped, and so are all bytes which
+ *             aren't printable ASCII: as "\\n", "\\t", etc. where C has a short
+ *             form, and as three octal digits otherwise. The result is always
+ *             printable ASCII. For example:
+ *
+ *                 EscapeC("tab\there\x01") -> "tab\\there\\001"
+ *
+ * @param[in]  str   The string to escape.
+ *
+ * @return     The escaped string.
+ * @see        EscapeJson
+ * @see        UnescapeC
+ */
+std::string EscapeC(std::string_view str);
+
+/**
+ * @brief      Same as EscapeJson, but appends the result to `out`.
+ * @see        EscapeJson
+ */
+void AppendEscapeJson(std::string_view str, std::string& out);
+
+/**
+ * @brief      Same as EscapeHtml, but appends the result to `out`.
+ * @see        EscapeHtml
+ */
+void AppendEscapeHtml(std::string_view str, std::string& out);
+
+/**
+ * @brief      Same as EscapeC, but appends the result to `out`.
+ * @see        EscapeC
+ */
+void AppendEscapeC(std::string_view str, std::string& out);
+
+/**
+ * @brief      Same as EscapeJson, but doesn't copy strings which need no
+ *             escaping.
+ *
+ * @details    If nothing in `str` needs escaping, `str` itself is returned.
+ *             Otherwise, `buffer` is replaced with the escaped string, and a
+ *             view of it is returned. Reusing `buffer` between calls means
+ *             that most calls allocate nothing at all:
+ *
+ *                 std::string buffer;
+ *                 for (std::string_view value : values) {
+ *                   Write(EscapeJsonView(value, buffer));
+ *                 }
+ *
+ * @param[in]  str     The string to escape.
+ * @param      buffer  Storage for the escaped string, if it is needed.
+ *
+ * @return     A view of the escaped string, which is valid for as long as
+ *             both `str` and `buffer` are unchanged.
+ * @see        EscapeJson
+ */
+std::string_view EscapeJsonView(std::string_view str, std::string& buffer);
+
+/**
+ * @brief      Same as EscapeHtml, but doesn't copy strings which need no
+ *             escaping.
+ * @see        EscapeJsonView
+ */
+std::string_view EscapeHtmlView(std::string_view str, std::string& buffer);
+
+/**
+ * @brief      Same as EscapeC, but doesn't copy strings which need no
+ *             escaping.
+ * @see        EscapeJsonView
+ */
+std::string_view EscapeCView(std::string_view str, std::string& buffer);
+
+/**
+ * @brief      Undo EscapeJson, or any other escaping of a JSON string literal.
+ *
+ * @details    All of JSON's escapes are understood, including "\\/" and
+ *             "\\uXXXX". Surrogate pairs are combined, and code points are
+ *             written as UTF-8. Anything other than an escape is copied as it
+ *             is. For example:
+ *
+ *                 UnescapeJson("say \\\"hi\\\" \\u00e9") -> "say \"hi\" é"
+ *                 UnescapeJson("\\q") -> std::nullopt
+ *
+ * @param[in]  str   The string to unescape, without its surrounding quotes.
+ *
+ * @return     The unescaped string, or std::nullopt if `str` has an unknown or
+ *             incomplete escape, or an unpaired surrogate.
+ * @see        EscapeJson
+ */
+std::optional<std::string> UnescapeJson(std::string_view str);
+
+/**
+ * @brief      Undo EscapeHtml.
+ *
+ * @details    The references written by EscapeHtml are understood, as are
+ *             "&apos;" and numeric references such as "&#233;" and "&#xe9;",
+ *             which are written as UTF-8. Like a browser, anything else which
+ *             starts with '&' is left as it is. For example:
+ *
+ *                 UnescapeHtml("&lt;b&gt; &amp; &#xe9;") -> "<b> & é"
+ *                 UnescapeHtml("AT&T") -> "AT&T"
+ *
+ * @param[in]  str   The string to unescape.
+ *
+ * @return     The unescaped string.
+ * @see        EscapeHtml
+ */
+std::string UnescapeHtml(std::string_view str);
+
+/**
+ * @brief      Undo EscapeC, or any other escaping of a C string literal.
+ *
+ * @details    The simple escapes ("\\n", "\\?", ...), octal escapes of up to
+ *             three digits and hex escapes are all understood. For example:
+ *
+ *                 UnescapeC("tab\\there\\001") -> "tab\there\x01"
+ *                 UnescapeC("\\x4g") -> "\x04g"
+ *                 UnescapeC("\\400") -> std::nullopt
+ *
+ * @param[in]  str   The string to unescape, without its surrounding quotes.
+ *
+ * @return     The unescaped string, or std::nullopt if `str` has an unknown or
+ *             incomplete escape, or one whose value doesn't fit in a byte.
+ * @see        EscapeC
+ */
+std::optional<std::string> UnescapeC(std::string_view str);
+
+/**
+ * @brief      Same as UnescapeJson, but appends the result to `out`.
+ *
+ * @return     True if `str` was valid. Otherwise, `out` is left as it was.
+ * @see        UnescapeJson
+ */
+bool AppendUnescapeJson(std::string_view str, std::string& out);
+
+/**
+ * @brief      Same as UnescapeHtml, but appends the result to `out`.
+ * @see        UnescapeHtml
+ */
+void AppendUnescapeHtml(std::string_view str, std::string& out);
+
+/**
+ * @brief      Same as UnescapeC, but appends the result to `out`.
+ *
+ * @return     True if `str` was valid. Otherwise, `out` is left as it was.
+ * @see        UnescapeC
+ */
+bool AppendUnescapeC(std::string_view str, std::string& out);
+
+}  // namespace string
@@ -0,0 +1,139 @@
+#include "escape.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// Every byte, so that each one lands in both the SIMD and scalar code.
+std::string AllBytes() {
+  std::string str;
+  for (int c = 0; c < 256; c++) {
+    str += static_cast<char>(c);
+  }
+
+  return str;
+}
+
+}  // namespace
+
+TEST(TestEscapeJson, TestEscapeJson) {
+  ASSERT_EQ("", string::EscapeJson(""));
+  ASSERT_EQ("plain text", string::EscapeJson("plain text"));
+  ASSERT_EQ("say \\\"hi\\\"\\n", string::EscapeJson("say \"hi\"\n"));
+  ASSERT_EQ("a\\\\b\\t\\u0001\\u001f", string::EscapeJson("a\\b\t\x01\x1f"));
+  ASSERT_EQ("é/\x7f", string::EscapeJson("é/\x7f"));
+  ASSERT_EQ("\\u0000", string::EscapeJson(std::string(1, '\0')));
+}
+
+TEST(TestEscapeJson, TestUnescapeJson) {
+  ASSERT_EQ("say \"hi\"\n", string::UnescapeJson("say \\\"hi\\\"\\n"));
+  ASSERT_EQ("/\b\f\r\t\\", string::UnescapeJson("\\/\\b\\f\\r\\t\\\\"));
+  ASSERT_EQ("é", string::UnescapeJson("\\u00e9"));
+  ASSERT_EQ("\U0001F600", string::UnescapeJson("\\ud83d\\uDE00"));
+  ASSERT_EQ(std::string(1, '\0'), string::UnescapeJson("\\u0000"));
+}
+
+TEST(TestEscapeJson, TestUnescapeJsonFailsOnBadEscapes) {
+  for (std::string str : {"\\", "a\\q", "\\u12", "\\u12g4", "\\ud83d",
+                          "\\ud83dx", "\\ud83d\\u0041", "\\ude00"}) {
+    ASSERT_EQ(std::nullopt, string::UnescapeJson(str)) << str;
+  }
+}
+
+TEST(TestEscapeHtml, TestEscapeHtml) {
+  ASSERT_EQ("plain text", string::EscapeHtml("plain text"));
+  ASSERT_EQ("&lt;a href=&#39;x&#39;&gt;", string::EscapeHtml("<a href='x'>"));
+  ASSERT_EQ("&quot;A&amp;B&quot;", string::EscapeHtml("\"A&B\""));
+}
+
+TEST(TestEscapeHtml, TestUnescapeHtml) {
+  ASSERT_EQ("<b> & é", string::UnescapeHtml("&lt;b&gt; &amp; &#xe9;"));
+  ASSERT_EQ("\"'' A", string::UnescapeHtml("&quot;&apos;&#39; &#65;"));
+  ASSERT_EQ("\U0010FFFF", string::UnescapeHtml("&#x10FFFF;"));
+
+  // Unknown and malformed references are left as they are.
+  for (std::string str : {"AT&T", "&", "&nbsp;", "&#;", "&#x;", "&#xd800;",
+                          "&#0;", "&#12a;", "&amp", "&#x110000;"}) {
+    ASSERT_EQ(str, string::UnescapeHtml(str));
+  }
+}
+
+TEST(TestEscapeC, TestEscapeC) {
+  ASSERT_EQ("plain text", string::EscapeC("plain text"));
+  ASSERT_EQ("tab\\there\\001", string::EscapeC("tab\there\x01"));
+  ASSERT_EQ("\\\"\\'\\\\\\a\\v", string::EscapeC("\"'\\\a\v"));
+  ASSERT_EQ("\\303\\251\\177", string::EscapeC("é\x7f"));
+}
+
+TEST(TestEscapeC, TestUnescapeC) {
+  ASSERT_EQ("tab\there\x01", string::UnescapeC("tab\\there\\001"));
+  ASSERT_EQ("\x04g", string::UnescapeC("\\x4g"));
+  ASSERT_EQ("\xff", string::UnescapeC("\\xff"));
+  ASSERT_EQ("\0018", string::UnescapeC("\\18"));
+  ASSERT_EQ("\3774", string::UnescapeC("\\3774"));
+  ASSERT_EQ("?\"'", string::UnescapeC("\\?\\\"\\'"));
+}
+
+TEST(TestEscapeC, TestUnescapeCFailsOnBadEscapes) {
+  for (std::string str : {"\\", "a\\q", "\\x", "\\xg", "\\x100", "\\400",
+                          "\\8"}) {
+    ASSERT_EQ(std::nullopt, string::UnescapeC(str)) << str;
+  }
+}
+
+TEST(TestEscape, TestRoundTripEveryByte) {
+  std::string all = AllBytes();
+  for (size_t pad = 0; pad < 40; pad++) {
+    std::string str = std::string(pad, 'x') + all + std::string(pad, 'y');
+    ASSERT_EQ(str, string::UnescapeJson(string::EscapeJson(str)));
+    ASSERT_EQ(str, string::UnescapeHtml(string::EscapeHtml(str)));
+    ASSERT_EQ(str, string::UnescapeC(string::EscapeC(str)));
+  }
+}
+
+TEST(TestEscape, TestEscapeEachByteInEveryPosition) {
+  // A single byte needing escaping at each position of a long string, so that
+  // it is found by each of the SIMD and scalar paths.
+  for (size_t i = 0; i < 70; i++) {
+    std::string str(70, 'a');
+    str[i] = '<';
+    std::string expected(70, 'a');
+    expected.replace(i, 1, "&lt;");
+    ASSERT_EQ(expected, string::EscapeHtml(str)) << i;
+
+    str[i] = '\x7f';
+    expected.replace(i, 4, "\\177");
+    ASSERT_EQ(expected, string::EscapeC(str)) << i;
+  }
+}
+
+TEST(TestEscape, TestViewsDontCopy) {
+  std::string buffer = "unused";
+  std::string_view clean = "nothing to escape here, at all!!";
+  ASSERT_EQ(clean.data(), string::EscapeJsonView(clean, buffer).data());
+  ASSERT_EQ(clean.data(), string::EscapeHtmlView(clean, buffer).data());
+  ASSERT_EQ(clean.data(), string::EscapeCView(clean, buffer).data());
+  ASSERT_EQ("unused", buffer);
+
+  std::string_view escaped = string::EscapeHtmlView("a<b", buffer);
+  ASSERT_EQ("a&lt;b", escaped);
+  ASSERT_EQ(buffer.data(), escaped.data());
+}
+
+TEST(TestEscape, TestAppend) {
+  std::string out = "x=";
+  string::AppendEscapeJson("\"", out);
+  string::AppendEscapeHtml("&", out);
+  string::AppendEscapeC("\n", out);
+  ASSERT_EQ("x=\\\"&amp;\\n", out);
+
+  ASSERT_TRUE(string::AppendUnescapeJson("\\t", out));
+  string::AppendUnescapeHtml("&gt;", out);
+  ASSERT_TRUE(string::AppendUnescapeC("\\x41", out));
+  ASSERT_EQ("x=\\\"&amp;\\n\t>A", out);
+
+  // A failed unescape leaves `out` as it was.
+  ASSERT_FALSE(string::AppendUnescapeJson("ok\\q", out));
+  ASSERT_FALSE(string::AppendUnescapeC("ok\\q", out));
+  ASSERT_EQ("x=\\\"&amp;\\n\t>A", out);
+}
@@ -1,16 +1,25 @@
 #include "format.h"
 
+#include <algorithm>
+#include <charconv>
+#include <limits>
 #include <memory>
-#include <sstream>
+#include <ostream>
 
 #include <string.h>
 
 #include <gflags/gflags.h>
 
+#include "builder.h"
+#include "escape.h"
+#include "metrics.h"
+#include "parse.h"
 #include "util.h"
 
 DEFINE_uint32(cppstring_format_buffer_bytes, 1024,
               "Length of the format string buffer to use in bytes.");
+DEFINE_bool(cppstring_metrics, false,
+            "Record call counts, sizes and latencies of string functions.");
 
 namespace string {
 
@@ -30,17 +39,45 @@ PrintableAny::PrintableAny(const char t[])
 
 namespace {
 
-// Write all non-tag characters to the given SS.
-void _WriteIntermediateCharacters(const std::string& str,
-                                  std::stringstream& ss) {
+// A streambuf which appends everything written to it to a string, so that
+// objects can be printed straight into the result.
+template <typename String>
+class _AppendBuf : public std::streambuf {
+ public:
+  explicit _AppendBuf(String& str) : str_(str) {}
+
+ protected:
+  int_type overflow(int_type c) override {
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      str_.push_back(traits_type::to_char_type(c));
+    }
+
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    str_.append(s, n);
+    return n;
+  }
+
+ private:
+  String& str_;
+};
+
+// Check the non-tag characters of a format.
+void _CheckIntermediateCharacters(std::string_view str) {
   // If there is a single } somewhere in the string, then we have a problem.
-  int n_right = Count(str, "}");
-  int n_double_right = Count(str, "}}");
+  // Count them directly rather than with Count, which would record metrics.
+  size_t n_right = std::count(str.begin(), str.end(), '}');
+  size_t n_double_right = 0;
+  for (size_t pos = str.find("}}"); pos != std::string::npos;
+       pos = str.find("}}", pos + 2)) {
+    n_double_right++;
+  }
+
   if (n_right > (2 * n_double_right)) {
     throw std::invalid_argument("Mismatch { and } in format string.");
   }
-
-  ss << str;
 }
 
 // Write the given format string to the given format buffer, using `val` of type
@@ -60,37 +97,129 @@ char* _WriteToFormatBuffer(char* buffer, const std::string& fmt,
   return buffer;
 }
 
-typedef std::function<const internal::PrintableAny(const std::string&)> TagFn;
+// Write `val` to `result` as described by the printf-style `type`, or through
+// `stream` if `type` is " ".
+template <typename String>
+void _WriteValue(const std::string& type, const internal::PrintableAny& val,
+                 char* buffer, std::ostream& stream, String& result) {
+  char last_char = type.back();
+  switch (last_char) {
+    // String type.
+    case 's':
+      result.append(_WriteToFormatBuffer<const char*>(buffer, type, val));
+      break;
+
+    // Character type.
+    case 'c':
+      result.append(_WriteToFormatBuffer<char>(buffer, type, val));
+      break;
+
+    // Pointer type.
+    case 'p':
+      result.append(_WriteToFormatBuffer<void*>(buffer, type, val));
+      break;
+
+    // Integer types.
+    case 'd':
+    case 'o':
+    case 'x':
+    case 'X':
+    case 'i':
+      try {
+        result.append(_WriteToFormatBuffer<int>(buffer, type, val));
+      } catch (boost::bad_any_cast) {
+        try {
+          result.append(_WriteToFormatBuffer<long>(buffer, type, val));
+        } catch (boost::bad_any_cast) {
+          result.append(_WriteToFormatBuffer<long long>(buffer, type, val));
+        }
+      }
 
-std::string _Format(const std::string& fmt, const TagFn& get_tag) {
-  // We have to be fast, so just scan through the string until we find a set of
-  // matching {}.
-  std::stringstream result;
+      break;
 
-// Allocate space for the buffer. On Windows, this has to be an actually
-// allocated array, so use a unique_ptr to make sure it is destroyed. On other
-// OSes, you can just use a variable sized char array.
-#ifdef OS_WINDOWS
-  std::unique_ptr<char[]> buffer_store(
-      new char[FLAGS_cppstring_format_buffer_bytes]);
-  char* buffer = buffer_store.get();
-#else
-  char buffer[FLAGS_cppstring_format_buffer_bytes];
-#endif
+    // Unsigned integer.
+    case 'u':
+      try {
+        result.append(_WriteToFormatBuffer<unsigned int>(buffer, type, val));
+      } catch (boost::bad_any_cast) {
+        try {
+          result.append(_WriteToFormatBuffer<unsigned long>(buffer, type, val));
+        } catch (boost::bad_any_cast) {
+          result.append(
+              _WriteToFormatBuffer<unsigned long long>(buffer, type, val));
+        }
+      }
+      break;
+
+    // Floating point notations.
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+    case 'E':
+    case 'e':
+    case 'F':
+    case 'f':
+      try {
+        result.append(_WriteToFormatBuffer<float>(buffer, type, val));
+      } catch (boost::bad_any_cast) {
+        try {
+          result.append(_WriteToFormatBuffer<double>(buffer, type, val));
+        } catch (boost::bad_any_cast) {
+          result.append(_WriteToFormatBuffer<long double>(buffer, type, val));
+        }
+      }
+
+      break;
+
+    // Arbitrary objects. Assume the object supports << notation.
+    case ' ':
+      val.printer_(stream, val);
+      break;
+
+    // Unknown types.
+    default:
+      throw std::invalid_argument("unknown type format");
+  }
+}
+
+typedef std::string_view (*EscapeViewFn)(std::string_view, std::string&);
+
+// Get the escape function for the conversion after a ! in a tag, or nullptr
+// if it isn't a conversion.
+EscapeViewFn _GetEscape(std::string_view conversion) {
+  if (conversion == "json") {
+    return EscapeJsonView;
+  } else if (conversion == "html") {
+    return EscapeHtmlView;
+  } else if (conversion == "c") {
+    return EscapeCView;
+  }
+
+  return nullptr;
+}
 
-  size_t start = fmt.find("{"), last_end = -1;
+// Parse `fmt`, calling `on_text(text)` with each run of text between tags and
+// `on_tag(tag, type, escape)` with each tag. `type` is a printf format, or " "
+// to print the value with <<. The views are only valid during each call.
+template <typename OnText, typename OnTag>
+void _ParseFormat(std::string_view fmt, OnText&& on_text, OnTag&& on_tag) {
+  // We have to be fast, so just scan through the string until we find a set of
+  // matching {}.
+  size_t start = fmt.find('{'), last_end = -1;
   size_t next_tag_index = 0;  // used for Format(), not FormatMap()
+  char index_buffer[std::numeric_limits<size_t>::digits10 + 1];
   while (start != std::string::npos) {
     // If the immediate next character is a {, then this bracket has been
     // escaped and we can ignore it; just move on.
     if (fmt.substr(start + 1, 1) == "{") {
-      result << "{{";
+      on_text("{{");
       last_end = start + 1;
-      start = fmt.find("{", last_end + 1);
+      start = fmt.find('{', last_end + 1);
       continue;
     }
 
-    size_t end = fmt.find("}", start + 1);
+    size_t end = fmt.find('}', start + 1);
 
     // If we didn't find end, it is an invalid format.
     if (end == std::string::npos) {
@@ -100,157 +229,316 @@ std::string _Format(const std::string& fmt, const TagFn& get_tag) {
     // Everything between [start, end] is a tag. So, first add everything from
     // the end of the last tag until now to the string.
     if (last_end + 1 < start) {
-      _WriteIntermediateCharacters(
-          fmt.substr(last_end + 1, start - last_end - 1), result);
+      std::string_view text = fmt.substr(last_end + 1, start - last_end - 1);
+      _CheckIntermediateCharacters(text);
+      on_text(text);
     }
 
     // Parse the tag.
-    auto tag_raw = fmt.substr(start + 1, end - start - 1);
-    std::string tag = tag_raw, type = " ";
-    if (In(tag_raw, ":")) {
-      type = "%" + tag_raw.substr(tag_raw.find(":") + 1);
-      tag = tag_raw.substr(0, tag_raw.length() - type.length());
+    std::string_view tag_raw = fmt.substr(start + 1, end - start - 1);
+    std::string_view tag = tag_raw;
+    std::string type = " ";
+    size_t colon = tag_raw.find(':');
+    if (colon != std::string::npos) {
+      type.assign("%").append(tag_raw.substr(colon + 1));
+      tag = tag_raw.substr(0, colon);
+    }
+
+    // A conversion after the last ! escapes the value, e.g. {name!html}. Any
+    // other ! is part of the key, so that keys like "a!b" still work.
+    EscapeViewFn escape = nullptr;
+    size_t bang = tag.rfind('!');
+    if (bang != std::string::npos) {
+      escape = _GetEscape(tag.substr(bang + 1));
+      if (escape != nullptr) {
+        tag = tag.substr(0, bang);
+      }
     }
 
     // If the tag is empty, the use the next index.
     if (tag.empty()) {
-      tag = std::to_string(next_tag_index);
+      char* index_end = std::to_chars(index_buffer,
+                                      index_buffer + sizeof(index_buffer),
+                                      next_tag_index)
+                            .ptr;
+      tag = std::string_view(index_buffer, index_end - index_buffer);
       next_tag_index++;
     }
 
     // If the tag contains a { character, that is bad.
-    if (tag_raw.find("{") != std::string::npos) {
+    if (tag_raw.find('{') != std::string::npos) {
       throw std::invalid_argument("Invalid tag contents.");
     }
 
-    // Write the typed content to the buffer.
-    char last_char = type.back();
-    const internal::PrintableAny& val = get_tag(tag);
-    switch (last_char) {
-      // String type.
-      case 's':
-        result << _WriteToFormatBuffer<const char*>(buffer, type, val);
-        break;
-
-      // Character type.
-      case 'c':
-        result << _WriteToFormatBuffer<char>(buffer, type, val);
-        break;
-
-      // Pointer type.
-      case 'p':
-        result << _WriteToFormatBuffer<void*>(buffer, type, val);
-        break;
-
-      // Integer types.
-      case 'd':
-      case 'o':
-      case 'x':
-      case 'X':
-      case 'i':
-        try {
-          result << _WriteToFormatBuffer<int>(buffer, type, val);
-        } catch (boost::bad_any_cast) {
-          try {
-            result << _WriteToFormatBuffer<long>(buffer, type, val);
-          } catch (boost::bad_any_cast) {
-            result << _WriteToFormatBuffer<long long>(buffer, type, val);
-          }
-        }
+    on_tag(tag, type, escape);
 
-        break;
+    // Move to the next tag.
+    last_end = end;
+    start = fmt.find('{', last_end + 1);
+  }
 
-      // Unsigned integer.
-      case 'u':
-        try {
-          result << _WriteToFormatBuffer<unsigned int>(buffer, type, val);
-        } catch (boost::bad_any_cast) {
-          try {
-            result << _WriteToFormatBuffer<unsigned long>(buffer, type, val);
-          } catch (boost::bad_any_cast) {
-            result << _WriteToFormatBuffer<unsigned long long>(buffer, type,
-                                                               val);
-          }
-        }
-        break;
-
-      // Floating point notations.
-      case 'g':
-      case 'G':
-      case 'a':
-      case 'A':
-      case 'E':
-      case 'e':
-      case 'F':
-      case 'f':
-        try {
-          result << _WriteToFormatBuffer<float>(buffer, type, val);
-        } catch (boost::bad_any_cast) {
-          try {
-            result << _WriteToFormatBuffer<double>(buffer, type, val);
-          } catch (boost::bad_any_cast) {
-            result << _WriteToFormatBuffer<long double>(buffer, type, val);
-          }
-        }
+  // Add the rest of the string.
+  if (last_end + 1 < fmt.size()) {
+    std::string_view text = fmt.substr(last_end + 1);
+    _CheckIntermediateCharacters(text);
+    on_text(text);
+  }
+}
+
+// Call `fn` with a buffer of --cppstring_format_buffer_bytes to print into.
+template <typename Fn>
+void _WithFormatBuffer(Fn&& fn) {
+// On Windows, this has to be an actually allocated array, so use a unique_ptr
+// to make sure it is destroyed. On other OSes, you can just use a variable
+// sized char array.
+#ifdef OS_WINDOWS
+  std::unique_ptr<char[]> buffer_store(
+      new char[FLAGS_cppstring_format_buffer_bytes]);
+  char* buffer = buffer_store.get();
+#else
+  char buffer[FLAGS_cppstring_format_buffer_bytes];
+#endif
 
-        break;
+  fn(buffer);
+}
+
+// Write `val` to `result` as described by a tag's `type` and `escape`.
+template <typename String>
+void _WriteTag(const internal::PrintableAny& val, const std::string& type,
+               EscapeViewFn escape, char* buffer, std::ostream& stream,
+               String& result) {
+  if (escape == nullptr) {
+    _WriteValue(type, val, buffer, stream, result);
+    return;
+  }
 
-      // Arbitrary objects. Assume the object supports << notation.
-      case ' ':
-        val.printer_(result, val);
-        break;
+  std::string value;
+  _AppendBuf<std::string> value_buf(value);
+  std::ostream value_stream(&value_buf);
+  _WriteValue(type, val, buffer, value_stream, value);
 
-      // Unknown types.
-      default:
-        throw std::invalid_argument("unknown type format");
+  std::string escaped;
+  std::string_view view = escape(value, escaped);
+  result.append(view.data(), view.size());
+}
+
+// Append `fmt` to `result`, with each tag replaced by `get_tag(tag)`. Tags are
+// passed as views, which are only valid during the call.
+template <typename String, typename GetTag>
+void _FormatInto(std::string_view fmt, GetTag&& get_tag, String& result) {
+  // Arbitrary objects are printed through a stream which writes straight into
+  // `result`.
+  _AppendBuf<String> buf(result);
+  std::ostream stream(&buf);
+  _WithFormatBuffer([&](char* buffer) {
+    _ParseFormat(
+        fmt,
+        [&result](std::string_view text) {
+          result.append(text.data(), text.size());
+        },
+        [&](std::string_view tag, const std::string& type,
+            EscapeViewFn escape) {
+          _WriteTag(get_tag(tag), type, escape, buffer, stream, result);
+        });
+  });
+}
+
+// The scratch builder used by _BuildString is freed after a call which grows
+// it beyond this, so that one huge result doesn't pin memory on the thread
+// for good.
+constexpr size_t kMaxScratchCapacity = 16 * 1024;
+
+// Call `write` with a StringBuilder, and return what it wrote.
+template <typename Write>
+std::string _BuildString(Write&& write) {
+  // Write into a builder which is reused by every call on this thread, so that
+  // the result is copied out in one allocation rather than grown piece by
+  // piece. Objects printed by a tag may call Format themselves, so a nested
+  // call gets a builder of its own.
+  thread_local StringBuilder scratch;
+  thread_local bool scratch_in_use = false;
+  if (scratch_in_use) {
+    StringBuilder builder;
+    write(builder);
+    return builder.str();
+  }
+
+  struct Release {
+    ~Release() {
+      scratch_in_use = false;
+      if (scratch.capacity() > kMaxScratchCapacity) {
+        scratch = StringBuilder();
+      }
     }
+  } release;
 
-    // Move to the next tag.
-    last_end = end;
-    start = fmt.find("{", last_end + 1);
+  scratch_in_use = true;
+  scratch.clear();
+  write(scratch);
+  return scratch.str();
+}
+
+template <typename GetTag>
+std::string _Format(std::string_view fmt, GetTag&& get_tag) {
+  return _BuildString(
+      [&](StringBuilder& result) { _FormatInto(fmt, get_tag, result); });
+}
+
+// Look `key` up in `map`. If it is missing and that is allowed, `missing` is
+// set to the tag itself, so that it is left in the result.
+template <typename Map>
+const internal::PrintableAny& _LookUpTag(const Map& map,
+                                         const typename Map::key_type& key,
+                                         std::string_view tag,
+                                         bool missing_keys_ok,
+                                         internal::PrintableAny& missing) {
+  auto it = map.find(key);
+  if (it != map.end()) {
+    return it->second;
   }
 
-  // Add the rest of the string.
-  if (last_end + 1 < fmt.size()) {
-    _WriteIntermediateCharacters(fmt.substr(last_end + 1), result);
+  if (!missing_keys_ok) {
+    throw std::out_of_range("Format tag not found in map.");
   }
 
-  return result.str();
+  missing = "{" + std::string(tag) + "}";
+  return missing;
+}
+
+// Get a function which looks tags up in `map`. Missing tags are looked up with
+// find rather than at, so that they don't cost an exception when they are
+// allowed.
+template <typename Map>
+auto _MapTagFn(const Map& map, bool missing_keys_ok) {
+  return [&map, missing_keys_ok, missing = internal::PrintableAny()](
+             std::string_view s) mutable -> const internal::PrintableAny& {
+    return _LookUpTag(map, typename Map::key_type(s), s, missing_keys_ok,
+                      missing);
+  };
+}
+
+// Get a function which looks tags up by index in `args`.
+auto _ListTagFn(const FormatListType& args) {
+  return [&args](std::string_view s) -> const internal::PrintableAny& {
+    auto index = ParseUint<size_t>(s);
+    if (index.error == ParseError::kInvalid) {
+      throw std::invalid_argument("Format tag is not an index.");
+    }
+
+    if (!index.ok() || index.value >= args.size()) {
+      throw std::out_of_range("Format tag index out of range.");
+    }
+
+    return args[index.value];
+  };
+}
+
+// A tag function which replaces every tag with nothing.
+const internal::PrintableAny& _EmptyTag(std::string_view) {
+  static const internal::PrintableAny kEmpty("");
+  return kEmpty;
 }
 
 }  // namespace
 
 std::string FormatMap(const std::string& fmt, const FormatMapType& map,
                       bool missing_keys_ok) {
-  return _Format(fmt,
-                 [&map, &missing_keys_ok](
-                     const std::string& s) -> const internal::PrintableAny {
-                   try {
-                     return map.at(s);
-                   } catch (std::out_of_range& e) {
-                     if (missing_keys_ok) {
-                       return "{" + s + "}";
-                     }
-
-                     throw;
-                   }
-                 });
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kFormatMap, fmt.size());
+  std::string result = _Format(fmt, _MapTagFn(map, missing_keys_ok));
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
+  return result;
 }
 
 std::string Format(const std::string& fmt, const FormatListType& args) {
-  return _Format(
-      fmt, [&args](const std::string& s) { return args.at(std::stoi(s)); });
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kFormat, fmt.size());
+  std::string result = _Format(fmt, _ListTagFn(args));
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
+  return result;
+}
+
+std::pmr::string FormatMap(const std::string& fmt, const FormatMapType& map,
+                           std::pmr::memory_resource* resource,
+                           bool missing_keys_ok) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kFormatMap, fmt.size());
+  std::pmr::string result(resource);
+  _FormatInto(fmt, _MapTagFn(map, missing_keys_ok), result);
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
+  return result;
+}
+
+std::pmr::string Format(const std::string& fmt, const FormatListType& args,
+                        std::pmr::memory_resource* resource) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kFormat, fmt.size());
+  std::pmr::string result(resource);
+  _FormatInto(fmt, _ListTagFn(args), result);
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
+  return result;
+}
+
+StringBuilder& StringBuilder::AppendFormat(const std::string& fmt,
+                                           const FormatListType& args) {
+  _FormatInto(fmt, _ListTagFn(args), *this);
+  return *this;
+}
+
+StringBuilder& StringBuilder::AppendFormatMap(const std::string& fmt,
+                                              const FormatMapType& args,
+                                              bool missing_tags_ok) {
+  _FormatInto(fmt, _MapTagFn(args, missing_tags_ok), *this);
+  return *this;
+}
+
+std::string FormatHashedMap(const std::string& fmt,
+                            const HashedFormatMapType& map,
+                            bool missing_keys_ok) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kFormatMap, fmt.size());
+  std::string result = _Format(fmt, _MapTagFn(map, missing_keys_ok));
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
+  return result;
+}
+
+FormatTemplate::FormatTemplate(std::string_view fmt) : fmt_size_(fmt.size()) {
+  _ParseFormat(
+      fmt, [this](std::string_view text) { tail_.append(text); },
+      [this](std::string_view tag, const std::string& type,
+             EscapeViewFn escape) {
+        pieces_.push_back({std::move(tail_), HashedString(tag), type, escape});
+        tail_.clear();
+      });
+}
+
+std::string FormatTemplate::Format(const HashedFormatMapType& args,
+                                   bool missing_tags_ok) const {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kFormatMap, fmt_size_);
+  std::string formatted = _BuildString([&](StringBuilder& result) {
+    _AppendBuf<StringBuilder> buf(result);
+    std::ostream stream(&buf);
+    internal::PrintableAny missing;
+    _WithFormatBuffer([&](char* buffer) {
+      for (const auto& piece : pieces_) {
+        result.append(piece.text);
+        const internal::PrintableAny& val = _LookUpTag(
+            args, piece.tag, piece.tag.view(), missing_tags_ok, missing);
+        _WriteTag(val, piece.type, piece.escape, buffer, stream, result);
+      }
+
+      result.append(tail_);
+    });
+  });
+  CPPSTRING_METRICS_OUTPUT(metrics, formatted);
+  return formatted;
 }
 
 std::string FormatTrimTags(const std::string& fmt) {
-  return _Format(fmt, [](const std::string&) { return ""; });
+  return _Format(fmt, _EmptyTag);
 }
 
 bool FormatHasTag(const std::string& fmt, const std::string& tag) {
   bool has_tag = false;
-  _Format(fmt, [&has_tag, &tag](const std::string& t) {
+  _Format(fmt, [&has_tag, &tag](std::string_view t)
+                   -> const internal::PrintableAny& {
     has_tag = has_tag || (t == tag);
-    return "";
+    return _EmptyTag(t);
   });
 
   return has_tag;
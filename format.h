@@ -1,7 +1,9 @@
 #pragma once
 
 #include <functional>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -9,6 +11,8 @@
 
 #include <boost/any.hpp>
 
+#include "hashed.h"
+
 namespace string {
 
 // Internal; don't use directly.
@@ -94,6 +98,21 @@ typedef std::unordered_map<std::string, internal::PrintableAny> FormatMapType;
  *             places. The possible options for formats are the same as the
  *             standard `printf()`.
  *
+ *             Values which are going into JSON, HTML or C source can be
+ *             escaped by adding a conversion after a ! character, before any
+ *             format. The conversions are "json", "html" and "c", which use
+ *             EscapeJson, EscapeHtml and EscapeC:
+ *
+ *                 FormatMap("<b>{name!html}</b>", {{"name", "A&B"}})
+ *                     -> "<b>A&amp;B</b>"
+ *                 Format("\"{!c}\"", {"line\n"}) -> "\"line\\n\""
+ *
+ *             Any other text after a ! is part of the tag, so
+ *             FormatMap("{a!b}", {{"a!b", 1}}) -> "1".
+ *
+ *             Values which need no escaping are written without being copied
+ *             again.
+ *
  *             If you want the format to include { or }, just write it twice.
  *
  *                 FormatMap("{{{n}}}", {{"n", 3}}) -> "{{3}}"
@@ -139,6 +158,123 @@ std::string FormatMap(const std::string& fmt, const FormatMapType& args,
  */
 std::string Format(const std::string& fmt, const FormatListType& args);
 
+/**
+ * @brief      Same as FormatMap, but allocates the result from `resource`.
+ * @see        FormatMap
+ */
+std::pmr::string FormatMap(const std::string& fmt, const FormatMapType& args,
+                           std::pmr::memory_resource* resource,
+                           bool missing_tags_ok = false);
+
+/**
+ * @brief      Same as Format, but allocates the result from `resource`.
+ * @see        Format
+ */
+std::pmr::string Format(const std::string& fmt, const FormatListType& args,
+                        std::pmr::memory_resource* resource);
+
+/**
+ * The type to use as an argument to FormatHashedMap().
+ * @see        FormatHashedMap
+ */
+typedef std::unordered_map<HashedString, internal::PrintableAny>
+    HashedFormatMapType;
+
+/**
+ * @brief      Same as FormatMap, but the keys are HashedStrings.
+ *
+ * @details    Each tag is hashed as it is looked up, but the key is built
+ *             straight from the format, so tags of up to
+ *             HashedString::kInlineCapacity bytes are looked up without
+ *             allocating, and missing tags are found without throwing an
+ *             exception internally. To hash the tags only once, when the same
+ *             format is used many times, use a FormatTemplate. For example:
+ *
+ *                 HashedFormatMapType args = {{"name", "Sarah"}};
+ *                 FormatHashedMap("Hello, {name}!", args) -> "Hello, Sarah!"
+ *
+ * @param[in]  fmt              The format string.
+ * @param[in]  args             The mapping to be applied to the format string.
+ * @param[in]  missing_tags_ok  When set to true, missing tags will not cause
+ *                              an exception to be thrown.
+ *
+ * @throws     std::invalid_argument Thrown if the format string is invalid.
+ * @throws     std::out_of_range Key in the format is not in the map provided.
+ *
+ * @return     A string with all formatted tags substituted.
+ * @see        FormatMap
+ * @see        FormatTemplate
+ * @see        HashedString
+ */
+std::string FormatHashedMap(const std::string& fmt,
+                            const HashedFormatMapType& args,
+                            bool missing_tags_ok = false);
+
+/**
+ * @brief      A format which is parsed once, and can then be filled in from
+ *             many maps.
+ *
+ * @details    Building a FormatTemplate does all of the work which only
+ *             depends on the format: finding the tags, splitting off their
+ *             types and conversions, and hashing their names into
+ *             HashedStrings. Each call to Format then only looks up the
+ *             precomputed keys and writes the values. For example:
+ *
+ *                 FormatTemplate greeting("Hello, {name}!");
+ *                 for (const auto& args : people) {
+ *                   Send(greeting.Format(args));
+ *                 }
+ *
+ *             Tags are named as in FormatMap; empty tags are named by their
+ *             index, as "0", "1" and so on.
+ *
+ * @see        FormatHashedMap
+ */
+class FormatTemplate {
+ public:
+  /**
+   * @brief      Parse a format.
+   *
+   * @param[in]  fmt   The format string.
+   *
+   * @throws     std::invalid_argument Thrown if the format string is invalid.
+   */
+  explicit FormatTemplate(std::string_view fmt);
+
+  /**
+   * @brief      Fill in the tags from `args`.
+   *
+   * @param[in]  args             The values of the tags.
+   * @param[in]  missing_tags_ok  When set to true, missing tags will not cause
+   *                              an exception to be thrown.
+   *
+   * @throws     std::out_of_range Key in the format is not in the map provided.
+   *
+   * @return     The same as FormatHashedMap(fmt, args, missing_tags_ok).
+   */
+  std::string Format(const HashedFormatMapType& args,
+                     bool missing_tags_ok = false) const;
+
+ private:
+  typedef std::string_view (*EscapeFn)(std::string_view, std::string&);
+
+  // A tag, and the text before it.
+  struct Piece {
+    std::string text;
+    HashedString tag;
+    std::string type;
+    EscapeFn escape;
+  };
+
+  std::vector<Piece> pieces_;
+
+  // The text after the last tag.
+  std::string tail_;
+
+  // The length of the format string, which is recorded as the input size.
+  size_t fmt_size_;
+};
+
 /**
  * @brief      Trim any formatting tags from the given string.
  *
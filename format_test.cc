@@ -263,3 +263,105 @@ TEST(TestFormatMap, TestFormatMapDoesNotFailsWithUnrecognizedTagIfFlagSet) {
       "ABC {def}",
       string::FormatMap("{abc} {def}", {{"abc", "ABC"}}, true).c_str());
 }
+
+TEST(TestFormatMemoryResource, TestFormatAllocatesFromResource) {
+  char buffer[4096];
+  std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+                                            std::pmr::null_memory_resource());
+
+  auto result = string::Format("{} is {:.1f} metres, or {}", {"x", 1.25, 3},
+                               &arena);
+  ASSERT_EQ("x is 1.2 metres, or 3", result);
+  ASSERT_EQ(&arena, result.get_allocator().resource());
+
+  auto mapped = string::FormatMap("Hello, {name}! {missing}",
+                                  {{"name", "Sarah"}}, &arena, true);
+  ASSERT_EQ("Hello, Sarah! {missing}", mapped);
+  ASSERT_THROW(string::FormatMap("{missing}", {}, &arena), std::out_of_range);
+}
+
+struct NestedObject {
+  int value;
+};
+
+std::ostream& operator<<(std::ostream& os, const NestedObject& o) {
+  return os << string::Format("<{}>", {o.value});
+}
+
+TEST(TestFormat, TestFormatWorksWhenObjectsFormatThemselves) {
+  ASSERT_EQ("a <1> b <2>",
+            string::Format("a {} b {}", {NestedObject{1}, NestedObject{2}}));
+}
+
+TEST(TestFormatHashedMap, TestMatchesFormatMap) {
+  string::HashedFormatMapType args = {
+      {"name", "Sarah"}, {"n", 6.1423}, {"a_much_longer_tag_name", 3}};
+  ASSERT_EQ("Hello, Sarah! 6.142 3",
+            string::FormatHashedMap("Hello, {name}! {n:.3f} "
+                                    "{a_much_longer_tag_name}",
+                                    args));
+  ASSERT_EQ("{missing} Sarah",
+            string::FormatHashedMap("{missing} {name}", args, true));
+  ASSERT_THROW(string::FormatHashedMap("{missing}", args), std::out_of_range);
+}
+
+TEST(TestFormatTemplate, TestMatchesFormatHashedMap) {
+  string::FormatTemplate format(
+      "Hello, {name}! {n:.3f} {a_much_longer_tag_name} {name!html}{}.");
+  string::HashedFormatMapType sarah = {{"name", "Sarah"},
+                                       {"n", 6.1423},
+                                       {"a_much_longer_tag_name", 3},
+                                       {"0", "!"}};
+  string::HashedFormatMapType tom = {{"name", "<Tom>"},
+                                     {"n", 1.0},
+                                     {"a_much_longer_tag_name", "x"},
+                                     {"0", ""}};
+  ASSERT_EQ("Hello, Sarah! 6.142 3 Sarah!.", format.Format(sarah));
+  ASSERT_EQ("Hello, <Tom>! 1.000 x &lt;Tom&gt;.", format.Format(tom));
+
+  string::FormatTemplate copy = format;
+  ASSERT_EQ(format.Format(sarah), copy.Format(sarah));
+}
+
+TEST(TestFormatTemplate, TestErrors) {
+  ASSERT_THROW(string::FormatTemplate("{name"), std::invalid_argument);
+  ASSERT_THROW(string::FormatTemplate("name}"), std::invalid_argument);
+
+  string::FormatTemplate format("{{{missing} {name}");
+  string::HashedFormatMapType args = {{"name", "Sarah"}};
+  ASSERT_EQ("{{{missing} Sarah", format.Format(args, true));
+  ASSERT_THROW(format.Format(args), std::out_of_range);
+  ASSERT_EQ("", string::FormatTemplate("").Format(args));
+}
+
+TEST(TestFormatEscape, TestFormatEscapesValues) {
+  ASSERT_EQ("<b>A&amp;B</b>",
+            string::FormatMap("<b>{name!html}</b>", {{"name", "A&B"}}));
+  ASSERT_EQ("\"say \\\"hi\\\"\\n\"",
+            string::Format("\"{!json}\"", {"say \"hi\"\n"}));
+  ASSERT_EQ("'\\001' 'x'", string::Format("'{0!c}' '{1!c}'", {"\x01", "x"}));
+}
+
+TEST(TestFormatEscape, TestFormatEscapesAfterFormatting) {
+  ASSERT_EQ("1&lt;2", string::Format("{!html:s}", {"1<2"}));
+  ASSERT_EQ("3.14", string::Format("{!json:.2f}", {3.14159}));
+  ASSERT_EQ("&lt;1&gt;", string::Format("{!html}", {NestedObject{1}}));
+}
+
+TEST(TestFormatEscape, TestUnknownConversionIsPartOfTheTag) {
+  ASSERT_EQ("1", string::FormatMap("{a!b}", {{"a!b", 1}}));
+  ASSERT_EQ("&lt;", string::FormatMap("{a!b!html}", {{"a!b", "<"}}));
+  ASSERT_THROW(string::FormatMap("{a!b}", {{"a", 1}}), std::out_of_range);
+  ASSERT_THROW(string::Format("{!xml}", {"a"}), std::invalid_argument);
+
+  string::FormatTemplate format("{name!xml}");
+  ASSERT_EQ("1", format.Format({{"name!xml", 1}}));
+}
+
+TEST(TestFormat, TestFormatFailsWithBadIndex) {
+  ASSERT_THROW(string::Format("{x}", {1}), std::invalid_argument);
+  ASSERT_THROW(string::Format("{1x}", {1, 2}), std::invalid_argument);
+  ASSERT_THROW(string::Format("{1}", {1}), std::out_of_range);
+  ASSERT_THROW(string::Format("{99999999999999999999}", {1}),
+               std::out_of_range);
+}
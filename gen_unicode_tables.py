@@ -0,0 +1,180 @@
+"""Generates unicode_tables.h and unicode_tables.cc.
+
+The tables hold the simple (one code point to one code point) lower- and
+upper-case mappings for every code point below MAX_CODE_POINT, taken from
+fields 13 and 12 of UnicodeData.txt. These aren't the same as Python's
+str.lower() and str.upper(), which apply the full mappings from
+SpecialCasing.txt (e.g. U+0130 lowercases to "i" plus a combining dot). Each
+mapping is stored as a two-stage
+table of deltas: the first stage maps each block of code points to a block of
+deltas in the second stage, and identical blocks (most of which are all zero)
+are only stored once.
+
+Usage: python3 gen_unicode_tables.py VERSION UnicodeData.txt
+
+where UnicodeData.txt comes from
+https://www.unicode.org/Public/VERSION/ucd/UnicodeData.txt.
+"""
+
+import sys
+
+# Code points above this have no case mappings.
+MAX_CODE_POINT = 0x20000
+
+# Number of code points in each block is 1 << BLOCK_SHIFT.
+BLOCK_SHIFT = 6
+
+
+# Fields of UnicodeData.txt holding the simple upper- and lower-case mappings.
+UPPER_FIELD = 12
+LOWER_FIELD = 13
+
+
+def simple_mapping(path, field):
+  deltas = [0] * MAX_CODE_POINT
+  with open(path) as f:
+    for line in f:
+      fields = line.rstrip('\n').split(';')
+      cp = int(fields[0], 16)
+      if cp < MAX_CODE_POINT and fields[field]:
+        deltas[cp] = int(fields[field], 16) - cp
+
+  return deltas
+
+
+def two_stage(deltas):
+  block_size = 1 << BLOCK_SHIFT
+  stage1, stage2, block_index = [], [], {}
+  for start in range(0, MAX_CODE_POINT, block_size):
+    block = tuple(deltas[start:start + block_size])
+    if block not in block_index:
+      block_index[block] = len(block_index)
+      stage2.extend(block)
+
+    stage1.append(block_index[block])
+
+  assert len(block_index) <= 256
+  return stage1, stage2
+
+
+def format_array(values, per_line):
+  lines = []
+  for i in range(0, len(values), per_line):
+    lines.append('    ' + ', '.join(str(v) for v in values[i:i + per_line]) +
+                 ',')
+
+  return '\n'.join(lines)
+
+
+HEADER = '''\
+// Generated by gen_unicode_tables.py from Unicode {version}; don't edit.
+#pragma once
+
+#include <cstdint>
+
+namespace string {{
+
+// Internal; don't use directly.
+namespace internal {{
+
+// Code points at or above this have no case mappings.
+constexpr char32_t kCaseMaxCodePoint = {max_cp:#x};
+
+// Each block covers 1 << kCaseBlockShift code points.
+constexpr int kCaseBlockShift = {shift};
+
+// Two-stage tables of deltas to add to a code point to get its lower-case or
+// upper-case form. Stage 1 gives the block for a code point, and stage 2 holds
+// the deltas for each block.
+extern const uint8_t kLowerStage1[{stage1}];
+extern const int32_t kLowerStage2[{lower2}];
+extern const uint8_t kUpperStage1[{stage1}];
+extern const int32_t kUpperStage2[{upper2}];
+
+// Look up a code point in a pair of two-stage tables.
+inline char32_t CaseMapCodePoint(const uint8_t* stage1, const int32_t* stage2,
+                                 char32_t cp) {{
+  if (cp >= kCaseMaxCodePoint) {{
+    return cp;
+  }}
+
+  uint32_t block = stage1[cp >> kCaseBlockShift];
+  uint32_t offset = cp & ((1 << kCaseBlockShift) - 1);
+  return cp + stage2[(block << kCaseBlockShift) + offset];
+}}
+
+// Get the simple lower-case mapping of a code point.
+inline char32_t ToLowerCodePoint(char32_t cp) {{
+  return CaseMapCodePoint(kLowerStage1, kLowerStage2, cp);
+}}
+
+// Get the simple upper-case mapping of a code point.
+inline char32_t ToUpperCodePoint(char32_t cp) {{
+  return CaseMapCodePoint(kUpperStage1, kUpperStage2, cp);
+}}
+
+}}  // namespace internal
+
+}}  // namespace string
+'''
+
+SOURCE = '''\
+// Generated by gen_unicode_tables.py from Unicode {version}; don't edit.
+#include "unicode_tables.h"
+
+namespace string {{
+
+namespace internal {{
+
+const uint8_t kLowerStage1[{stage1}] = {{
+{lower1}
+}};
+
+const int32_t kLowerStage2[{lower2}] = {{
+{lower2_values}
+}};
+
+const uint8_t kUpperStage1[{stage1}] = {{
+{upper1}
+}};
+
+const int32_t kUpperStage2[{upper2}] = {{
+{upper2_values}
+}};
+
+}}  // namespace internal
+
+}}  // namespace string
+'''
+
+
+def main():
+  if len(sys.argv) != 3:
+    sys.exit(__doc__)
+
+  version, path = sys.argv[1:]
+  lower1, lower2 = two_stage(simple_mapping(path, LOWER_FIELD))
+  upper1, upper2 = two_stage(simple_mapping(path, UPPER_FIELD))
+
+  params = dict(
+      version=version,
+      max_cp=MAX_CODE_POINT,
+      shift=BLOCK_SHIFT,
+      stage1=len(lower1),
+      lower2=len(lower2),
+      upper2=len(upper2),
+      lower1=format_array(lower1, 16),
+      lower2_values=format_array(lower2, 8),
+      upper1=format_array(upper1, 16),
+      upper2_values=format_array(upper2, 8),
+  )
+
+  with open('unicode_tables.h', 'w') as f:
+    f.write(HEADER.format(**params))
+
+  with open('unicode_tables.cc', 'w') as f:
+    f.write(SOURCE.format(**params))
+
+
+if __name__ == '__main__':
+  main()
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace string {
+
+// Internal; don't use directly.
+namespace internal {
+
+// Hash [data, data + n) with MurmurHash64A. This isn't cryptographic, and the
+// result depends on the byte order of the machine, so it shouldn't be stored;
+// but it is fast, and mixes well enough for hash tables.
+inline uint64_t HashBytes(const char* data, size_t n) {
+  const uint64_t kMul = 0xc6a4a7935bd1e995ULL;
+  const int kShift = 47;
+
+  uint64_t h = 0x8445d61a4e774912ULL ^ (n * kMul);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    uint64_t k;
+    memcpy(&k, data + i, 8);
+    k *= kMul;
+    k ^= k >> kShift;
+    k *= kMul;
+    h ^= k;
+    h *= kMul;
+  }
+
+  if (i < n) {
+    uint64_t k = 0;
+    memcpy(&k, data + i, n - i);
+    h ^= k;
+    h *= kMul;
+  }
+
+  h ^= h >> kShift;
+  h *= kMul;
+  h ^= h >> kShift;
+  return h;
+}
+
+}  // namespace internal
+
+}  // namespace string
@@ -0,0 +1,31 @@
+#include "hashed.h"
+
+#include <stdexcept>
+
+#include <string.h>
+
+#include "hash.h"
+
+namespace string {
+
+HashedString::HashedString(std::string_view str)
+    : hash_(internal::HashBytes(str.data(), str.size())),
+      size_(static_cast<uint32_t>(str.size())) {
+  if (str.size() > UINT32_MAX) {
+    throw std::length_error("String too long for a HashedString.");
+  }
+
+  if (str.size() <= kInlineCapacity) {
+    if (!str.empty()) {
+      memcpy(inline_, str.data(), str.size());
+    }
+
+    return;
+  }
+
+  char* heap = new char[str.size()];
+  memcpy(heap, str.data(), str.size());
+  heap_.reset(heap);
+}
+
+}  // namespace string
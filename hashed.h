@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace string {
+
+/**
+ * @brief      An immutable string which knows its own hash.
+ *
+ * @details    The hash is computed once, when the string is created, so using
+ *             a HashedString as a hash table key never rehashes it. Strings of
+ *             up to kInlineCapacity bytes are stored inline, so creating one
+ *             to look up a short key doesn't allocate; longer strings are
+ *             stored on the heap, and shared between copies.
+ *
+ *                 std::unordered_map<HashedString, int> map = {{"one", 1}};
+ *                 map.find(HashedString(tag));
+ *
+ * @see        FormatHashedMap
+ */
+class HashedString {
+ public:
+  /**
+   * The longest string which is stored without allocating.
+   */
+  static constexpr size_t kInlineCapacity = 22;
+
+  HashedString() : HashedString(std::string_view()) {}
+  HashedString(std::string_view str);
+  HashedString(const char* str) : HashedString(std::string_view(str)) {}
+  HashedString(const std::string& str)
+      : HashedString(std::string_view(str)) {}
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const char* data() const { return heap_ ? heap_.get() : inline_; }
+  std::string_view view() const { return std::string_view(data(), size_); }
+
+  /**
+   * @brief      Get the cached hash of the string.
+   */
+  uint64_t hash() const { return hash_; }
+
+  friend bool operator==(const HashedString& a, const HashedString& b) {
+    return a.hash_ == b.hash_ && a.view() == b.view();
+  }
+
+  friend bool operator!=(const HashedString& a, const HashedString& b) {
+    return !(a == b);
+  }
+
+ private:
+  uint64_t hash_;
+  uint32_t size_;
+  char inline_[kInlineCapacity];
+  std::shared_ptr<const char[]> heap_;
+};
+
+}  // namespace string
+
+namespace std {
+
+template <>
+struct hash<::string::HashedString> {
+  size_t operator()(const ::string::HashedString& str) const {
+    return str.hash();
+  }
+};
+
+}  // namespace std
@@ -0,0 +1,46 @@
+#include "hashed.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <unordered_map>
+
+TEST(TestHashedString, TestShortAndLongStrings) {
+  string::HashedString empty;
+  ASSERT_TRUE(empty.empty());
+  ASSERT_EQ("", empty.view());
+
+  string::HashedString short_str("name");
+  ASSERT_EQ("name", short_str.view());
+  ASSERT_EQ(4, short_str.size());
+
+  std::string long_string(100, 'x');
+  string::HashedString long_str(long_string);
+  ASSERT_EQ(long_string, long_str.view());
+
+  // Copies of long strings share their storage.
+  string::HashedString copy = long_str;
+  ASSERT_EQ(long_str.data(), copy.data());
+  ASSERT_EQ(long_str, copy);
+}
+
+TEST(TestHashedString, TestHashIsCached) {
+  string::HashedString a("key"), b(std::string("key")), c("kez");
+  ASSERT_EQ(a.hash(), b.hash());
+  ASSERT_EQ(a, b);
+  ASSERT_NE(a, c);
+  ASSERT_EQ(a.hash(), std::hash<string::HashedString>()(a));
+
+  std::string inline_max(string::HashedString::kInlineCapacity, 'q');
+  ASSERT_EQ(string::HashedString(inline_max),
+            string::HashedString(inline_max + "q").view().substr(
+                0, inline_max.size()));
+}
+
+TEST(TestHashedString, TestAsMapKey) {
+  std::unordered_map<string::HashedString, int> map = {
+      {"one", 1}, {"two", 2}, {std::string(50, '3'), 3}};
+  ASSERT_EQ(1, map.at("one"));
+  ASSERT_EQ(3, map.at(std::string(50, '3')));
+  ASSERT_EQ(map.end(), map.find("four"));
+}
@@ -0,0 +1,358 @@
+#include "matcher.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <stdexcept>
+#include <thread>
+
+#include "ascii.h"
+
+namespace string {
+
+namespace {
+
+// Threads aren't worth starting to match fewer than this many strings each.
+constexpr size_t kMinFilterPerThread = 4096;
+
+// Read the byte at pattern[i], skipping over a `\` before it.
+unsigned char _GlobByte(std::string_view pattern, size_t& i) {
+  if (pattern[i] == '\\' && ++i == pattern.size()) {
+    throw std::invalid_argument("Glob pattern ends with an escape.");
+  }
+
+  return pattern[i++];
+}
+
+// Parse the class starting just after the `[` at pattern[i - 1], leaving `i`
+// just after its closing `]`.
+std::bitset<256> _GlobClass(std::string_view pattern, size_t& i,
+                            bool ignore_case) {
+  bool negate = i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^');
+  if (negate) {
+    i++;
+  }
+
+  std::bitset<256> bytes;
+  for (bool first = true;; first = false) {
+    if (i == pattern.size()) {
+      throw std::invalid_argument("Glob pattern has an unterminated class.");
+    }
+
+    if (pattern[i] == ']' && !first) {
+      i++;
+      break;
+    }
+
+    unsigned lo = _GlobByte(pattern, i);
+    unsigned hi = lo;
+    if (i + 1 < pattern.size() && pattern[i] == '-' && pattern[i + 1] != ']') {
+      i++;
+      hi = _GlobByte(pattern, i);
+    }
+
+    for (unsigned c = lo; c <= hi; c++) {
+      bytes.set(c);
+    }
+  }
+
+  // Fold before negating, so that [!a] doesn't match 'A' either.
+  if (ignore_case) {
+    for (unsigned c = 'a'; c <= 'z'; c++) {
+      if (bytes[c] || bytes[c ^ 0x20]) {
+        bytes.set(c).set(c ^ 0x20);
+      }
+    }
+  }
+
+  return negate ? bytes.flip() : bytes;
+}
+
+bool _BytesEqual(const char* s, const std::string& bytes, bool ignore_case) {
+  if (ignore_case) {
+    return internal::AsciiEqualsIgnoreCase(s, bytes.data(), bytes.size());
+  }
+
+  return memcmp(s, bytes.data(), bytes.size()) == 0;
+}
+
+template <typename T>
+std::vector<size_t> _Filter(const GlobMatcher& matcher,
+                            const std::vector<T>& strs, unsigned n_threads) {
+  if (n_threads == 0) {
+    n_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  n_threads = std::min<size_t>(
+      n_threads, std::max<size_t>(1, strs.size() / kMinFilterPerThread));
+  size_t chunk = (strs.size() + n_threads - 1) / n_threads;
+
+  // Each thread matches its own chunk, and then the results are joined in
+  // order.
+  std::vector<std::vector<size_t>> results(n_threads);
+  auto filter = [&](unsigned t) {
+    size_t last = std::min(strs.size(), (t + 1) * chunk);
+    for (size_t i = t * chunk; i < last; i++) {
+      if (matcher.Match(strs[i])) {
+        results[t].push_back(i);
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned t = 1; t < n_threads; t++) {
+    threads.emplace_back(filter, t);
+  }
+
+  filter(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::vector<size_t> matches = std::move(results[0]);
+  for (unsigned t = 1; t < n_threads; t++) {
+    matches.insert(matches.end(), results[t].begin(), results[t].end());
+  }
+
+  return matches;
+}
+
+}  // namespace
+
+namespace internal {
+
+ByteTrie::ByteTrie(const std::vector<std::string>& patterns, bool reverse) {
+  // Build a simple pointer-based trie first.
+  std::vector<std::map<unsigned char, int>> children(1);
+  std::vector<int32_t> pattern_at(1, -1);
+  for (size_t p = 0; p < patterns.size(); p++) {
+    int node = 0;
+    for (size_t i = 0; i < patterns[p].size(); i++) {
+      auto c = static_cast<unsigned char>(
+          patterns[p][reverse ? patterns[p].size() - 1 - i : i]);
+      auto it = children[node].find(c);
+      if (it == children[node].end()) {
+        it = children[node].emplace(c, children.size()).first;
+        children.emplace_back();
+        pattern_at.push_back(-1);
+      }
+
+      node = it->second;
+    }
+
+    if (node != 0 && pattern_at[node] < 0) {
+      pattern_at[node] = p;
+    }
+  }
+
+  // Renumber the nodes breadth first. std::map iterates in sorted order, so
+  // each node's children end up contiguous and sorted.
+  nodes_.reserve(children.size());
+  labels_.reserve(children.size());
+  nodes_.push_back({0, 0, pattern_at[0]});
+  labels_.push_back(0);
+
+  std::deque<int> queue = {0};
+  for (size_t next = 0; !queue.empty(); next++) {
+    int old_node = queue.front();
+    queue.pop_front();
+
+    nodes_[next].first_child = nodes_.size();
+    nodes_[next].n_children = children[old_node].size();
+    for (const auto& child : children[old_node]) {
+      nodes_.push_back({0, 0, pattern_at[child.second]});
+      labels_.push_back(child.first);
+      queue.push_back(child.second);
+    }
+  }
+}
+
+int ByteTrie::LongestMatch(std::string_view str, bool reverse) const {
+  int longest = -1;
+  size_t node = 0;
+  for (size_t i = 0; i < str.size(); i++) {
+    size_t pos = reverse ? str.size() - 1 - i : i;
+    auto c = static_cast<unsigned char>(str[pos]);
+    auto first = labels_.begin() + nodes_[node].first_child;
+    auto last = first + nodes_[node].n_children;
+    auto it = std::lower_bound(first, last, c);
+    if (it == last || *it != c) {
+      break;
+    }
+
+    node = it - labels_.begin();
+    if (nodes_[node].pattern >= 0) {
+      longest = nodes_[node].pattern;
+    }
+  }
+
+  return longest;
+}
+
+}  // namespace internal
+
+PrefixMatcher::PrefixMatcher(const std::vector<std::string>& prefixes)
+    : prefixes_(prefixes), trie_(prefixes, false) {}
+
+int PrefixMatcher::Match(std::string_view str) const {
+  return trie_.LongestMatch(str, false);
+}
+
+SuffixMatcher::SuffixMatcher(const std::vector<std::string>& suffixes)
+    : suffixes_(suffixes), trie_(suffixes, true) {}
+
+int SuffixMatcher::Match(std::string_view str) const {
+  return trie_.LongestMatch(str, true);
+}
+
+GlobMatcher::GlobMatcher(std::string_view pattern, bool ignore_case)
+    : pattern_(pattern), ignore_case_(ignore_case), pieces_(1), min_size_(0) {
+  for (size_t i = 0; i < pattern.size();) {
+    uint32_t atom;
+    if (pattern[i] == '*') {
+      pieces_.emplace_back();
+      i++;
+      continue;
+    } else if (pattern[i] == '?') {
+      atom = kAny;
+      i++;
+    } else if (pattern[i] == '[') {
+      atom = kClass + classes_.size();
+      classes_.push_back(_GlobClass(pattern, ++i, ignore_case_));
+    } else {
+      char c = _GlobByte(pattern, i);
+      atom = static_cast<unsigned char>(ignore_case_ ? internal::AsciiFold(c)
+                                                     : c);
+    }
+
+    pieces_.back().atoms.push_back(atom);
+  }
+
+  // The first and last pieces are anchored to the ends of the string, so they
+  // have to stay even if they're empty.
+  if (pieces_.size() > 2) {
+    pieces_.erase(std::remove_if(pieces_.begin() + 1, pieces_.end() - 1,
+                                 [](const Piece& piece) {
+                                   return piece.atoms.empty();
+                                 }),
+                  pieces_.end() - 1);
+  }
+
+  for (size_t p = 0; p < pieces_.size(); p++) {
+    const auto& atoms = pieces_[p].atoms;
+    min_size_ += atoms.size();
+    bool literal = std::all_of(atoms.begin(), atoms.end(),
+                               [](uint32_t atom) { return atom < kAny; });
+    if (literal && p > 0 && p + 1 < pieces_.size()) {
+      pieces_[p].searcher.emplace(std::string(atoms.begin(), atoms.end()),
+                                  ignore_case_);
+    }
+  }
+
+  for (uint32_t atom : pieces_.front().atoms) {
+    if (atom >= kAny) {
+      break;
+    }
+
+    prefix_ += static_cast<char>(atom);
+  }
+
+  if (pieces_.size() > 1) {
+    const auto& atoms = pieces_.back().atoms;
+    auto it = atoms.end();
+    while (it != atoms.begin() && *(it - 1) < kAny) {
+      --it;
+    }
+
+    suffix_.assign(it, atoms.end());
+  }
+}
+
+bool GlobMatcher::Match(std::string_view str) const {
+  if (str.size() < min_size_ ||
+      (pieces_.size() == 1 && str.size() != min_size_)) {
+    return false;
+  }
+
+  // Check the literal ends first, since they are the cheapest to compare.
+  size_t end = str.size() - suffix_.size();
+  if (!_BytesEqual(str.data(), prefix_, ignore_case_) ||
+      !_BytesEqual(str.data() + end, suffix_, ignore_case_)) {
+    return false;
+  }
+
+  const auto& first = pieces_.front().atoms;
+  if (!AtomsMatch(first.data() + prefix_.size(), first.data() + first.size(),
+                  str.data() + prefix_.size())) {
+    return false;
+  }
+
+  if (pieces_.size() == 1) {
+    return true;
+  }
+
+  const auto& last = pieces_.back().atoms;
+  end = str.size() - last.size();
+  if (!AtomsMatch(last.data(), last.data() + last.size() - suffix_.size(),
+                  str.data() + end)) {
+    return false;
+  }
+
+  // Each piece in the middle can match anywhere between the pieces either
+  // side of it, so the earliest match leaves the most room for the rest.
+  size_t pos = first.size();
+  for (size_t p = 1; p + 1 < pieces_.size(); p++) {
+    pos = FindPiece(pieces_[p], str, pos, end);
+    if (pos == std::string::npos) {
+      return false;
+    }
+
+    pos += pieces_[p].atoms.size();
+  }
+
+  return true;
+}
+
+std::vector<size_t> GlobMatcher::Filter(const std::vector<std::string>& strs,
+                                        unsigned n_threads) const {
+  return _Filter(*this, strs, n_threads);
+}
+
+std::vector<size_t> GlobMatcher::Filter(
+    const std::vector<std::string_view>& strs, unsigned n_threads) const {
+  return _Filter(*this, strs, n_threads);
+}
+
+bool GlobMatcher::AtomsMatch(const uint32_t* first, const uint32_t* last,
+                             const char* s) const {
+  for (; first != last; first++, s++) {
+    auto c = static_cast<unsigned char>(ignore_case_ ? internal::AsciiFold(*s)
+                                                     : *s);
+    if (*first < kAny ? c != *first
+                      : *first > kAny && !classes_[*first - kClass][c]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+size_t GlobMatcher::FindPiece(const Piece& piece, std::string_view str,
+                              size_t pos, size_t end) const {
+  if (piece.searcher) {
+    return piece.searcher->Find(str.substr(0, end), pos);
+  }
+
+  const uint32_t* atoms = piece.atoms.data();
+  for (size_t n = piece.atoms.size(); pos + n <= end; pos++) {
+    if (AtomsMatch(atoms, atoms + n, str.data() + pos)) {
+      return pos;
+    }
+  }
+
+  return std::string::npos;
+}
+
+}  // namespace string
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "search.h"
+
+namespace string {
+
+// Internal; don't use directly.
+namespace internal {
+
+// A compact, read-only trie of byte strings. Nodes are numbered breadth first,
+// so the children of each node are contiguous and sorted by their label; each
+// node only needs to store where its children start and how many there are.
+class ByteTrie {
+ public:
+  // Build a trie of `patterns`, reversing each pattern if `reverse` is set.
+  ByteTrie(const std::vector<std::string>& patterns, bool reverse);
+
+  // Walk the trie with the bytes of `str` (from the end, if `reverse` is set).
+  // Returns the index of the longest pattern seen, or -1.
+  int LongestMatch(std::string_view str, bool reverse) const;
+
+ private:
+  struct Node {
+    uint32_t first_child;
+    uint16_t n_children;
+    int32_t pattern;
+  };
+
+  std::vector<Node> nodes_;
+
+  // labels_[i] is the byte on the edge leading into node i.
+  std::vector<unsigned char> labels_;
+};
+
+}  // namespace internal
+
+/**
+ * @brief      Matches a string against many prefixes at once.
+ *
+ * @details    The prefixes are compiled into a compact trie, so matching only
+ *             looks at each byte of the input at most once, and never looks at
+ *             more bytes than the longest prefix. For example:
+ *
+ *                 PrefixMatcher matcher({"/api/", "/api/v2/", "/static/"});
+ *                 matcher.Match("/api/v2/users") -> 1
+ *                 matcher.Match("/index.html") -> -1
+ *
+ *             Empty prefixes never match, for consistency with StartsWith.
+ *
+ * @see        StartsWithAny
+ * @see        SuffixMatcher
+ */
+class PrefixMatcher {
+ public:
+  /**
+   * @brief      Build a matcher for the given prefixes.
+   *
+   * @details    If the same prefix appears more than once, only its first
+   *             index will be returned.
+   *
+   * @param[in]  prefixes  The prefixes to match.
+   */
+  explicit PrefixMatcher(const std::vector<std::string>& prefixes);
+
+  /**
+   * @brief      Find the longest prefix which `str` starts with.
+   *
+   * @param[in]  str   The string to match.
+   *
+   * @return     The index of the longest matching prefix, or -1 if there is
+   *             none.
+   */
+  int Match(std::string_view str) const;
+
+  /**
+   * @brief      Get the number of prefixes this matcher was built from.
+   */
+  size_t size() const { return prefixes_.size(); }
+
+  /**
+   * @brief      Get the prefix with the given index.
+   */
+  const std::string& prefix(size_t i) const { return prefixes_[i]; }
+
+ private:
+  std::vector<std::string> prefixes_;
+  internal::ByteTrie trie_;
+};
+
+/**
+ * @brief      Matches a string against many suffixes at once.
+ *
+ * @details    Identical to PrefixMatcher, but matches from the end of the
+ *             string. For example:
+ *
+ *                 SuffixMatcher matcher({".gz", ".tar.gz", ".zip"});
+ *                 matcher.Match("archive.tar.gz") -> 1
+ *
+ * @see        EndsWithAny
+ * @see        PrefixMatcher
+ */
+class SuffixMatcher {
+ public:
+  /**
+   * @brief      Build a matcher for the given suffixes.
+   *
+   * @param[in]  suffixes  The suffixes to match.
+   */
+  explicit SuffixMatcher(const std::vector<std::string>& suffixes);
+
+  /**
+   * @brief      Find the longest suffix which `str` ends with.
+   *
+   * @param[in]  str   The string to match.
+   *
+   * @return     The index of the longest matching suffix, or -1 if there is
+   *             none.
+   */
+  int Match(std::string_view str) const;
+
+  /**
+   * @brief      Get the number of suffixes this matcher was built from.
+   */
+  size_t size() const { return suffixes_.size(); }
+
+  /**
+   * @brief      Get the suffix with the given index.
+   */
+  const std::string& suffix(size_t i) const { return suffixes_[i]; }
+
+ private:
+  std::vector<std::string> suffixes_;
+  internal::ByteTrie trie_;
+};
+
+/**
+ * @brief      Matches strings against a shell-style wildcard pattern.
+ *
+ * @details    The pattern is compiled once, and can then be matched against
+ *             many strings. It may contain:
+ *
+ *               - `*`, which matches any run of bytes, including none;
+ *               - `?`, which matches any single byte;
+ *               - `[abc]` or `[a-z]`, which match a single byte in the class,
+ *                 and `[!a-z]` or `[^a-z]`, which match a byte outside it. A
+ *                 `]` straight after the `[` (or the `!`) is part of the class,
+ *                 as is a `-` at the start or end;
+ *               - `\`, which makes the next byte (in or out of a class) match
+ *                 literally.
+ *
+ *             The whole string has to match, and `/` and leading dots aren't
+ *             special, unlike in fnmatch. Patterns work on bytes, so `?`
+ *             matches a single byte of a multi-byte UTF-8 character. For
+ *             example:
+ *
+ *                 GlobMatcher matcher("user:*:[0-9]?");
+ *                 matcher.Match("user:alice:42") -> true
+ *                 matcher.Match("user:bob:x1") -> false
+ *
+ *             Before anything else, the length of the string is checked
+ *             against the shortest possible match, and the literal bytes at
+ *             either end of the pattern are compared directly. The rest of the
+ *             pattern is split at each `*` into fixed-length pieces, each of
+ *             which is matched at the earliest position after the previous
+ *             one. Matching never backtracks, so it takes at most time
+ *             proportional to the length of the string times the length of
+ *             the pattern, however many stars there are; pieces without
+ *             wildcards or classes are found with a Searcher.
+ *
+ * @see        Searcher
+ */
+class GlobMatcher {
+ public:
+  /**
+   * @brief      Compile a pattern.
+   *
+   * @param[in]  pattern      The pattern to match.
+   * @param[in]  ignore_case  When true, ASCII letters match regardless of
+   *                          their case, including in classes.
+   *
+   * @throws     std::invalid_argument  If a class has no closing `]`, or the
+   *                                    pattern ends with a `\`.
+   */
+  explicit GlobMatcher(std::string_view pattern, bool ignore_case = false);
+
+  /**
+   * @brief      Check whether the whole of `str` matches the pattern.
+   *
+   * @param[in]  str   The string to match.
+   *
+   * @return     `true` iff `str` matches.
+   */
+  bool Match(std::string_view str) const;
+
+  /**
+   * @brief      Find which of `strs` match the pattern.
+   *
+   * @details    Large inputs are split between `n_threads` threads; small
+   *             ones are matched on the calling thread, since starting a
+   *             thread would take longer than matching.
+   *
+   * @param[in]  strs       The strings to match.
+   * @param[in]  n_threads  The largest number of threads to match with. If 0,
+   *                        one thread per hardware thread is used.
+   *
+   * @return     The indices of the strings which match, in increasing order.
+   */
+  std::vector<size_t> Filter(const std::vector<std::string>& strs,
+                             unsigned n_threads = 1) const;
+
+  /**
+   * @brief      Find which of `strs` match the pattern.
+   * @see        Filter
+   */
+  std::vector<size_t> Filter(const std::vector<std::string_view>& strs,
+                             unsigned n_threads = 1) const;
+
+  /**
+   * @brief      Get the pattern this matcher was compiled from.
+   */
+  const std::string& pattern() const { return pattern_; }
+
+  /**
+   * @brief      Check whether this matcher ignores the case of ASCII letters.
+   */
+  bool ignore_case() const { return ignore_case_; }
+
+ private:
+  // Atoms below kAny are a byte to match (folded to lower-case if ignoring
+  // case); kAny is a `?`, and kClass + i is classes_[i].
+  static constexpr uint32_t kAny = 256;
+  static constexpr uint32_t kClass = 257;
+
+  // The part of the pattern between two stars, which always matches a fixed
+  // number of bytes.
+  struct Piece {
+    std::vector<uint32_t> atoms;
+
+    // Set if all of the atoms are bytes, so the piece can be searched for.
+    std::optional<Searcher> searcher;
+  };
+
+  // Check whether the atoms in [first, last) match the bytes at `s`.
+  bool AtomsMatch(const uint32_t* first, const uint32_t* last,
+                  const char* s) const;
+
+  // Find the first position at or after `pos` where `piece` matches, without
+  // going past `end`. Returns std::string::npos if there is none.
+  size_t FindPiece(const Piece& piece, std::string_view str, size_t pos,
+                   size_t end) const;
+
+  std::string pattern_;
+  bool ignore_case_;
+
+  // There is one more piece than there are stars, so a pattern without stars
+  // has a single piece which has to match the whole string. Empty pieces
+  // between stars are dropped, since they match anywhere.
+  std::vector<Piece> pieces_;
+  std::vector<std::bitset<256>> classes_;
+
+  // The bytes the first piece starts with and the last piece ends with. They
+  // don't overlap, so prefix_ holds the whole pattern if it has no stars.
+  std::string prefix_;
+  std::string suffix_;
+
+  // The length of the shortest string which can match.
+  size_t min_size_;
+};
+
+}  // namespace string
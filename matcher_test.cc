@@ -0,0 +1,210 @@
+#include "matcher.h"
+
+#include <gtest/gtest.h>
+
+#include "util.h"
+
+TEST(TestPrefixMatcher, TestMatchReturnsLongestPrefix) {
+  string::PrefixMatcher matcher({"/api/", "/api/v2/", "/static/"});
+  ASSERT_EQ(1, matcher.Match("/api/v2/users"));
+  ASSERT_EQ(0, matcher.Match("/api/v1/users"));
+  ASSERT_EQ(2, matcher.Match("/static/main.css"));
+}
+
+TEST(TestPrefixMatcher, TestMatchReturnsMinusOneWithoutMatch) {
+  string::PrefixMatcher matcher({"/api/", "/static/"});
+  ASSERT_EQ(-1, matcher.Match("/index.html"));
+  ASSERT_EQ(-1, matcher.Match("/api"));
+  ASSERT_EQ(-1, matcher.Match(""));
+}
+
+TEST(TestPrefixMatcher, TestMatchWithWholeString) {
+  string::PrefixMatcher matcher({"abc"});
+  ASSERT_EQ(0, matcher.Match("abc"));
+}
+
+TEST(TestPrefixMatcher, TestEmptyPrefixNeverMatches) {
+  string::PrefixMatcher matcher({"", "a"});
+  ASSERT_EQ(-1, matcher.Match("bcd"));
+  ASSERT_EQ(1, matcher.Match("abc"));
+}
+
+TEST(TestPrefixMatcher, TestDuplicatePrefixReturnsFirstIndex) {
+  string::PrefixMatcher matcher({"x", "ab", "ab"});
+  ASSERT_EQ(1, matcher.Match("abc"));
+}
+
+TEST(TestPrefixMatcher, TestMatchWithManyPrefixes) {
+  std::vector<std::string> prefixes;
+  for (int i = 0; i < 500; i++) {
+    prefixes.push_back("/" + std::to_string(i) + "/");
+  }
+
+  string::PrefixMatcher matcher(prefixes);
+  for (int i = 0; i < 500; i++) {
+    ASSERT_EQ(i, matcher.Match("/" + std::to_string(i) + "/index.html"));
+  }
+
+  ASSERT_EQ(-1, matcher.Match("/500/"));
+}
+
+TEST(TestSuffixMatcher, TestMatchReturnsLongestSuffix) {
+  string::SuffixMatcher matcher({".gz", ".tar.gz", ".zip"});
+  ASSERT_EQ(1, matcher.Match("archive.tar.gz"));
+  ASSERT_EQ(0, matcher.Match("archive.gz"));
+  ASSERT_EQ(2, matcher.Match("archive.zip"));
+  ASSERT_EQ(-1, matcher.Match("archive.tar"));
+  ASSERT_EQ(-1, matcher.Match(""));
+}
+
+TEST(TestStartsWithAny, TestStartsWithAny) {
+  string::PrefixMatcher matcher({"GET ", "POST "});
+  ASSERT_TRUE(string::StartsWithAny("GET /index.html", matcher));
+  ASSERT_FALSE(string::StartsWithAny("PUT /index.html", matcher));
+}
+
+TEST(TestEndsWithAny, TestEndsWithAny) {
+  string::SuffixMatcher matcher({".cc", ".h"});
+  ASSERT_TRUE(string::EndsWithAny("main.cc", matcher));
+  ASSERT_TRUE(string::EndsWithAny("main.h", matcher));
+  ASSERT_FALSE(string::EndsWithAny("main.py", matcher));
+}
+
+namespace {
+
+// A simple backtracking matcher for patterns of bytes, `?` and `*`.
+bool ReferenceGlobMatch(const char* pattern, const char* str) {
+  if (*pattern == '\0') {
+    return *str == '\0';
+  } else if (*pattern == '*') {
+    return ReferenceGlobMatch(pattern + 1, str) ||
+           (*str != '\0' && ReferenceGlobMatch(pattern, str + 1));
+  }
+
+  return *str != '\0' && (*pattern == '?' || *pattern == *str) &&
+         ReferenceGlobMatch(pattern + 1, str + 1);
+}
+
+}  // namespace
+
+TEST(TestGlobMatcher, TestMatch) {
+  string::GlobMatcher matcher("user:*:[0-9]?");
+  ASSERT_TRUE(matcher.Match("user:alice:42"));
+  ASSERT_TRUE(matcher.Match("user::1x"));
+  ASSERT_FALSE(matcher.Match("user:bob:x1"));
+  ASSERT_FALSE(matcher.Match("user:alice:42 "));
+  ASSERT_FALSE(matcher.Match("xuser:alice:42"));
+}
+
+TEST(TestGlobMatcher, TestMatchWithoutWildcards) {
+  ASSERT_TRUE(string::GlobMatcher("abc").Match("abc"));
+  ASSERT_FALSE(string::GlobMatcher("abc").Match("abcd"));
+  ASSERT_FALSE(string::GlobMatcher("abc").Match("ab"));
+  ASSERT_TRUE(string::GlobMatcher("").Match(""));
+  ASSERT_FALSE(string::GlobMatcher("").Match("a"));
+}
+
+TEST(TestGlobMatcher, TestMatchStars) {
+  ASSERT_TRUE(string::GlobMatcher("*").Match(""));
+  ASSERT_TRUE(string::GlobMatcher("**").Match("anything"));
+  ASSERT_TRUE(string::GlobMatcher("*.tar.gz").Match("a.tar.gz"));
+  ASSERT_TRUE(string::GlobMatcher("a*b*c").Match("abc"));
+  ASSERT_TRUE(string::GlobMatcher("a*b*c").Match("aXbYbZc"));
+  ASSERT_FALSE(string::GlobMatcher("a*b*c").Match("acb"));
+
+  // The prefix and suffix can't share bytes.
+  ASSERT_FALSE(string::GlobMatcher("ab*ba").Match("aba"));
+  ASSERT_TRUE(string::GlobMatcher("ab*ba").Match("abba"));
+}
+
+TEST(TestGlobMatcher, TestMatchClasses) {
+  string::GlobMatcher matcher("[a-cx][!0-9][]][^]]");
+  ASSERT_TRUE(matcher.Match("bz]a"));
+  ASSERT_TRUE(matcher.Match("x-]x"));
+  ASSERT_FALSE(matcher.Match("d-]a"));
+  ASSERT_FALSE(matcher.Match("a5]a"));
+  ASSERT_FALSE(matcher.Match("az]]"));
+
+  ASSERT_TRUE(string::GlobMatcher("[a-]").Match("-"));
+  ASSERT_TRUE(string::GlobMatcher("[-a]").Match("-"));
+  ASSERT_FALSE(string::GlobMatcher("[a-]").Match("b"));
+  ASSERT_TRUE(string::GlobMatcher("[*?]").Match("?"));
+  ASSERT_FALSE(string::GlobMatcher("[*?]").Match("a"));
+}
+
+TEST(TestGlobMatcher, TestMatchEscapes) {
+  ASSERT_TRUE(string::GlobMatcher("\\*\\?\\[\\\\").Match("*?[\\"));
+  ASSERT_FALSE(string::GlobMatcher("\\*").Match("a"));
+  ASSERT_TRUE(string::GlobMatcher("[\\]]").Match("]"));
+  ASSERT_TRUE(string::GlobMatcher("[\\!a]").Match("!"));
+}
+
+TEST(TestGlobMatcher, TestBadPatternThrows) {
+  ASSERT_THROW(string::GlobMatcher("[abc"), std::invalid_argument);
+  ASSERT_THROW(string::GlobMatcher("[]"), std::invalid_argument);
+  ASSERT_THROW(string::GlobMatcher("abc\\"), std::invalid_argument);
+  ASSERT_THROW(string::GlobMatcher("[a\\"), std::invalid_argument);
+}
+
+TEST(TestGlobMatcher, TestIgnoreCase) {
+  string::GlobMatcher matcher("*.JPG", true);
+  ASSERT_TRUE(matcher.Match("photo.jpg"));
+  ASSERT_TRUE(matcher.Match("PHOTO.Jpg"));
+  ASSERT_FALSE(string::GlobMatcher("*.JPG").Match("photo.jpg"));
+
+  ASSERT_TRUE(string::GlobMatcher("[a-c]*X*z", true).Match("B..x..Z"));
+  ASSERT_FALSE(string::GlobMatcher("[!a]", true).Match("A"));
+  ASSERT_TRUE(string::GlobMatcher("[!a]", true).Match("b"));
+}
+
+TEST(TestGlobMatcher, TestMatchIsLinear) {
+  // A backtracking matcher would take exponential time here.
+  std::string str(10000, 'a');
+  ASSERT_FALSE(string::GlobMatcher("*a*a*a*a*a*a*a*a*a*b").Match(str));
+  ASSERT_FALSE(string::GlobMatcher("*a?a*a?a*a?a*a?a*b").Match(str));
+  ASSERT_TRUE(string::GlobMatcher("*a*a*a*a*a*a*a*a*a*").Match(str));
+}
+
+TEST(TestGlobMatcher, TestAgainstReference) {
+  srand(1);
+  for (int i = 0; i < 20000; i++) {
+    std::string pattern, str;
+    for (int n = rand() % 8; n > 0; n--) {
+      pattern += "ab?*"[rand() % 4];
+    }
+
+    for (int n = rand() % 10; n > 0; n--) {
+      str += "ab"[rand() % 2];
+    }
+
+    ASSERT_EQ(ReferenceGlobMatch(pattern.c_str(), str.c_str()),
+              string::GlobMatcher(pattern).Match(str))
+        << pattern << " " << str;
+  }
+}
+
+TEST(TestGlobMatcher, TestFilter) {
+  string::GlobMatcher matcher("*/[0-9]*.log");
+  std::vector<std::string> strs = {"a/1.log", "a/b.log", "/22.log", "1.log"};
+  ASSERT_EQ(std::vector<size_t>({0, 2}), matcher.Filter(strs));
+
+  std::vector<std::string_view> views(strs.begin(), strs.end());
+  ASSERT_EQ(std::vector<size_t>({0, 2}), matcher.Filter(views));
+  ASSERT_EQ(std::vector<size_t>(), matcher.Filter(std::vector<std::string>()));
+}
+
+TEST(TestGlobMatcher, TestFilterWithThreads) {
+  std::vector<std::string> strs;
+  std::vector<size_t> expected;
+  for (size_t i = 0; i < 50000; i++) {
+    strs.push_back("key:" + std::to_string(i));
+    if (strs.back().size() == 8 && strs.back()[5] == '7') {
+      expected.push_back(i);
+    }
+  }
+
+  string::GlobMatcher matcher("key:?7??");
+  ASSERT_EQ(expected, matcher.Filter(strs, 1));
+  ASSERT_EQ(expected, matcher.Filter(strs, 4));
+  ASSERT_EQ(expected, matcher.Filter(strs, 0));
+}
@@ -0,0 +1,201 @@
+#include "metrics.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace string {
+
+namespace {
+
+// Only one call in this many has its latency measured, so that most calls
+// don't pay for reading the clock.
+constexpr uint32_t kLatencySampleInterval = 64;
+
+// The counters of a single function on a single thread. Only the owning thread
+// writes them, so it can add with a plain load and store, rather than an
+// atomic read-modify-write. Other threads only read them.
+struct _Counters {
+  std::atomic<uint64_t> calls{0};
+  std::atomic<uint64_t> bytes_in{0};
+  std::atomic<uint64_t> bytes_out{0};
+  std::atomic<uint64_t> allocations{0};
+  std::atomic<uint64_t> latency_samples{0};
+  std::array<std::atomic<uint64_t>, kLatencyBuckets> latency_ns{};
+};
+
+inline void _Add(std::atomic<uint64_t>& counter, uint64_t n) {
+  counter.store(counter.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+}
+
+void _AddTo(const _Counters& counters, FunctionMetrics* metrics) {
+  metrics->calls += counters.calls.load(std::memory_order_relaxed);
+  metrics->bytes_in += counters.bytes_in.load(std::memory_order_relaxed);
+  metrics->bytes_out += counters.bytes_out.load(std::memory_order_relaxed);
+  metrics->allocations +=
+      counters.allocations.load(std::memory_order_relaxed);
+  metrics->latency_samples +=
+      counters.latency_samples.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < kLatencyBuckets; i++) {
+    metrics->latency_ns[i] +=
+        counters.latency_ns[i].load(std::memory_order_relaxed);
+  }
+}
+
+struct _ThreadCounters;
+
+// Every thread's counters, plus the totals of threads which have exited.
+struct _Registry {
+  std::mutex mutex;
+  std::vector<const _ThreadCounters*> threads;
+  MetricsSnapshot exited;
+};
+
+_Registry& _GetRegistry() {
+  // Never destroyed, so that threads which exit during static destruction can
+  // still unregister.
+  static _Registry* registry = new _Registry();
+  return *registry;
+}
+
+// The counters of the calling thread, which are registered when the thread
+// first records a call, and folded into the registry when it exits.
+struct _ThreadCounters {
+  _ThreadCounters() {
+    _Registry& registry = _GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.threads.push_back(this);
+  }
+
+  ~_ThreadCounters() {
+    _Registry& registry = _GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (size_t i = 0; i < kNumMetricFunctions; i++) {
+      _AddTo(functions[i], &registry.exited.functions[i]);
+    }
+
+    auto& threads = registry.threads;
+    for (size_t i = 0; i < threads.size(); i++) {
+      if (threads[i] == this) {
+        threads[i] = threads.back();
+        threads.pop_back();
+        break;
+      }
+    }
+  }
+
+  std::array<_Counters, kNumMetricFunctions> functions;
+  uint32_t until_sample = 0;
+};
+
+_ThreadCounters& _GetThreadCounters() {
+  thread_local _ThreadCounters counters;
+  return counters;
+}
+
+// Get the histogram bucket for a latency of `ns` nanoseconds.
+size_t _LatencyBucket(uint64_t ns) {
+  size_t bucket = 0;
+  while (ns > 1 && bucket < kLatencyBuckets - 1) {
+    ns >>= 1;
+    bucket++;
+  }
+
+  return bucket;
+}
+
+}  // namespace
+
+const char* MetricFunctionName(MetricFunction function) {
+  switch (function) {
+    case MetricFunction::kSplit:
+      return "Split";
+    case MetricFunction::kSplitRight:
+      return "SplitRight";
+    case MetricFunction::kJoin:
+      return "Join";
+    case MetricFunction::kReplace:
+      return "Replace";
+    case MetricFunction::kCount:
+      return "Count";
+    case MetricFunction::kIn:
+      return "In";
+    case MetricFunction::kTrim:
+      return "Trim";
+    case MetricFunction::kToLower:
+      return "ToLower";
+    case MetricFunction::kToUpper:
+      return "ToUpper";
+    case MetricFunction::kFormat:
+      return "Format";
+    case MetricFunction::kFormatMap:
+      return "FormatMap";
+    case MetricFunction::kICount:
+      return "ICount";
+    case MetricFunction::kIIn:
+      return "IIn";
+    case MetricFunction::kIReplace:
+      return "IReplace";
+  }
+
+  return "";
+}
+
+bool MetricsEnabled() {
+#ifdef CPPSTRING_DISABLE_METRICS
+  return false;
+#else
+  return FLAGS_cppstring_metrics;
+#endif  // CPPSTRING_DISABLE_METRICS
+}
+
+MetricsSnapshot GetMetricsSnapshot() {
+  _Registry& registry = _GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  MetricsSnapshot snapshot = registry.exited;
+  for (const _ThreadCounters* thread : registry.threads) {
+    for (size_t i = 0; i < kNumMetricFunctions; i++) {
+      _AddTo(thread->functions[i], &snapshot.functions[i]);
+    }
+  }
+
+  return snapshot;
+}
+
+namespace internal {
+
+void MetricsScope::Start(MetricFunction function, size_t bytes_in) {
+  function_ = function;
+  bytes_in_ = bytes_in;
+  bytes_out_ = 0;
+  allocations_ = 0;
+
+  _ThreadCounters& counters = _GetThreadCounters();
+  sampled_ = counters.until_sample == 0;
+  if (sampled_) {
+    counters.until_sample = kLatencySampleInterval;
+    start_ = std::chrono::steady_clock::now();
+  }
+
+  counters.until_sample--;
+}
+
+void MetricsScope::Finish() {
+  _Counters& counters =
+      _GetThreadCounters().functions[static_cast<size_t>(function_)];
+  _Add(counters.calls, 1);
+  _Add(counters.bytes_in, bytes_in_);
+  _Add(counters.bytes_out, bytes_out_);
+  _Add(counters.allocations, allocations_);
+
+  if (sampled_) {
+    auto elapsed = std::chrono::steady_clock::now() - start_;
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+    _Add(counters.latency_samples, 1);
+    _Add(counters.latency_ns[_LatencyBucket(ns.count())], 1);
+  }
+}
+
+}  // namespace internal
+
+}  // namespace string
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+
+DECLARE_bool(cppstring_metrics);
+
+namespace string {
+
+/**
+ * The functions which record metrics.
+ * @see        GetMetricsSnapshot
+ */
+enum class MetricFunction {
+  kSplit,
+  kSplitRight,
+  kJoin,
+  kReplace,
+  kCount,
+  kIn,
+  kTrim,
+  kToLower,
+  kToUpper,
+  kFormat,
+  kFormatMap,
+  kICount,
+  kIIn,
+  kIReplace,
+};
+
+constexpr size_t kNumMetricFunctions =
+    static_cast<size_t>(MetricFunction::kIReplace) + 1;
+
+/**
+ * The number of latency histogram buckets. Bucket i counts calls which took
+ * [2^i, 2^(i + 1)) nanoseconds, except the last, which counts everything
+ * longer.
+ */
+constexpr size_t kLatencyBuckets = 32;
+
+/**
+ * Metrics for a single function, summed over all threads.
+ */
+struct FunctionMetrics {
+  // The number of calls.
+  uint64_t calls = 0;
+
+  // The total length of the inputs and of the results, in bytes.
+  uint64_t bytes_in = 0;
+  uint64_t bytes_out = 0;
+
+  // The number of heap blocks the results needed: one for each string too
+  // long for the small string buffer, and one for each non-empty vector.
+  uint64_t allocations = 0;
+
+  // A histogram of the latency of a sample of the calls.
+  uint64_t latency_samples = 0;
+  std::array<uint64_t, kLatencyBuckets> latency_ns = {};
+};
+
+/**
+ * The metrics of every function at a point in time.
+ */
+struct MetricsSnapshot {
+  std::array<FunctionMetrics, kNumMetricFunctions> functions;
+
+  const FunctionMetrics& operator[](MetricFunction function) const {
+    return functions[static_cast<size_t>(function)];
+  }
+};
+
+/**
+ * @brief      Get the name of a function, e.g. "Split".
+ */
+const char* MetricFunctionName(MetricFunction function);
+
+/**
+ * @brief      Check whether metrics are being recorded.
+ *
+ * @details    Metrics are recorded iff the library was built without
+ *             CPPSTRING_DISABLE_METRICS and --cppstring_metrics is set. When
+ *             the flag is off, each instrumented call costs a single branch;
+ *             when the library is built with CPPSTRING_DISABLE_METRICS, it
+ *             costs nothing at all.
+ */
+bool MetricsEnabled();
+
+/**
+ * @brief      Get the metrics recorded so far by every thread.
+ *
+ * @details    Each thread records into its own counters without any locking
+ *             or atomic read-modify-write operations, and this sums them up,
+ *             so it is cheap to call from a metrics exporter every few
+ *             seconds:
+ *
+ *                 auto snapshot = GetMetricsSnapshot();
+ *                 for (size_t i = 0; i < kNumMetricFunctions; i++) {
+ *                   auto function = static_cast<MetricFunction>(i);
+ *                   Export(MetricFunctionName(function), snapshot[function]);
+ *                 }
+ *
+ *             Counters only ever increase, so rates can be computed from the
+ *             difference between two snapshots. Counters of calls which are in
+ *             progress on other threads may or may not be included.
+ *
+ * @return     The metrics of every function.
+ */
+MetricsSnapshot GetMetricsSnapshot();
+
+// Internal; don't use directly.
+namespace internal {
+
+// Add the size and number of heap blocks of a result to `bytes` and
+// `allocations`.
+// These take any allocator, so that results from a memory resource count too.
+template <typename Alloc>
+void AddOutput(
+    const std::basic_string<char, std::char_traits<char>, Alloc>& result,
+    uint64_t* bytes, uint64_t* allocations) {
+  *bytes += result.size();
+  *allocations += result.capacity() > std::string().capacity();
+}
+
+template <typename String, typename Alloc>
+void AddOutput(const std::vector<String, Alloc>& result, uint64_t* bytes,
+               uint64_t* allocations) {
+  *allocations += !result.empty();
+  for (const auto& piece : result) {
+    AddOutput(piece, bytes, allocations);
+  }
+}
+
+// Records a single call of `function` into the calling thread's counters,
+// from construction until destruction. Nothing else is touched unless metrics
+// are enabled.
+class MetricsScope {
+ public:
+  MetricsScope(MetricFunction function, size_t bytes_in)
+      : enabled_(FLAGS_cppstring_metrics) {
+    if (enabled_) {
+      Start(function, bytes_in);
+    }
+  }
+
+  ~MetricsScope() {
+    if (enabled_) {
+      Finish();
+    }
+  }
+
+  MetricsScope(const MetricsScope&) = delete;
+  MetricsScope& operator=(const MetricsScope&) = delete;
+
+  void Input(size_t bytes_in) {
+    if (enabled_) {
+      bytes_in_ += bytes_in;
+    }
+  }
+
+  template <typename Result>
+  void Output(const Result& result) {
+    if (enabled_) {
+      AddOutput(result, &bytes_out_, &allocations_);
+    }
+  }
+
+ private:
+  void Start(MetricFunction function, size_t bytes_in);
+  void Finish();
+
+  bool enabled_;
+  bool sampled_;
+  MetricFunction function_;
+  uint64_t bytes_in_;
+  uint64_t bytes_out_;
+  uint64_t allocations_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace internal
+
+}  // namespace string
+
+// Record metrics for the rest of the enclosing function, as `scope`.
+// CPPSTRING_METRICS_INPUT(scope, bytes) adds to the size of the input, and
+// CPPSTRING_METRICS_OUTPUT(scope, result) records the size of the result.
+#ifdef CPPSTRING_DISABLE_METRICS
+#define CPPSTRING_METRICS_SCOPE(scope, function, bytes_in) \
+  do {                                                     \
+  } while (0)
+#define CPPSTRING_METRICS_INPUT(scope, bytes) \
+  do {                                        \
+  } while (0)
+#define CPPSTRING_METRICS_OUTPUT(scope, result) \
+  do {                                          \
+  } while (0)
+#else
+#define CPPSTRING_METRICS_SCOPE(scope, function, bytes_in) \
+  ::string::internal::MetricsScope scope(function, bytes_in)
+#define CPPSTRING_METRICS_INPUT(scope, bytes) scope.Input(bytes)
+#define CPPSTRING_METRICS_OUTPUT(scope, result) scope.Output(result)
+#endif  // CPPSTRING_DISABLE_METRICS
@@ -0,0 +1,187 @@
+#include "metrics.h"
+
+#include <gtest/gtest.h>
+
+#include <memory_resource>
+#include <thread>
+
+#include "format.h"
+#include "split.h"
+#include "util.h"
+
+namespace {
+
+// Enables metrics for the duration of a test.
+class ScopedEnableMetrics {
+ public:
+  ScopedEnableMetrics() { FLAGS_cppstring_metrics = true; }
+  ~ScopedEnableMetrics() { FLAGS_cppstring_metrics = false; }
+};
+
+}  // namespace
+
+TEST(TestMetrics, TestDisabledByDefault) {
+  ASSERT_FALSE(string::MetricsEnabled());
+
+  auto before = string::GetMetricsSnapshot();
+  string::Split("a,b,c", ",");
+  auto after = string::GetMetricsSnapshot();
+  ASSERT_EQ(before[string::MetricFunction::kSplit].calls,
+            after[string::MetricFunction::kSplit].calls);
+}
+
+TEST(TestMetrics, TestCountsCallsAndBytes) {
+  ScopedEnableMetrics enable;
+  ASSERT_TRUE(string::MetricsEnabled());
+
+  auto before = string::GetMetricsSnapshot();
+  std::string long_piece(100, 'x');
+  string::Split("a,b," + long_piece, ",");
+  string::Join({"ab", "cd"}, ", ");
+  string::ToLower("HELLO");
+  string::Format("{}-{}", {1, 2});
+  auto after = string::GetMetricsSnapshot();
+
+  auto split = after[string::MetricFunction::kSplit];
+  split.calls -= before[string::MetricFunction::kSplit].calls;
+  split.bytes_in -= before[string::MetricFunction::kSplit].bytes_in;
+  split.bytes_out -= before[string::MetricFunction::kSplit].bytes_out;
+  split.allocations -= before[string::MetricFunction::kSplit].allocations;
+  ASSERT_EQ(1, split.calls);
+  ASSERT_EQ(104, split.bytes_in);
+  ASSERT_EQ(102, split.bytes_out);
+
+  // The vector and the long piece.
+  ASSERT_EQ(2, split.allocations);
+
+  auto delta = [&](string::MetricFunction function) {
+    return std::make_pair(after[function].calls - before[function].calls,
+                          after[function].bytes_in - before[function].bytes_in);
+  };
+
+  ASSERT_EQ(std::make_pair(uint64_t{1}, uint64_t{4}),
+            delta(string::MetricFunction::kJoin));
+  ASSERT_EQ(std::make_pair(uint64_t{1}, uint64_t{5}),
+            delta(string::MetricFunction::kToLower));
+  ASSERT_EQ(std::make_pair(uint64_t{1}, uint64_t{5}),
+            delta(string::MetricFunction::kFormat));
+}
+
+TEST(TestMetrics, TestMergesThreadsAndSamplesLatency) {
+  ScopedEnableMetrics enable;
+  auto before = string::GetMetricsSnapshot()[string::MetricFunction::kCount];
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([] {
+      for (int i = 0; i < 1000; i++) {
+        string::Count("abcabc", "bc");
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto after = string::GetMetricsSnapshot()[string::MetricFunction::kCount];
+  ASSERT_EQ(4000, after.calls - before.calls);
+  ASSERT_EQ(24000, after.bytes_in - before.bytes_in);
+
+  uint64_t samples = after.latency_samples - before.latency_samples;
+  ASSERT_GT(samples, 0);
+  ASSERT_LT(samples, 4000);
+
+  uint64_t bucketed = 0;
+  for (size_t i = 0; i < string::kLatencyBuckets; i++) {
+    bucketed += after.latency_ns[i] - before.latency_ns[i];
+  }
+
+  ASSERT_EQ(samples, bucketed);
+}
+
+TEST(TestMetrics, TestOnlyRecordsTheFunctionCalled) {
+  ScopedEnableMetrics enable;
+  auto before = string::GetMetricsSnapshot();
+  string::Format("a{}-{}b", {1, 2});
+  string::FormatMap("{x:d}}}", {{"x", 1}});
+  string::ICount("aAa", "a");
+  string::IIn("aAa", "a");
+  string::IReplace("aAa", "a", "b");
+  auto after = string::GetMetricsSnapshot();
+
+  auto calls = [&](string::MetricFunction function) {
+    return after[function].calls - before[function].calls;
+  };
+
+  // Neither Format nor the case-insensitive functions are recorded as the
+  // functions they use internally.
+  ASSERT_EQ(0, calls(string::MetricFunction::kCount));
+  ASSERT_EQ(0, calls(string::MetricFunction::kIn));
+  ASSERT_EQ(0, calls(string::MetricFunction::kReplace));
+  ASSERT_EQ(1, calls(string::MetricFunction::kFormat));
+  ASSERT_EQ(1, calls(string::MetricFunction::kFormatMap));
+  ASSERT_EQ(1, calls(string::MetricFunction::kICount));
+  ASSERT_EQ(1, calls(string::MetricFunction::kIIn));
+  ASSERT_EQ(1, calls(string::MetricFunction::kIReplace));
+}
+
+TEST(TestMetrics, TestRecordsEveryOverload) {
+  ScopedEnableMetrics enable;
+  std::pmr::memory_resource* resource = std::pmr::new_delete_resource();
+  string::HashedFormatMapType args = {{"x", 1}};
+  string::FormatTemplate format("{x}{x}");
+  std::string long_piece(100, 'x');
+
+  auto before = string::GetMetricsSnapshot();
+  string::Count("", "a");
+  string::Count("abc", "");
+  string::In("abc", "");
+  string::Split("a,b," + long_piece, resource, ",");
+  string::SplitRight("a,b", resource, ",");
+  string::Join(std::vector<std::string>{"ab", "cd"}, ", ", resource);
+  string::Join(std::pmr::vector<std::pmr::string>{"ab", "cd"}, ", ", resource);
+  string::Format("{}", {1}, resource);
+  string::FormatMap("{x}", {{"x", 1}}, resource);
+  string::FormatHashedMap("{x}", args);
+  format.Format(args);
+  string::Replace("abc", "b", "d", resource);
+  string::Trim(" a ", " ", resource);
+  string::TrimRight(" a ", " ", resource);
+  string::TrimLeft(" a ", " ", resource);
+  auto after = string::GetMetricsSnapshot();
+
+  auto calls = [&](string::MetricFunction function) {
+    return after[function].calls - before[function].calls;
+  };
+
+  ASSERT_EQ(2, calls(string::MetricFunction::kCount));
+  ASSERT_EQ(1, calls(string::MetricFunction::kIn));
+  ASSERT_EQ(1, calls(string::MetricFunction::kSplit));
+  ASSERT_EQ(1, calls(string::MetricFunction::kSplitRight));
+  ASSERT_EQ(2, calls(string::MetricFunction::kJoin));
+  ASSERT_EQ(1, calls(string::MetricFunction::kFormat));
+  ASSERT_EQ(3, calls(string::MetricFunction::kFormatMap));
+  ASSERT_EQ(1, calls(string::MetricFunction::kReplace));
+  ASSERT_EQ(3, calls(string::MetricFunction::kTrim));
+
+  // Results from a memory resource are measured like any other: the pmr Split
+  // needed the vector and the long piece.
+  auto split = string::MetricFunction::kSplit;
+  ASSERT_EQ(102, after[split].bytes_out - before[split].bytes_out);
+  ASSERT_EQ(2, after[split].allocations - before[split].allocations);
+
+  // The template records the length of the string it was built from.
+  auto format_map = string::MetricFunction::kFormatMap;
+  ASSERT_EQ(12, after[format_map].bytes_in - before[format_map].bytes_in);
+  ASSERT_EQ(4, after[format_map].bytes_out - before[format_map].bytes_out);
+}
+
+TEST(TestMetrics, TestFunctionNames) {
+  ASSERT_STREQ("Split",
+               string::MetricFunctionName(string::MetricFunction::kSplit));
+  ASSERT_STREQ("FormatMap",
+               string::MetricFunctionName(string::MetricFunction::kFormatMap));
+  ASSERT_STREQ("IReplace",
+               string::MetricFunctionName(string::MetricFunction::kIReplace));
+}
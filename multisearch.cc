@@ -0,0 +1,108 @@
+#include "multisearch.h"
+
+#include <deque>
+
+namespace string {
+
+MultiSearcher::MultiSearcher(const std::vector<std::string>& patterns)
+    : patterns_(patterns) {
+  // Give every byte which appears in a pattern its own column. Everything else
+  // shares column 0.
+  for (auto& c : classes_) {
+    c = 0;
+  }
+
+  n_classes_ = 1;
+  for (const auto& pattern : patterns_) {
+    for (char c : pattern) {
+      auto& cls = classes_[static_cast<unsigned char>(c)];
+      if (cls == 0) {
+        cls = n_classes_++;
+      }
+    }
+  }
+
+  // Build the trie. Missing transitions are marked with -1 for now.
+  delta_.assign(n_classes_, -1);
+  depth_.push_back(0);
+  output_.push_back(-1);
+  for (size_t p = 0; p < patterns_.size(); p++) {
+    int32_t state = 0;
+    for (char c : patterns_[p]) {
+      size_t cls = classes_[static_cast<unsigned char>(c)];
+      if (delta_[state * n_classes_ + cls] < 0) {
+        delta_[state * n_classes_ + cls] = depth_.size();
+        delta_.resize(delta_.size() + n_classes_, -1);
+        depth_.push_back(depth_[state] + 1);
+        output_.push_back(-1);
+      }
+
+      state = delta_[state * n_classes_ + cls];
+    }
+
+    if (state != 0 && output_[state] < 0) {
+      output_[state] = p;
+    }
+  }
+
+  // Walk the trie breadth first, filling in the missing transitions from each
+  // state's failure state. Since the failure state is always shallower, it has
+  // already been completed by the time we get to it.
+  std::vector<int32_t> fail(depth_.size(), 0);
+  std::deque<int32_t> queue;
+  for (size_t cls = 0; cls < n_classes_; cls++) {
+    int32_t& next = delta_[cls];
+    if (next < 0) {
+      next = 0;
+    } else {
+      queue.push_back(next);
+    }
+  }
+
+  while (!queue.empty()) {
+    int32_t state = queue.front();
+    queue.pop_front();
+
+    // A state's own pattern is the longest suffix; otherwise inherit the
+    // longest one from the failure state.
+    if (output_[state] < 0) {
+      output_[state] = output_[fail[state]];
+    }
+
+    for (size_t cls = 0; cls < n_classes_; cls++) {
+      int32_t& next = delta_[state * n_classes_ + cls];
+      int32_t fail_next = delta_[fail[state] * n_classes_ + cls];
+      if (next < 0) {
+        next = fail_next;
+      } else {
+        fail[next] = fail_next;
+        queue.push_back(next);
+      }
+    }
+  }
+}
+
+std::vector<MultiSearcher::Match> MultiSearcher::FindAll(
+    std::string_view text) const {
+  std::vector<Match> matches;
+  ForEachMatch(text, [&matches](const Match& match) {
+    matches.push_back(match);
+    return true;
+  });
+
+  return matches;
+}
+
+bool MultiSearcher::MatchesAny(std::string_view text) const {
+  int32_t state = 0;
+  for (char c : text) {
+    state = Next(state, c);
+    if (output_[state] >= 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+}  // namespace string
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace string {
+
+/**
+ * @brief      A searcher for many patterns at once, built once and reused
+ *             across many haystacks.
+ *
+ * @details    The patterns are compiled into an Aho-Corasick automaton, stored
+ *             as a flat DFA transition table. To keep the table small, bytes
+ *             which never appear in any pattern share a single column, so the
+ *             table only has one column per distinct pattern byte. Searching
+ *             never backtracks, so the cost of a search is independent of the
+ *             number of patterns.
+ *
+ *             Matches are reported with leftmost-longest semantics: of all
+ *             matches, the one starting earliest is reported, and if several
+ *             start at the same place, the longest one wins. Matching then
+ *             continues after the end of that match, so matches never overlap.
+ *             For example, with patterns {"ab", "abcd", "bc"}:
+ *
+ *                 "abcd" -> {"abcd"}
+ *                 "abc"  -> {"ab"}
+ *                 "xbcd" -> {"bc"}
+ *
+ *             Empty patterns never match.
+ *
+ * @see        InAny
+ * @see        CountAll
+ * @see        ReplaceMany
+ */
+class MultiSearcher {
+ public:
+  /**
+   * A single match of a pattern.
+   */
+  struct Match {
+    // The index of the pattern which matched.
+    size_t pattern;
+
+    // The position and length of the match within the haystack.
+    size_t start;
+    size_t length;
+  };
+
+  /**
+   * @brief      Build a searcher for the given patterns.
+   *
+   * @details    If the same pattern appears more than once, only its first
+   *             index will be reported in matches.
+   *
+   * @param[in]  patterns  The patterns to search for.
+   */
+  explicit MultiSearcher(const std::vector<std::string>& patterns);
+
+  /**
+   * @brief      Find all non-overlapping, leftmost-longest matches in `text`.
+   *
+   * @param[in]  text  The string to search.
+   *
+   * @return     All matches, in the order they occur in `text`.
+   */
+  std::vector<Match> FindAll(std::string_view text) const;
+
+  /**
+   * @brief      Check whether any pattern occurs anywhere in `text`.
+   *
+   * @details    This stops at the first match of any pattern, so it is cheaper
+   *             than FindAll.
+   *
+   * @param[in]  text  The string to search.
+   *
+   * @return     `true` iff at least one pattern occurs in `text`.
+   */
+  bool MatchesAny(std::string_view text) const;
+
+  /**
+   * @brief      Call `fn(match)` for each non-overlapping, leftmost-longest
+   *             match in `text`, in order.
+   *
+   * @param[in]  text  The string to search.
+   * @param[in]  fn    Called for each match. Should return `false` to stop
+   *                   searching.
+   */
+  template <typename MatchFn>
+  void ForEachMatch(std::string_view text, const MatchFn& fn) const;
+
+  /**
+   * @brief      Get the number of patterns this searcher was built from.
+   */
+  size_t size() const { return patterns_.size(); }
+
+  /**
+   * @brief      Get the pattern with the given index.
+   */
+  const std::string& pattern(size_t i) const { return patterns_[i]; }
+
+ private:
+  int32_t Next(int32_t state, char c) const {
+    return delta_[state * n_classes_ + classes_[static_cast<unsigned char>(c)]];
+  }
+
+  std::vector<std::string> patterns_;
+
+  // Maps each byte to its column in the transition table.
+  uint16_t classes_[256];
+  size_t n_classes_;
+
+  // delta_[state * n_classes_ + class] is the next state.
+  std::vector<int32_t> delta_;
+
+  // The length of the string each state represents.
+  std::vector<uint32_t> depth_;
+
+  // The longest pattern which is a suffix of each state, or -1.
+  std::vector<int32_t> output_;
+};
+
+template <typename MatchFn>
+void MultiSearcher::ForEachMatch(std::string_view text,
+                                 const MatchFn& fn) const {
+  size_t i = 0;
+  while (i < text.size()) {
+    bool found = false;
+    Match best = {0, 0, 0};
+
+    int32_t state = 0;
+    for (size_t j = i; j < text.size(); j++) {
+      state = Next(state, text[j]);
+
+      // The longest pattern ending here is also the one starting leftmost, so
+      // it is the only one worth looking at.
+      int32_t p = output_[state];
+      if (p >= 0) {
+        size_t length = patterns_[p].size();
+        size_t start = j + 1 - length;
+        if (!found || start <= best.start) {
+          best = {static_cast<size_t>(p), start, length};
+          found = true;
+        }
+      }
+
+      // Every match we haven't seen yet starts within the last depth_[state]
+      // characters. Once those all start after the best match, it can't be
+      // beaten.
+      if (found && best.start + depth_[state] < j + 1) {
+        break;
+      }
+    }
+
+    if (!found || !fn(best)) {
+      return;
+    }
+
+    // Restart the automaton after the match, so that matches never overlap.
+    i = best.start + best.length;
+  }
+}
+
+}  // namespace string
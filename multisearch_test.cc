@@ -0,0 +1,144 @@
+#include "multisearch.h"
+
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "util.h"
+
+namespace {
+
+// Straightforward leftmost-longest search, used to check the automaton.
+std::vector<std::pair<size_t, size_t>> NaiveFindAll(
+    const std::string& text, const std::vector<std::string>& patterns) {
+  std::vector<std::pair<size_t, size_t>> matches;
+  size_t i = 0;
+  while (i < text.size()) {
+    bool found = false;
+    for (size_t start = i; start < text.size() && !found; start++) {
+      size_t best = 0;
+      for (const auto& pattern : patterns) {
+        if (!pattern.empty() && pattern.size() > best &&
+            text.compare(start, pattern.size(), pattern) == 0) {
+          best = pattern.size();
+        }
+      }
+
+      if (best > 0) {
+        matches.emplace_back(start, best);
+        i = start + best;
+        found = true;
+      }
+    }
+
+    if (!found) {
+      break;
+    }
+  }
+
+  return matches;
+}
+
+}  // namespace
+
+TEST(TestMultiSearcher, TestFindAllSimple) {
+  string::MultiSearcher searcher({"he", "she", "his", "hers"});
+  auto matches = searcher.FindAll("ushers");
+  ASSERT_EQ(1, matches.size());
+  ASSERT_EQ(1, matches[0].pattern);
+  ASSERT_EQ(1, matches[0].start);
+  ASSERT_EQ(3, matches[0].length);
+}
+
+TEST(TestMultiSearcher, TestFindAllLeftmostLongest) {
+  string::MultiSearcher searcher({"ab", "abcd", "bc"});
+  ASSERT_EQ(1, searcher.FindAll("abcd").at(0).pattern);
+  ASSERT_EQ(0, searcher.FindAll("abc").at(0).pattern);
+  ASSERT_EQ(2, searcher.FindAll("xbcd").at(0).pattern);
+}
+
+TEST(TestMultiSearcher, TestFindAllPrefersEarlierStartOverEarlierEnd) {
+  string::MultiSearcher searcher({"bcd", "abcde"});
+  auto matches = searcher.FindAll("xabcdex");
+  ASSERT_EQ(1, matches.size());
+  ASSERT_EQ(1, matches[0].pattern);
+  ASSERT_EQ(1, matches[0].start);
+}
+
+TEST(TestMultiSearcher, TestFindAllWithNoPatterns) {
+  string::MultiSearcher searcher({});
+  ASSERT_TRUE(searcher.FindAll("abc").empty());
+  ASSERT_FALSE(searcher.MatchesAny("abc"));
+}
+
+TEST(TestMultiSearcher, TestEmptyPatternsNeverMatch) {
+  string::MultiSearcher searcher({"", "b"});
+  auto matches = searcher.FindAll("abc");
+  ASSERT_EQ(1, matches.size());
+  ASSERT_EQ(1, matches[0].pattern);
+}
+
+TEST(TestMultiSearcher, TestFindAllMatchesNaiveSearch) {
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> letter(0, 2), length(1, 4);
+  for (int round = 0; round < 200; round++) {
+    std::vector<std::string> patterns(1 + round % 6);
+    for (auto& pattern : patterns) {
+      for (int i = length(rng); i > 0; i--) {
+        pattern += static_cast<char>('a' + letter(rng));
+      }
+    }
+
+    std::string text;
+    for (int i = 0; i < 40; i++) {
+      text += static_cast<char>('a' + letter(rng));
+    }
+
+    string::MultiSearcher searcher(patterns);
+    auto expected = NaiveFindAll(text, patterns);
+    auto matches = searcher.FindAll(text);
+    ASSERT_EQ(expected.size(), matches.size()) << text;
+    for (size_t i = 0; i < matches.size(); i++) {
+      ASSERT_EQ(expected[i].first, matches[i].start) << text;
+      ASSERT_EQ(expected[i].second, matches[i].length) << text;
+      ASSERT_EQ(patterns[matches[i].pattern],
+                text.substr(matches[i].start, matches[i].length));
+    }
+  }
+}
+
+TEST(TestInAny, TestInAny) {
+  string::MultiSearcher searcher({"foo", "bar"});
+  ASSERT_TRUE(string::InAny("xxbarxx", searcher));
+  ASSERT_TRUE(string::InAny("foo", searcher));
+  ASSERT_FALSE(string::InAny("fobaxx", searcher));
+  ASSERT_FALSE(string::InAny("", searcher));
+}
+
+TEST(TestCountAll, TestCountAll) {
+  string::MultiSearcher searcher({"ab", "bc", "c"});
+  std::vector<int> out{2, 0, 1};
+  ASSERT_EQ(out, string::CountAll("abcab", searcher));
+}
+
+TEST(TestReplaceMany, TestReplaceManySwapsWords) {
+  ASSERT_STREQ(
+      "dog cat",
+      string::ReplaceMany("cat dog", {{"cat", "dog"}, {"dog", "cat"}}).c_str());
+}
+
+TEST(TestReplaceMany, TestReplaceManyUsesLongestMatch) {
+  ASSERT_STREQ("[abc]d[a]",
+               string::ReplaceMany("abcda", {{"a", "[a]"}, {"abc", "[abc]"}})
+                   .c_str());
+}
+
+TEST(TestReplaceMany, TestReplaceManyWithNoMatches) {
+  ASSERT_STREQ("xyz", string::ReplaceMany("xyz", {{"a", "b"}}).c_str());
+}
+
+TEST(TestReplaceMany, TestReplaceManyWithMismatchedReplacements) {
+  string::MultiSearcher searcher({"a", "b"});
+  ASSERT_THROW(string::ReplaceMany("ab", searcher, {"x"}),
+               std::invalid_argument);
+}
@@ -0,0 +1,171 @@
+#include "parse.h"
+
+#include <charconv>
+#include <system_error>
+
+#include <string.h>
+
+// Converting 8 digits within a word relies on the first digit being in the
+// lowest byte.
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || \
+    defined(_M_X64) || defined(_M_IX86) || defined(_M_ARM64)
+#define CPPSTRING_SWAR_DIGITS 1
+#endif
+
+namespace string {
+
+namespace {
+
+// The value of each character as a digit, or 255 if it isn't one. Letters
+// are digits from 10 upwards, in either case.
+struct _DigitTable {
+  uint8_t values[256];
+};
+
+constexpr _DigitTable _MakeDigitTable() {
+  _DigitTable table = {};
+  for (int c = 0; c < 256; c++) {
+    table.values[c] = 255;
+  }
+
+  for (int i = 0; i < 10; i++) {
+    table.values['0' + i] = i;
+  }
+
+  for (int i = 0; i < 26; i++) {
+    table.values['a' + i] = 10 + i;
+    table.values['A' + i] = 10 + i;
+  }
+
+  return table;
+}
+
+constexpr _DigitTable kDigitTable = _MakeDigitTable();
+
+#ifdef CPPSTRING_SWAR_DIGITS
+
+// Check whether all 8 bytes of `chunk` are decimal digits. A byte is a digit
+// iff its high nibble is 3, and adding 6 doesn't carry out of its low nibble.
+inline bool _IsEightDigits(uint64_t chunk) {
+  return ((chunk & 0xf0f0f0f0f0f0f0f0ULL) |
+          (((chunk + 0x0606060606060606ULL) & 0xf0f0f0f0f0f0f0f0ULL) >> 4)) ==
+         0x3333333333333333ULL;
+}
+
+// Convert 8 decimal digits to their value in three multiplies, by combining
+// pairs of digits, then pairs of pairs, and so on.
+inline uint32_t _ParseEightDigits(uint64_t chunk) {
+  chunk -= 0x3030303030303030ULL;
+  chunk = chunk * 10 + (chunk >> 8);
+
+  const uint64_t kMask = 0x000000ff000000ffULL;
+  const uint64_t kMul1 = 100 + (1000000ULL << 32);
+  const uint64_t kMul2 = 1 + (10000ULL << 32);
+  return static_cast<uint32_t>(
+      ((chunk & kMask) * kMul1 + ((chunk >> 16) & kMask) * kMul2) >> 32);
+}
+
+#endif  // CPPSTRING_SWAR_DIGITS
+
+}  // namespace
+
+namespace internal {
+
+ParseError ParseMagnitude(std::string_view digits, int base, uint64_t max,
+                          uint64_t* value) {
+  if (base == 0) {
+    if (digits.size() > 1 && digits[0] == '0' &&
+        (digits[1] == 'x' || digits[1] == 'X')) {
+      base = 16;
+      digits.remove_prefix(2);
+    } else if (digits.size() > 1 && digits[0] == '0') {
+      base = 8;
+      digits.remove_prefix(1);
+    } else {
+      base = 10;
+    }
+  }
+
+  if (base < 2 || base > 36 || digits.empty()) {
+    return ParseError::kInvalid;
+  }
+
+  uint64_t result = 0;
+  size_t i = 0;
+
+#ifdef CPPSTRING_SWAR_DIGITS
+  // 16 decimal digits can't overflow, so convert up to that many 8 at a time.
+  // Anything else is left to the loop below.
+  if (base == 10) {
+    for (; i < 16 && i + 8 <= digits.size(); i += 8) {
+      uint64_t chunk;
+      memcpy(&chunk, digits.data() + i, 8);
+      if (!_IsEightDigits(chunk)) {
+        break;
+      }
+
+      result = result * 100000000 + _ParseEightDigits(chunk);
+    }
+  }
+#endif  // CPPSTRING_SWAR_DIGITS
+
+  // Keep checking the digits after an overflow, so that an invalid number is
+  // reported as invalid rather than out of range.
+  const uint64_t limit = UINT64_MAX / base;
+  bool overflow = false;
+  for (; i < digits.size(); i++) {
+    unsigned digit = kDigitTable.values[static_cast<unsigned char>(digits[i])];
+    if (digit >= static_cast<unsigned>(base)) {
+      return ParseError::kInvalid;
+    }
+
+    if (result > limit) {
+      overflow = true;
+    }
+
+    result *= base;
+    if (result > UINT64_MAX - digit) {
+      overflow = true;
+    }
+
+    result += digit;
+  }
+
+  if (overflow || result > max) {
+    return ParseError::kOutOfRange;
+  }
+
+  *value = result;
+  return ParseError::kNone;
+}
+
+}  // namespace internal
+
+ParseResult<double> ParseDouble(std::string_view str) {
+  ParseResult<double> result;
+
+  // std::from_chars accepts a '-', but not a '+'.
+  if (!str.empty() && str[0] == '+') {
+    str.remove_prefix(1);
+    if (!str.empty() && str[0] == '-') {
+      result.error = ParseError::kInvalid;
+      return result;
+    }
+  }
+
+  const char* end = str.data() + str.size();
+  auto [ptr, ec] = std::from_chars(str.data(), end, result.value);
+  if (ec == std::errc::invalid_argument || ptr != end) {
+    result.error = ParseError::kInvalid;
+  } else if (ec == std::errc::result_out_of_range) {
+    result.error = ParseError::kOutOfRange;
+  }
+
+  if (!result.ok()) {
+    result.value = 0;
+  }
+
+  return result;
+}
+
+}  // namespace string
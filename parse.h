@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+
+namespace string {
+
+/**
+ * Why a string couldn't be parsed as a number.
+ * @see        ParseInt
+ */
+enum class ParseError {
+  // The string was parsed successfully.
+  kNone,
+
+  // The string isn't a number in the expected format.
+  kInvalid,
+
+  // The string is a number, but it doesn't fit in the result type.
+  kOutOfRange,
+};
+
+/**
+ * The result of parsing a number: either a value, or an error.
+ * @see        ParseInt
+ */
+template <typename T>
+struct ParseResult {
+  T value = T();
+  ParseError error = ParseError::kNone;
+
+  bool ok() const { return error == ParseError::kNone; }
+  explicit operator bool() const { return ok(); }
+};
+
+// Internal; don't use directly.
+namespace internal {
+
+// Parse `digits`, which has no sign, as an unsigned number in `base` (0, or 2
+// to 36) into `value`. If the value is above `max`, kOutOfRange is returned.
+ParseError ParseMagnitude(std::string_view digits, int base, uint64_t max,
+                          uint64_t* value);
+
+}  // namespace internal
+
+/**
+ * @brief      Parse a string as a signed integer.
+ *
+ * @details    The whole of `str` must be an optional sign followed by digits
+ *             in `base`; whitespace and anything after the number are errors.
+ *             Letters are digits from 10 upwards, in either case, so base 16
+ *             accepts `kHexDigits` and base 8 accepts `kOctDigits`. Base 0
+ *             works out the base from a prefix like C does: "0x" for 16, "0"
+ *             for 8, and 10 otherwise. For example:
+ *
+ *                 ParseInt("-42").value -> -42
+ *                 ParseInt("ff", 16).value -> 255
+ *                 ParseInt("0x1F", 0).value -> 31
+ *                 ParseInt("12a").error -> ParseError::kInvalid
+ *                 ParseInt<int8_t>("200").error -> ParseError::kOutOfRange
+ *
+ *             Unlike std::stoi, this never throws, doesn't need a std::string,
+ *             and doesn't depend on the locale. Decimal digits are converted 8
+ *             at a time within a 64-bit word.
+ *
+ * @param[in]  str   The string to parse.
+ * @param[in]  base  The base of the number: 0, or 2 to 36.
+ *
+ * @tparam     T     The integer type to parse into.
+ *
+ * @return     The parsed value, or why it couldn't be parsed.
+ * @see        ParseUint
+ * @see        ParseDouble
+ */
+template <typename T = int>
+ParseResult<T> ParseInt(std::string_view str, int base = 10) {
+  static_assert(std::is_integral_v<T> && std::is_signed_v<T> &&
+                    sizeof(T) <= sizeof(uint64_t),
+                "ParseInt needs a signed integer type of at most 64 bits.");
+  bool negative = !str.empty() && str[0] == '-';
+  if (!str.empty() && (str[0] == '-' || str[0] == '+')) {
+    str.remove_prefix(1);
+  }
+
+  // The magnitude of the most negative value is one more than the maximum.
+  uint64_t max = static_cast<uint64_t>(std::numeric_limits<T>::max());
+  uint64_t magnitude;
+  ParseResult<T> result;
+  result.error =
+      internal::ParseMagnitude(str, base, max + negative, &magnitude);
+  if (result.ok()) {
+    result.value = negative ? static_cast<T>(0 - magnitude)
+                            : static_cast<T>(magnitude);
+  }
+
+  return result;
+}
+
+/**
+ * @brief      Parse a string as an unsigned integer.
+ *
+ * @details    The same as ParseInt, but for unsigned types. A leading '+' is
+ *             allowed, but '-' isn't, even for zero.
+ *
+ * @param[in]  str   The string to parse.
+ * @param[in]  base  The base of the number: 0, or 2 to 36.
+ *
+ * @tparam     T     The integer type to parse into.
+ *
+ * @return     The parsed value, or why it couldn't be parsed.
+ * @see        ParseInt
+ */
+template <typename T = unsigned>
+ParseResult<T> ParseUint(std::string_view str, int base = 10) {
+  static_assert(std::is_integral_v<T> && std::is_unsigned_v<T> &&
+                    sizeof(T) <= sizeof(uint64_t),
+                "ParseUint needs an unsigned integer type of at most 64 bits.");
+  if (!str.empty() && str[0] == '+') {
+    str.remove_prefix(1);
+  }
+
+  uint64_t value;
+  ParseResult<T> result;
+  result.error = internal::ParseMagnitude(
+      str, base, std::numeric_limits<T>::max(), &value);
+  if (result.ok()) {
+    result.value = static_cast<T>(value);
+  }
+
+  return result;
+}
+
+/**
+ * @brief      Parse a string as a double.
+ *
+ * @details    The whole of `str` must be an optional sign followed by a
+ *             decimal number, with an optional fraction and exponent, or
+ *             "inf", "infinity" or "nan" in any case. The result is correctly
+ *             rounded, and doesn't depend on the locale. For example:
+ *
+ *                 ParseDouble("-1.5e3").value -> -1500.0
+ *                 ParseDouble("0.1").value -> 0.1
+ *                 ParseDouble("1e400").error -> ParseError::kOutOfRange
+ *                 ParseDouble("1.5 ").error -> ParseError::kInvalid
+ *
+ * @param[in]  str   The string to parse.
+ *
+ * @return     The parsed value, or why it couldn't be parsed.
+ * @see        ParseInt
+ */
+ParseResult<double> ParseDouble(std::string_view str);
+
+}  // namespace string
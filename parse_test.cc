@@ -0,0 +1,161 @@
+#include "parse.h"
+
+#include <cmath>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using string::ParseError;
+
+TEST(TestParseInt, TestParseInt) {
+  ASSERT_EQ(0, string::ParseInt("0").value);
+  ASSERT_EQ(42, string::ParseInt("42").value);
+  ASSERT_EQ(-42, string::ParseInt("-42").value);
+  ASSERT_EQ(42, string::ParseInt("+42").value);
+  ASSERT_EQ(7, string::ParseInt("0007").value);
+  ASSERT_TRUE(string::ParseInt("123"));
+}
+
+TEST(TestParseInt, TestParseIntInvalid) {
+  for (std::string str : {"", "-", "+", "--1", "+-1", " 1", "1 ", "1a", "a1",
+                          "1.0", "0x10", "1,000", "١"}) {
+    auto result = string::ParseInt(str);
+    ASSERT_FALSE(result) << str;
+    ASSERT_EQ(ParseError::kInvalid, result.error) << str;
+    ASSERT_EQ(0, result.value) << str;
+  }
+}
+
+TEST(TestParseInt, TestParseIntLimits) {
+  ASSERT_EQ(127, string::ParseInt<int8_t>("127").value);
+  ASSERT_EQ(-128, string::ParseInt<int8_t>("-128").value);
+  ASSERT_EQ(ParseError::kOutOfRange, string::ParseInt<int8_t>("128").error);
+  ASSERT_EQ(ParseError::kOutOfRange, string::ParseInt<int8_t>("-129").error);
+
+  ASSERT_EQ(INT64_MAX, string::ParseInt<int64_t>("9223372036854775807").value);
+  ASSERT_EQ(INT64_MIN, string::ParseInt<int64_t>("-9223372036854775808").value);
+  ASSERT_EQ(ParseError::kOutOfRange,
+            string::ParseInt<int64_t>("9223372036854775808").error);
+  ASSERT_EQ(ParseError::kOutOfRange,
+            string::ParseInt<int64_t>("-9223372036854775809").error);
+  ASSERT_EQ(ParseError::kOutOfRange,
+            string::ParseInt<int64_t>("99999999999999999999999").error);
+
+  // Leading zeros don't count towards the range.
+  ASSERT_EQ(1, string::ParseInt<int8_t>("0000000000000000000000001").value);
+
+  // An invalid digit after an overflow is still invalid.
+  ASSERT_EQ(ParseError::kInvalid,
+            string::ParseInt<int64_t>("99999999999999999999999x").error);
+}
+
+TEST(TestParseInt, TestParseIntWithBase) {
+  ASSERT_EQ(255, string::ParseInt("ff", 16).value);
+  ASSERT_EQ(255, string::ParseInt("FF", 16).value);
+  ASSERT_EQ(-10, string::ParseInt("-a", 16).value);
+  ASSERT_EQ(8, string::ParseInt("10", 8).value);
+  ASSERT_EQ(5, string::ParseInt("101", 2).value);
+  ASSERT_EQ(35, string::ParseInt("z", 36).value);
+  ASSERT_EQ(ParseError::kInvalid, string::ParseInt("8", 8).error);
+  ASSERT_EQ(ParseError::kInvalid, string::ParseInt("g", 16).error);
+  ASSERT_EQ(ParseError::kInvalid, string::ParseInt("1", 1).error);
+  ASSERT_EQ(ParseError::kInvalid, string::ParseInt("1", 37).error);
+}
+
+TEST(TestParseInt, TestParseIntDetectsBase) {
+  ASSERT_EQ(31, string::ParseInt("0x1F", 0).value);
+  ASSERT_EQ(-31, string::ParseInt("-0x1f", 0).value);
+  ASSERT_EQ(8, string::ParseInt("010", 0).value);
+  ASSERT_EQ(0, string::ParseInt("0", 0).value);
+  ASSERT_EQ(10, string::ParseInt("10", 0).value);
+  ASSERT_EQ(ParseError::kInvalid, string::ParseInt("0x", 0).error);
+  ASSERT_EQ(ParseError::kInvalid, string::ParseInt("09", 0).error);
+}
+
+TEST(TestParseInt, TestAgainstStrtoll) {
+  // Decimal numbers of every length, so that each is split differently
+  // between whole 8 digit words and single digits.
+  srand(1);
+  for (int i = 0; i < 20000; i++) {
+    std::string str = rand() % 2 ? "-" : "";
+    int n = 1 + rand() % 19;
+    for (int j = 0; j < n; j++) {
+      str += static_cast<char>('0' + rand() % 10);
+    }
+
+    // Occasionally break one of the digits.
+    if (rand() % 10 == 0) {
+      str[rand() % str.size()] = "/:a "[rand() % 4];
+    }
+
+    char* end;
+    errno = 0;
+    long long expected = strtoll(str.c_str(), &end, 10);
+    auto result = string::ParseInt<long long>(str);
+    if (*end != '\0' || end == str.c_str() || str[0] == ' ') {
+      ASSERT_EQ(ParseError::kInvalid, result.error) << str;
+    } else if (errno == ERANGE) {
+      ASSERT_EQ(ParseError::kOutOfRange, result.error) << str;
+    } else {
+      ASSERT_TRUE(result) << str;
+      ASSERT_EQ(expected, result.value) << str;
+    }
+  }
+}
+
+TEST(TestParseUint, TestParseUint) {
+  ASSERT_EQ(42u, string::ParseUint("42").value);
+  ASSERT_EQ(42u, string::ParseUint("+42").value);
+  ASSERT_EQ(0xdeadbeefu, string::ParseUint("DeadBeef", 16).value);
+  ASSERT_EQ(UINT64_MAX,
+            string::ParseUint<uint64_t>("18446744073709551615").value);
+  ASSERT_EQ(UINT64_MAX,
+            string::ParseUint<uint64_t>("ffffffffffffffff", 16).value);
+  ASSERT_EQ(ParseError::kOutOfRange,
+            string::ParseUint<uint64_t>("18446744073709551616").error);
+  ASSERT_EQ(ParseError::kOutOfRange,
+            string::ParseUint<uint64_t>("10000000000000000", 16).error);
+  ASSERT_EQ(ParseError::kOutOfRange, string::ParseUint<uint8_t>("256").error);
+  ASSERT_EQ(ParseError::kInvalid, string::ParseUint("-1").error);
+  ASSERT_EQ(ParseError::kInvalid, string::ParseUint("-0").error);
+}
+
+TEST(TestParseDouble, TestParseDouble) {
+  ASSERT_EQ(0.0, string::ParseDouble("0").value);
+  ASSERT_EQ(-1500.0, string::ParseDouble("-1.5e3").value);
+  ASSERT_EQ(1500.0, string::ParseDouble("+1.5E3").value);
+  ASSERT_EQ(0.5, string::ParseDouble(".5").value);
+  ASSERT_EQ(5.0, string::ParseDouble("5.").value);
+  ASSERT_TRUE(std::isinf(string::ParseDouble("-inf").value));
+  ASSERT_TRUE(std::isinf(string::ParseDouble("Infinity").value));
+  ASSERT_TRUE(std::isnan(string::ParseDouble("nan").value));
+}
+
+TEST(TestParseDouble, TestParseDoubleIsCorrectlyRounded) {
+  ASSERT_EQ(0.1, string::ParseDouble("0.1").value);
+  ASSERT_EQ(0.3, string::ParseDouble("0.3").value);
+  ASSERT_EQ(5e-324, string::ParseDouble("5e-324").value);
+  ASSERT_EQ(1.7976931348623157e308,
+            string::ParseDouble("1.7976931348623157e308").value);
+
+  // Exactly halfway between 1 and the next double, which rounds to even.
+  ASSERT_EQ(1.0, string::ParseDouble("1.00000000000000011102230246251565404236"
+                                     "316680908203125")
+                     .value);
+
+  // A long input which only just rounds up.
+  ASSERT_EQ(9007199254740994.0,
+            string::ParseDouble("9007199254740993.00000000000000000001").value);
+}
+
+TEST(TestParseDouble, TestParseDoubleErrors) {
+  for (std::string str : {"", "+", "-", "+-1", "1.5 ", " 1.5", "1e", "1,5",
+                          "0x1p3", "e5", "--1", "1..0"}) {
+    auto result = string::ParseDouble(str);
+    ASSERT_EQ(ParseError::kInvalid, result.error) << str;
+    ASSERT_EQ(0.0, result.value) << str;
+  }
+
+  ASSERT_EQ(ParseError::kOutOfRange, string::ParseDouble("1e400").error);
+  ASSERT_EQ(ParseError::kOutOfRange, string::ParseDouble("-1e400").error);
+}
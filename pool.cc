@@ -0,0 +1,169 @@
+#include "pool.h"
+
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+
+#include <string.h>
+
+#include "hash.h"
+
+namespace string {
+
+namespace {
+
+// Strings are copied into blocks of this size. Larger strings get a block of
+// their own.
+constexpr size_t kBlockSize = 64 * 1024;
+
+// The initial number of slots in each shard's table.
+constexpr size_t kInitialSlots = 64;
+
+constexpr uint32_t kEmptySlot = ~uint32_t{0};
+
+}  // namespace
+
+struct StringPool::Shard {
+  struct Slot {
+    uint64_t hash;
+
+    // The index of the string in `strings`, or kEmptySlot.
+    uint32_t index;
+  };
+
+  Shard() : slots(kInitialSlots, Slot{0, kEmptySlot}) {}
+
+  // Copy `str` into the arena.
+  const char* Store(std::string_view str) {
+    if (str.empty()) {
+      return cursor;
+    }
+
+    if (str.size() > kBlockSize / 4) {
+      blocks.emplace_back(new char[str.size()]);
+      memcpy(blocks.back().get(), str.data(), str.size());
+      return blocks.back().get();
+    }
+
+    if (blocks.empty() || free_bytes < str.size()) {
+      blocks.emplace_back(new char[kBlockSize]);
+      cursor = blocks.back().get();
+      free_bytes = kBlockSize;
+    }
+
+    char* copy = cursor;
+    memcpy(copy, str.data(), str.size());
+    cursor += str.size();
+    free_bytes -= str.size();
+    return copy;
+  }
+
+  // Double the number of slots, and reinsert everything.
+  void Grow() {
+    std::vector<Slot> old(slots.size() * 2, Slot{0, kEmptySlot});
+    old.swap(slots);
+
+    size_t mask = slots.size() - 1;
+    for (const Slot& slot : old) {
+      if (slot.index != kEmptySlot) {
+        size_t i = slot.hash & mask;
+        while (slots[i].index != kEmptySlot) {
+          i = (i + 1) & mask;
+        }
+
+        slots[i] = slot;
+      }
+    }
+  }
+
+  mutable std::mutex mutex;
+
+  // An open addressing table with linear probing. The size is always a power
+  // of 2, and it is kept at most 3/4 full.
+  std::vector<Slot> slots;
+
+  // Every string in the shard, in the order they were added.
+  std::vector<std::string_view> strings;
+
+  // The arena which holds the string data.
+  std::vector<std::unique_ptr<char[]>> blocks;
+  char* cursor = nullptr;
+  size_t free_bytes = 0;
+};
+
+StringPool::StringPool(size_t n_shards) : shard_bits_(0) {
+  n_shards = std::min(n_shards, kMaxShards);
+  while ((size_t{1} << shard_bits_) < n_shards) {
+    shard_bits_++;
+  }
+
+  shards_.reset(new Shard[size_t{1} << shard_bits_]);
+}
+
+StringPool::~StringPool() {}
+
+std::string_view StringPool::Intern(std::string_view str) {
+  Id id;
+  return Insert(str, &id);
+}
+
+StringPool::Id StringPool::InternId(std::string_view str) {
+  Id id;
+  Insert(str, &id);
+  return id;
+}
+
+std::string_view StringPool::Get(Id id) const {
+  const Shard& shard = shards_[id & ((Id{1} << shard_bits_) - 1)];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  return shard.strings[id >> shard_bits_];
+}
+
+size_t StringPool::size() const {
+  size_t total = 0;
+  for (size_t s = 0; s < (size_t{1} << shard_bits_); s++) {
+    std::lock_guard<std::mutex> lock(shards_[s].mutex);
+    total += shards_[s].strings.size();
+  }
+
+  return total;
+}
+
+std::string_view StringPool::Insert(std::string_view str, Id* id) {
+  // The table slot comes from the low bits of the hash, so pick the shard with
+  // the high bits.
+  uint64_t hash = internal::HashBytes(str.data(), str.size());
+  size_t shard_index = (hash >> 32) & ((size_t{1} << shard_bits_) - 1);
+  Shard& shard = shards_[shard_index];
+
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  size_t mask = shard.slots.size() - 1;
+  size_t i = hash & mask;
+  while (shard.slots[i].index != kEmptySlot) {
+    const auto& slot = shard.slots[i];
+    if (slot.hash == hash && shard.strings[slot.index] == str) {
+      *id = (slot.index << shard_bits_) | shard_index;
+      return shard.strings[slot.index];
+    }
+
+    i = (i + 1) & mask;
+  }
+
+  // The index has to fit in the bits of the id above the shard, and must not
+  // be mistaken for an empty slot.
+  size_t index = shard.strings.size();
+  if (index > (Id{kEmptySlot - 1} >> shard_bits_)) {
+    throw std::length_error("String pool shard is full.");
+  }
+
+  shard.strings.emplace_back(shard.Store(str), str.size());
+  shard.slots[i] = {hash, static_cast<uint32_t>(index)};
+  if (shard.strings.size() * 4 > shard.slots.size() * 3) {
+    shard.Grow();
+  }
+
+  *id = (static_cast<Id>(index) << shard_bits_) | shard_index;
+  return shard.strings.back();
+}
+
+}  // namespace string
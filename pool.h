@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace string {
+
+/**
+ * @brief      A thread-safe pool of interned strings.
+ *
+ * @details    Each distinct string is only stored once, however many times it
+ *             is interned, so two interned strings are equal iff they have the
+ *             same data pointer. For example:
+ *
+ *                 StringPool pool;
+ *                 auto a = pool.Intern(std::string("host-1"));
+ *                 auto b = pool.Intern("host-1");
+ *                 a.data() == b.data() -> true
+ *
+ *             Interned strings live as long as the pool, and never move.
+ *
+ *             The pool is split into shards, each with its own lock, open
+ *             addressing hash table and arena, so that threads interning
+ *             different strings rarely contend.
+ *
+ * @see        SplitInterned
+ */
+class StringPool {
+ public:
+  /**
+   * A small, stable identifier for an interned string.
+   */
+  using Id = uint32_t;
+
+  /**
+   * The largest number of shards. An id holds both the shard and the index of
+   * the string within it, so each extra bit of shards halves the number of
+   * strings which each shard can hold.
+   */
+  static constexpr size_t kMaxShards = 1024;
+
+  /**
+   * @brief      Create an empty pool.
+   *
+   * @param[in]  n_shards  The number of shards, which is rounded up to a power
+   *                       of 2 and capped at kMaxShards. More shards reduce
+   *                       contention between threads.
+   */
+  explicit StringPool(size_t n_shards = 16);
+
+  ~StringPool();
+
+  StringPool(const StringPool&) = delete;
+  StringPool& operator=(const StringPool&) = delete;
+
+  /**
+   * @brief      Intern a string.
+   *
+   * @param[in]  str   The string to intern.
+   *
+   * @throws     std::length_error  If `str` is new, and its shard already
+   *                                holds as many strings as its ids can
+   *                                number.
+   *
+   * @return     A view of the pool's copy of `str`.
+   */
+  std::string_view Intern(std::string_view str);
+
+  /**
+   * @brief      Intern a string, and get its id.
+   *
+   * @param[in]  str   The string to intern.
+   *
+   * @throws     std::length_error  If `str` is new, and its shard is full.
+   *
+   * @return     The id of `str`. This is the same each time the same string is
+   *             interned into the same pool.
+   */
+  Id InternId(std::string_view str);
+
+  /**
+   * @brief      Get the interned string with the given id.
+   *
+   * @param[in]  id    An id returned by InternId on this pool.
+   *
+   * @return     A view of the interned string.
+   */
+  std::string_view Get(Id id) const;
+
+  /**
+   * @brief      Get the number of distinct strings in the pool.
+   */
+  size_t size() const;
+
+ private:
+  struct Shard;
+
+  // Find or add `str` in its shard, and set `id` to its id.
+  std::string_view Insert(std::string_view str, Id* id);
+
+  std::unique_ptr<Shard[]> shards_;
+  size_t shard_bits_;
+};
+
+}  // namespace string
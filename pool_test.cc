@@ -0,0 +1,93 @@
+#include "pool.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(TestStringPool, TestInternReturnsSameStorage) {
+  string::StringPool pool;
+  std::string a = "host-1", b = "host-1";
+  auto x = pool.Intern(a);
+  auto y = pool.Intern(b);
+  ASSERT_EQ("host-1", x);
+  ASSERT_EQ(x.data(), y.data());
+  ASSERT_NE(a.data(), x.data());
+  ASSERT_NE(x.data(), pool.Intern("host-2").data());
+  ASSERT_EQ(2, pool.size());
+}
+
+TEST(TestStringPool, TestInternIdsAreStable) {
+  string::StringPool pool;
+  auto info = pool.InternId("INFO");
+  auto warn = pool.InternId("WARN");
+  ASSERT_NE(info, warn);
+  ASSERT_EQ(info, pool.InternId("INFO"));
+  ASSERT_EQ("INFO", pool.Get(info));
+  ASSERT_EQ("WARN", pool.Get(warn));
+  ASSERT_EQ(pool.Intern("WARN").data(), pool.Get(warn).data());
+}
+
+TEST(TestStringPool, TestShardsAreCapped) {
+  // Without the cap, the shard bits would leave no room in the ids for the
+  // index of each string.
+  string::StringPool pool(size_t{1} << 40);
+  std::vector<string::StringPool::Id> ids;
+  for (int i = 0; i < 10000; i++) {
+    ids.push_back(pool.InternId(std::to_string(i)));
+  }
+
+  for (int i = 0; i < 10000; i++) {
+    ASSERT_EQ(std::to_string(i), pool.Get(ids[i]));
+  }
+}
+
+TEST(TestStringPool, TestEmptyAndLongStrings) {
+  string::StringPool pool;
+  ASSERT_EQ("", pool.Intern(""));
+  ASSERT_EQ(pool.InternId(""), pool.InternId(std::string()));
+
+  std::string long_string(100000, 'x');
+  auto interned = pool.Intern(long_string);
+  ASSERT_EQ(long_string, interned);
+  ASSERT_EQ(interned.data(), pool.Intern(long_string).data());
+}
+
+TEST(TestStringPool, TestManyStringsSurviveGrowth) {
+  string::StringPool pool(1);
+  std::vector<std::string_view> views;
+  for (int i = 0; i < 10000; i++) {
+    views.push_back(pool.Intern("token-" + std::to_string(i)));
+  }
+
+  ASSERT_EQ(10000, pool.size());
+  for (int i = 0; i < 10000; i++) {
+    ASSERT_EQ("token-" + std::to_string(i), views[i]);
+    ASSERT_EQ(views[i].data(), pool.Intern(views[i]).data());
+  }
+}
+
+TEST(TestStringPool, TestConcurrentInterning) {
+  string::StringPool pool;
+  std::vector<std::vector<std::string_view>> results(4);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&pool, &results, t] {
+      for (int i = 0; i < 5000; i++) {
+        results[t].push_back(pool.Intern(std::to_string(i % 1000)));
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(1000, pool.size());
+  for (int t = 1; t < 4; t++) {
+    for (int i = 0; i < 5000; i++) {
+      ASSERT_EQ(results[0][i].data(), results[t][i].data());
+    }
+  }
+}
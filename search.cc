@@ -0,0 +1,200 @@
+#include "search.h"
+
+#include <algorithm>
+
+#include <string.h>
+
+#include "ascii.h"
+#include "simd.h"
+
+namespace string {
+
+namespace {
+
+// Needles longer than this use Horspool rather than the first/last byte filter.
+constexpr size_t kShortNeedleMax = 32;
+
+}  // namespace
+
+Searcher::Searcher(std::string_view needle, bool ignore_case)
+    : owned_(needle), ignore_case_(ignore_case) {
+  Init();
+}
+
+Searcher::Searcher(BorrowTag, std::string_view needle, bool ignore_case)
+    : borrowed_(needle), ignore_case_(ignore_case) {
+  Init();
+}
+
+Searcher Searcher::Borrow(std::string_view needle, bool ignore_case) {
+  return Searcher(BorrowTag(), needle, ignore_case);
+}
+
+void Searcher::Init() {
+  std::string_view needle = this->needle();
+  size_ = needle.size();
+  if (size_ == 0) {
+    algorithm_ = Algorithm::kEmpty;
+    return;
+  }
+
+  // The needle is kept as it was given, so only the bytes which are compared
+  // on their own need folding.
+  first_ = ignore_case_ ? internal::AsciiFold(needle[0]) : needle[0];
+  last_ = ignore_case_ ? internal::AsciiFold(needle[size_ - 1])
+                       : needle[size_ - 1];
+
+  // memchr can only be used if there is a single byte to look for.
+  bool is_letter = static_cast<unsigned char>(first_ - 'a') < 26;
+
+  if (size_ == 1 && !(ignore_case_ && is_letter)) {
+    algorithm_ = Algorithm::kByte;
+  } else if (size_ <= kShortNeedleMax) {
+    algorithm_ = Algorithm::kShort;
+  } else {
+    algorithm_ = Algorithm::kHorspool;
+
+    // Each byte shifts by its distance from the end of the needle (ignoring the
+    // last byte); bytes not in the needle shift by the whole needle. When
+    // ignoring case, both cases of a letter shift by the same amount. Shorter
+    // shifts are always safe, so huge needles are capped to fit.
+    uint32_t n = std::min<size_t>(size_, UINT32_MAX);
+    shift_.fill(n);
+    for (size_t i = size_ - std::min<size_t>(size_, n); i < size_ - 1; i++) {
+      char c = ignore_case_ ? internal::AsciiFold(needle[i]) : needle[i];
+      shift_[static_cast<unsigned char>(c)] = size_ - 1 - i;
+      if (ignore_case_ && static_cast<unsigned char>(c - 'a') < 26) {
+        shift_[static_cast<unsigned char>(c ^ 0x20)] = size_ - 1 - i;
+      }
+    }
+  }
+}
+
+bool Searcher::Equals(std::string_view str) const {
+  return str.size() == size_ && MatchesAt(str.data(), 0, str.size());
+}
+
+bool Searcher::MatchesAt(const char* s, size_t offset, size_t n) const {
+  if (ignore_case_) {
+    return internal::AsciiEqualsIgnoreCase(s, needle().data() + offset, n);
+  }
+
+  return memcmp(s, needle().data() + offset, n) == 0;
+}
+
+size_t Searcher::Find(std::string_view haystack, size_t pos) const {
+  if (pos > haystack.size()) {
+    return std::string::npos;
+  }
+
+  switch (algorithm_) {
+    case Algorithm::kEmpty:
+      return pos;
+
+    case Algorithm::kByte: {
+      auto found = static_cast<const char*>(
+          memchr(haystack.data() + pos, first_, haystack.size() - pos));
+      return found ? found - haystack.data() : std::string::npos;
+    }
+
+    case Algorithm::kShort:
+      return FindShort(haystack, pos);
+
+    case Algorithm::kHorspool:
+      return FindHorspool(haystack, pos);
+  }
+
+  return std::string::npos;
+}
+
+size_t Searcher::FindShort(std::string_view haystack, size_t pos) const {
+  const char* s = haystack.data();
+  const char* needle = this->needle().data();
+  size_t n = haystack.size(), k = size_;
+  if (n - pos < k) {
+    return std::string::npos;
+  }
+
+  size_t i = pos;
+
+#ifdef CPPSTRING_HAVE_SSE2
+  // Compare the first and last bytes of the needle against 16 candidate
+  // positions at once, and only look at the middle of the needle for positions
+  // where both match.
+  const __m128i first = _mm_set1_epi8(first_);
+  const __m128i last = _mm_set1_epi8(last_);
+  for (; i + k - 1 + 16 <= n; i += 16) {
+    __m128i block_first =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+    __m128i block_last =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + k - 1));
+    if (ignore_case_) {
+      block_first = internal::AsciiFold128(block_first);
+      block_last = internal::AsciiFold128(block_last);
+    }
+
+    unsigned mask = _mm_movemask_epi8(_mm_and_si128(
+        _mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last)));
+
+    while (mask != 0) {
+      unsigned bit = internal::LowestSetBit(mask);
+      if (k <= 2 || MatchesAt(s + i + bit + 1, 1, k - 2)) {
+        return i + bit;
+      }
+
+      mask &= mask - 1;
+    }
+  }
+#endif  // CPPSTRING_HAVE_SSE2
+
+  // Handle whatever is left (or everything, without SSE2).
+  if (ignore_case_) {
+    for (; i + k <= n; i++) {
+      if (internal::AsciiFold(s[i]) == first_ &&
+          internal::AsciiFold(s[i + k - 1]) == last_ &&
+          MatchesAt(s + i, 0, k)) {
+        return i;
+      }
+    }
+
+    return std::string::npos;
+  }
+
+  // Without ignoring case, we can jump between occurrences of the first byte.
+  while (i + k <= n) {
+    auto found =
+        static_cast<const char*>(memchr(s + i, needle[0], n - k + 1 - i));
+    if (found == nullptr) {
+      break;
+    }
+
+    i = found - s;
+    if (s[i + k - 1] == needle[k - 1] && memcmp(s + i, needle, k - 1) == 0) {
+      return i;
+    }
+
+    i++;
+  }
+
+  return std::string::npos;
+}
+
+size_t Searcher::FindHorspool(std::string_view haystack, size_t pos) const {
+  const char* s = haystack.data();
+  size_t n = haystack.size(), k = size_;
+
+  size_t i = pos;
+  while (i + k <= n) {
+    char last = s[i + k - 1];
+    char folded = ignore_case_ ? internal::AsciiFold(last) : last;
+    if (folded == last_ && MatchesAt(s + i, 0, k - 1)) {
+      return i;
+    }
+
+    i += shift_[static_cast<unsigned char>(last)];
+  }
+
+  return std::string::npos;
+}
+
+}  // namespace string
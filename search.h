@@ -0,0 +1,147 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace string {
+
+/**
+ * @brief      A substring searcher, built once from a needle and reused across
+ *             many haystacks.
+ *
+ * @details    Building a Searcher does all of the setup work for a needle up
+ *             front, and picks the search algorithm best suited to it:
+ *
+ *               - a single byte uses memchr;
+ *               - short needles use a SIMD filter which compares the first and
+ *                 last bytes of the needle against 16 positions at a time, and
+ *                 only checks the middle of the needle on a hit;
+ *               - long needles use Boyer-Moore-Horspool, which can skip up to
+ *                 the length of the needle on every mismatch.
+ *
+ *             A Searcher can also ignore the case of ASCII letters, in which
+ *             case the same algorithms are used, but bytes are case-folded as
+ *             they are compared.
+ *
+ *             A Searcher copies its needle, so that it can outlive it. To
+ *             search for a needle only once, Searcher::Borrow refers to the
+ *             needle instead, so that building it never allocates.
+ *
+ *             Count, In, Replace, StartsWith and EndsWith all have overloads
+ *             which accept a Searcher, so that searching for the same needle
+ *             in many strings only pays the setup cost once:
+ *
+ *                 Searcher needle("needle");
+ *                 for (const auto& line : lines) {
+ *                   if (In(line, needle)) { ... }
+ *                 }
+ */
+class Searcher {
+ public:
+  /**
+   * @brief      Build a searcher for the given needle.
+   *
+   * @param[in]  needle       The string to search for.
+   * @param[in]  ignore_case  When true, ASCII letters match regardless of
+   *                          their case.
+   */
+  explicit Searcher(std::string_view needle, bool ignore_case = false);
+
+  /**
+   * @brief      Build a searcher which refers to `needle` rather than copying
+   *             it, so that it doesn't allocate.
+   *
+   * @details    `needle` must outlive the searcher, and any copies of it.
+   *
+   * @param[in]  needle       The string to search for.
+   * @param[in]  ignore_case  When true, ASCII letters match regardless of
+   *                          their case.
+   */
+  static Searcher Borrow(std::string_view needle, bool ignore_case = false);
+
+  /**
+   * @brief      Find the first occurrence of the needle in `haystack`.
+   *
+   * @param[in]  haystack  The string to search.
+   * @param[in]  pos       The position to start searching from.
+   *
+   * @return     The position of the first occurrence of the needle at or after
+   *             `pos`, or std::string::npos if there is none. An empty needle
+   *             matches at `pos`, provided `pos <= haystack.size()`.
+   */
+  size_t Find(std::string_view haystack, size_t pos = 0) const;
+
+  /**
+   * @brief      Check whether the needle matches `str` exactly, respecting
+   *             `ignore_case()`.
+   *
+   * @param[in]  str   The string to compare against.
+   *
+   * @return     `true` iff `str` is equal to the needle.
+   */
+  bool Equals(std::string_view str) const;
+
+  /**
+   * @brief      Get the needle this searcher was built from.
+   */
+  std::string_view needle() const {
+    return borrowed_.data() != nullptr ? borrowed_ : std::string_view(owned_);
+  }
+
+  /**
+   * @brief      Check whether this searcher ignores the case of ASCII letters.
+   */
+  bool ignore_case() const { return ignore_case_; }
+
+  /**
+   * @brief      Get the length of the needle.
+   */
+  size_t size() const { return size_; }
+
+  /**
+   * @brief      Check whether the needle is empty.
+   */
+  bool empty() const { return size_ == 0; }
+
+ private:
+  enum class Algorithm {
+    kEmpty,
+    kByte,
+    kShort,
+    kHorspool,
+  };
+
+  struct BorrowTag {};
+
+  Searcher(BorrowTag, std::string_view needle, bool ignore_case);
+
+  // Pick the algorithm, and set up whatever it needs.
+  void Init();
+
+  // Compare [s, s + n) against the needle, starting from `offset`.
+  bool MatchesAt(const char* s, size_t offset, size_t n) const;
+
+  size_t FindShort(std::string_view haystack, size_t pos) const;
+  size_t FindHorspool(std::string_view haystack, size_t pos) const;
+
+  // The needle is either copied into owned_, or borrowed from the caller.
+  std::string owned_;
+  std::string_view borrowed_;
+  size_t size_;
+  bool ignore_case_;
+  Algorithm algorithm_;
+
+  // The first and last bytes of the needle, folded to lower-case if ignoring
+  // case.
+  char first_;
+  char last_;
+
+  // Horspool shift table; only filled in for long needles. It is kept inline,
+  // so that building a Searcher for a long needle doesn't allocate.
+  std::array<uint32_t, 256> shift_;
+};
+
+}  // namespace string
@@ -0,0 +1,149 @@
+#include "search.h"
+
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include "util.h"
+
+namespace {
+
+// Check that Searcher::Find agrees with std::string::find at every position.
+void ExpectMatchesStdFind(const std::string& haystack,
+                          const std::string& needle) {
+  string::Searcher searcher(needle);
+  for (size_t pos = 0; pos <= haystack.size() + 1; pos++) {
+    ASSERT_EQ(haystack.find(needle, pos), searcher.Find(haystack, pos))
+        << "needle=" << needle << " pos=" << pos;
+  }
+}
+
+}  // namespace
+
+TEST(TestSearcher, TestFindEmptyNeedle) {
+  string::Searcher searcher("");
+  ASSERT_EQ(0, searcher.Find("abc"));
+  ASSERT_EQ(3, searcher.Find("abc", 3));
+  ASSERT_EQ(std::string::npos, searcher.Find("abc", 4));
+}
+
+TEST(TestSearcher, TestFindSingleByte) {
+  ExpectMatchesStdFind("abcabcabc", "c");
+  ExpectMatchesStdFind("abcabcabc", "x");
+}
+
+TEST(TestSearcher, TestFindShortNeedle) {
+  std::string haystack;
+  for (int i = 0; i < 20; i++) {
+    haystack += "the quick brown fox jumps over the lazy dog ";
+  }
+
+  ExpectMatchesStdFind(haystack, "fox");
+  ExpectMatchesStdFind(haystack, "dog the");
+  ExpectMatchesStdFind(haystack, "the lazy cat");
+  ExpectMatchesStdFind(haystack, "og");
+}
+
+TEST(TestSearcher, TestFindNeedleAtEndOfHaystack) {
+  std::string haystack(100, 'a');
+  ExpectMatchesStdFind(haystack + "ab", "ab");
+  ExpectMatchesStdFind(haystack + std::string(40, 'b'), std::string(40, 'b'));
+}
+
+TEST(TestSearcher, TestFindLongNeedle) {
+  std::string needle;
+  for (int i = 0; i < 50; i++) {
+    needle += static_cast<char>('a' + (i * 7) % 26);
+  }
+
+  std::string haystack = std::string(300, 'x') + needle + "yyy" + needle;
+  ExpectMatchesStdFind(haystack, needle);
+  ExpectMatchesStdFind(haystack, needle + "z");
+}
+
+TEST(TestSearcher, TestFindRepetitiveHaystack) {
+  ExpectMatchesStdFind(std::string(200, 'a'), std::string(5, 'a'));
+  ExpectMatchesStdFind(std::string(200, 'a'), std::string(40, 'a'));
+  ExpectMatchesStdFind(std::string(200, 'a') + "b", std::string(40, 'a') + "b");
+}
+
+TEST(TestSearcher, TestFindWithNonAsciiBytes) {
+  ExpectMatchesStdFind("caf\xc3\xa9 \xff\xfe \xc3\xa9t\xc3\xa9", "\xc3\xa9");
+  ExpectMatchesStdFind("caf\xc3\xa9 \xff\xfe \xc3\xa9t\xc3\xa9", "\xff\xfe");
+}
+
+TEST(TestSearcher, TestUtilFunctionsAcceptSearcher) {
+  string::Searcher searcher("ab");
+  ASSERT_EQ(3, string::Count("ababab", searcher));
+  ASSERT_TRUE(string::In("xxabxx", searcher));
+  ASSERT_FALSE(string::In("xxaxbx", searcher));
+  ASSERT_TRUE(string::StartsWith("abc", searcher));
+  ASSERT_TRUE(string::EndsWith("cab", searcher));
+  ASSERT_STREQ("xyxyc", string::Replace("ababc", searcher, "xy").c_str());
+}
+
+TEST(TestSearcher, TestFindIgnoringCaseMatchesFindOnLoweredStrings) {
+  std::string haystack;
+  for (int i = 0; i < 10; i++) {
+    haystack += "The Quick BROWN fox Jumps over THE lazy dog. [@`{] ";
+  }
+
+  std::string lowered = string::ToLower(haystack);
+  for (const std::string needle :
+       {"t", "@", "[", "the", "THE LAZY", "Fox JUMPS", "{] th",
+        "over the lazy dog. [@`{] the quick brown"}) {
+    string::Searcher searcher(needle, true);
+    std::string lowered_needle = string::ToLower(needle);
+    for (size_t pos = 0; pos <= haystack.size(); pos++) {
+      ASSERT_EQ(lowered.find(lowered_needle, pos), searcher.Find(haystack, pos))
+          << "needle=" << needle << " pos=" << pos;
+    }
+  }
+}
+
+TEST(TestSearcher, TestIgnoreCaseDoesNotFoldNonLetters) {
+  string::Searcher searcher("@[", true);
+  ASSERT_EQ(std::string::npos, searcher.Find("`{`{`{`{`{`{`{`{`{`{`{`{`{`{"));
+}
+
+TEST(TestSearcher, TestEqualsRespectsIgnoreCase) {
+  ASSERT_TRUE(string::Searcher("Host", true).Equals("HOST"));
+  ASSERT_FALSE(string::Searcher("Host").Equals("HOST"));
+  ASSERT_FALSE(string::Searcher("Host", true).Equals("HOSTS"));
+}
+
+TEST(TestSearcher, TestStartsWithAndEndsWithRespectIgnoreCase) {
+  ASSERT_TRUE(string::StartsWith("HTTP/1.1", string::Searcher("http", true)));
+  ASSERT_FALSE(string::StartsWith("HTTP/1.1", string::Searcher("http")));
+  ASSERT_TRUE(string::EndsWith("index.HTML", string::Searcher(".html", true)));
+  ASSERT_FALSE(string::EndsWith("html", string::Searcher(".html", true)));
+}
+
+TEST(TestSearcher, TestBorrowMatchesCopy) {
+  std::string haystack;
+  for (int i = 0; i < 10; i++) {
+    haystack += "The Quick BROWN fox Jumps over THE lazy dog. [@`{] ";
+  }
+
+  for (const std::string needle :
+       {"T", "the", "Fox JUMPS", "OVER the LAZY dog. [@`{] THE QUICK BROWN"}) {
+    for (bool ignore_case : {false, true}) {
+      string::Searcher copy(needle, ignore_case);
+      string::Searcher borrowed = string::Searcher::Borrow(needle, ignore_case);
+      ASSERT_EQ(needle.data(), borrowed.needle().data());
+      ASSERT_EQ(needle, copy.needle());
+      for (size_t pos = 0; pos <= haystack.size(); pos++) {
+        ASSERT_EQ(copy.Find(haystack, pos), borrowed.Find(haystack, pos))
+            << "needle=" << needle << " pos=" << pos;
+      }
+    }
+  }
+}
+
+TEST(TestSearcher, TestCopyOutlivesOriginal) {
+  std::string needle(40, 'n');
+  auto original = std::make_unique<string::Searcher>(needle);
+  string::Searcher copy = *original;
+  original.reset();
+  ASSERT_EQ(3, copy.Find("abc" + needle));
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+// Internal; don't use directly. Detects which SIMD instruction sets can be used
+// by the library at compile time.
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CPPSTRING_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// GCC and Clang can compile individual functions for a newer instruction set
+// than the rest of the build, and check at runtime whether the CPU supports it.
+// Functions using AVX2 must be marked with CPPSTRING_TARGET_AVX2, and only be
+// called if CpuHasAvx2() returns true.
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define CPPSTRING_HAVE_AVX2_DISPATCH 1
+#define CPPSTRING_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+namespace string {
+
+namespace internal {
+
+// Get the index of the lowest set bit in `mask`, which must not be 0.
+inline unsigned LowestSetBit(unsigned mask) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return index;
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+
+// Check whether the CPU supports AVX2. This is always false if the compiler
+// can't dispatch on it.
+inline bool CpuHasAvx2() {
+#ifdef CPPSTRING_HAVE_AVX2_DISPATCH
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  return has_avx2;
+#else
+  return false;
+#endif
+}
+
+#ifdef CPPSTRING_HAVE_SSE2
+
+// Fold all ASCII upper-case letters in `v` to lower-case. SSE2 only has signed
+// comparisons, so shift ['A', 'Z'] down to [-128, -103] and then a single
+// signed less-than tests for it.
+inline __m128i AsciiFold128(__m128i v) {
+  __m128i shifted =
+      _mm_add_epi8(v, _mm_set1_epi8(static_cast<char>(0x80 - 'A')));
+  __m128i is_upper = _mm_cmplt_epi8(shifted, _mm_set1_epi8(-128 + 26));
+  return _mm_or_si128(v, _mm_and_si128(is_upper, _mm_set1_epi8(0x20)));
+}
+
+// Check whether each byte of `v` is at most `max`, as unsigned bytes. SSE2 only
+// has signed comparisons, but it does have an unsigned minimum.
+inline __m128i AtMost128(__m128i v, char max) {
+  return _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(max)), v);
+}
+
+#endif  // CPPSTRING_HAVE_SSE2
+
+#ifdef CPPSTRING_HAVE_AVX2_DISPATCH
+
+// The same as AtMost128, for 32 bytes.
+CPPSTRING_TARGET_AVX2 inline __m256i AtMost256(__m256i v, char max) {
+  return _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(max)), v);
+}
+
+#endif  // CPPSTRING_HAVE_AVX2_DISPATCH
+
+}  // namespace internal
+
+}  // namespace string
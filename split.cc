@@ -1,116 +1,487 @@
 #include "split.h"
 
 #include <algorithm>
-#include <functional>
-#include <list>
-#include <sstream>
-#include <unordered_set>
+#include <stdexcept>
+
+#include "metrics.h"
+#include "simd.h"
 
 namespace string {
 
 namespace {
 
-typedef std::function<void(std::list<std::string>& list,
-                           const std::string& item)>
-    InsertFn;
+// Split `str` from right to left. `add(piece)` is called with each piece, from
+// the last to the first.
+template <typename AddFn>
+void _SplitRightWith(std::string_view str, const internal::CharSet& seps,
+                     bool collapse_empty_groups, int maxsplit,
+                     const AddFn& add) {
+  int n_splits = 0;
 
-std::vector<std::string> _DoSplit(const std::string& str,
-                                  const std::string& sep,
-                                  bool collapse_empty_groups, int maxsplit,
-                                  int i_start, int i_delta) {
-  std::list<std::string> result;
+  // The end of the piece currently being scanned.
+  size_t end = str.size();
+  for (size_t i = str.size(); i > 0; i--) {
+    if (!seps.Contains(str[i - 1])) {
+      continue;
+    }
 
-  // Count the number of splits.
-  int n_splits = 0;
+    // Add everything from here until the last separator to the list.
+    if (end > i) {
+      add(str.substr(i, end - i));
+      n_splits++;
+    } else if (!collapse_empty_groups) {
+      add(std::string_view());
+      n_splits++;
+    }
+
+    end = i - 1;
+
+    // If we have split too many, then stop.
+    if (maxsplit >= 0 && n_splits >= maxsplit) {
+      break;
+    }
+  }
+
+  // Add any remaining data.
+  if (end > 0 || !collapse_empty_groups) {
+    add(str.substr(0, end));
+  }
+}
+
+// Append each string in `list` to `out`, separated by `sep`.
+template <typename List, typename String>
+void _JoinInto(const List& list, std::string_view sep, String& out) {
+  size_t size = list.empty() ? 0 : sep.size() * (list.size() - 1);
+  for (const auto& item : list) {
+    size += item.size();
+  }
+
+  out.reserve(out.size() + size);
+  for (size_t i = 0; i < list.size(); i++) {
+    if (i > 0) {
+      out.append(sep.data(), sep.size());
+    }
+
+    out.append(list[i].data(), list[i].size());
+  }
+}
+
+// Trim all characters in `tokens` from both sides of `str`.
+std::string_view _TrimView(std::string_view str,
+                           const internal::CharSet& tokens) {
+  while (!str.empty() && tokens.Contains(str.front())) {
+    str.remove_prefix(1);
+  }
+
+  while (!str.empty() && tokens.Contains(str.back())) {
+    str.remove_suffix(1);
+  }
+
+  return str;
+}
+
+// Split `str` on separators which are only known at runtime. A single
+// separator can use memchr.
+template <typename AddFn>
+void _SplitOnRuntimeSeps(std::string_view str, std::string_view sep,
+                         bool collapse_empty_groups, int maxsplit,
+                         const AddFn& add) {
+  if (sep.size() == 1) {
+    internal::SplitOnChar(str, sep[0], collapse_empty_groups, maxsplit, add);
+  } else {
+    internal::SplitOnSet(str, internal::CharSet(sep), collapse_empty_groups,
+                         maxsplit, add);
+  }
+}
+
+// The bytes which can start a line break are "\n" and "\r", plus "\v", "\f",
+// "\x1c"-"\x1e" and the lead bytes of U+0085, U+2028 and U+2029 when
+// `unicode` is set. These find the first such byte at or after `i`, or `n` if
+// there is none.
+size_t _FindLineBreakCandidateScalar(const char* data, size_t n, size_t i,
+                                     bool unicode) {
+  for (; i < n; i++) {
+    unsigned char c = data[i];
+    if (c == '\n' || c == '\r') {
+      return i;
+    }
 
-  // Make a set of seps, to make lookups fast.
-  std::unordered_set<char> sep_set;
-  for (char c : sep) {
-    sep_set.insert(c);
+    if (unicode && ((c >= '\v' && c <= '\f') || (c >= 0x1c && c <= 0x1e) ||
+                    c == 0xc2 || c == 0xe2)) {
+      return i;
+    }
   }
 
-  // Function to insert into the result.
-  auto insert = [&i_delta, &result](const std::string& piece) {
-    if (i_delta > 0) {
-      result.push_back(piece);
+  return n;
+}
+
+#ifdef CPPSTRING_HAVE_SSE2
+
+// Check whether each byte of `v` is within [lo, lo + width].
+inline __m128i _InRange128(__m128i v, char lo, char width) {
+  return internal::AtMost128(_mm_sub_epi8(v, _mm_set1_epi8(lo)), width);
+}
+
+size_t _FindLineBreakCandidateSse2(const char* data, size_t n, size_t i,
+                                   bool unicode) {
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    __m128i found;
+    if (unicode) {
+      // "\n", "\v", "\f" and "\r" are adjacent, as are "\x1c"-"\x1e".
+      found = _mm_or_si128(_InRange128(v, '\n', 3), _InRange128(v, 0x1c, 2));
+      found = _mm_or_si128(
+          found, _mm_cmpeq_epi8(v, _mm_set1_epi8(static_cast<char>(0xc2))));
+      found = _mm_or_si128(
+          found, _mm_cmpeq_epi8(v, _mm_set1_epi8(static_cast<char>(0xe2))));
     } else {
-      result.push_front(piece);
-    }
-  };
-
-  int last_sep = i_start - i_delta;
-  for (int i = i_start; i < str.size() && i >= 0; i += i_delta) {
-    char c = str[i];
-
-    // If this character is a delimiter...
-    if (sep_set.find(c) != sep_set.end()) {
-      // Add everything from the last separator until now to the list.
-      auto last_chars =
-          str.substr(std::min(last_sep, i) + 1,
-                     std::max(last_sep, i) - std::min(last_sep, i) - 1);
-
-      // If last_chars is empty and collapse_empty_groups is false, then add.
-      if (last_chars.empty()) {
-        if (!collapse_empty_groups) {
-          insert("");
-          n_splits++;
-        }
-      } else {
-        insert(last_chars);
-        n_splits++;
-      }
+      found = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                           _mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+    }
 
-      last_sep = i;
+    unsigned mask = _mm_movemask_epi8(found);
+    if (mask != 0) {
+      return i + internal::LowestSetBit(mask);
+    }
+  }
 
-      // If we have split too many, then stop.
-      if (maxsplit >= 0 && n_splits >= maxsplit) {
-        break;
-      }
+  return _FindLineBreakCandidateScalar(data, n, i, unicode);
+}
+
+#endif  // CPPSTRING_HAVE_SSE2
+
+#ifdef CPPSTRING_HAVE_AVX2_DISPATCH
+
+CPPSTRING_TARGET_AVX2 inline __m256i _InRange256(__m256i v, char lo,
+                                                 char width) {
+  return internal::AtMost256(_mm256_sub_epi8(v, _mm256_set1_epi8(lo)),
+                             width);
+}
+
+CPPSTRING_TARGET_AVX2 size_t _FindLineBreakCandidateAvx2(const char* data,
+                                                         size_t n, size_t i,
+                                                         bool unicode) {
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    __m256i found;
+    if (unicode) {
+      found = _mm256_or_si256(_InRange256(v, '\n', 3),
+                              _InRange256(v, 0x1c, 2));
+      found = _mm256_or_si256(
+          found,
+          _mm256_cmpeq_epi8(v, _mm256_set1_epi8(static_cast<char>(0xc2))));
+      found = _mm256_or_si256(
+          found,
+          _mm256_cmpeq_epi8(v, _mm256_set1_epi8(static_cast<char>(0xe2))));
+    } else {
+      found = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+                              _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')));
+    }
+
+    unsigned mask = _mm256_movemask_epi8(found);
+    if (mask != 0) {
+      return i + internal::LowestSetBit(mask);
     }
   }
 
-  // Add any remaining data.
-  std::string data = "";
-  if (i_delta > 0) {
-    data = str.substr(last_sep + 1);
-  } else if (i_delta < 0) {
-    data = str.substr(0, last_sep);
+  return _FindLineBreakCandidateScalar(data, n, i, unicode);
+}
+
+#endif  // CPPSTRING_HAVE_AVX2_DISPATCH
+
+size_t _FindLineBreakCandidate(const char* data, size_t n, size_t i,
+                               bool unicode) {
+#ifdef CPPSTRING_HAVE_AVX2_DISPATCH
+  if (internal::CpuHasAvx2()) {
+    return _FindLineBreakCandidateAvx2(data, n, i, unicode);
   }
+#endif  // CPPSTRING_HAVE_AVX2_DISPATCH
+
+#ifdef CPPSTRING_HAVE_SSE2
+  return _FindLineBreakCandidateSse2(data, n, i, unicode);
+#else
+  return _FindLineBreakCandidateScalar(data, n, i, unicode);
+#endif  // CPPSTRING_HAVE_SSE2
+}
 
-  if (!data.empty() || !collapse_empty_groups) {
-    insert(data);
+// Get the length of the line break at `i`, or 0 if the candidate byte there
+// doesn't start one. The bytes after it are read from `data` itself rather than
+// the block it was found in, so a "\r\n" split across two blocks is still a
+// single line break.
+size_t _LineBreakLength(const char* data, size_t n, size_t i) {
+  switch (static_cast<unsigned char>(data[i])) {
+    case '\r':
+      return i + 1 < n && data[i + 1] == '\n' ? 2 : 1;
+    case 0xc2:
+      // U+0085 NEL.
+      return i + 1 < n && static_cast<unsigned char>(data[i + 1]) == 0x85 ? 2
+                                                                          : 0;
+    case 0xe2:
+      // U+2028 LINE SEPARATOR and U+2029 PARAGRAPH SEPARATOR.
+      if (i + 2 < n && static_cast<unsigned char>(data[i + 1]) == 0x80 &&
+          (static_cast<unsigned char>(data[i + 2]) & 0xfe) == 0xa8) {
+        return 3;
+      }
+
+      return 0;
+    default:
+      return 1;
   }
+}
 
-  // Copy the list to a vector.
-  std::vector<std::string> result_vec(result.size());
-  std::copy(result.begin(), result.end(), result_vec.begin());
-  return result_vec;
+bool _KeyLess(const KeyValueMap::value_type& a,
+              const KeyValueMap::value_type& b) {
+  return a.first < b.first;
 }
 
 }  // namespace
 
-std::vector<std::string> Split(const std::string& str, const std::string& sep,
+std::vector<std::string> Split(const std::string& str, std::string_view sep,
                                bool collapse_empty_groups, int maxsplit) {
-  return _DoSplit(str, sep, collapse_empty_groups, maxsplit, 0, 1);
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kSplit, str.size());
+  std::vector<std::string> result;
+  _SplitOnRuntimeSeps(str, sep, collapse_empty_groups, maxsplit,
+                      internal::AppendTo(result));
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
+  return result;
+}
+
+std::vector<std::string_view> SplitInterned(std::string_view str,
+                                            StringPool& pool,
+                                            std::string_view sep,
+                                            bool collapse_empty_groups,
+                                            int maxsplit) {
+  std::vector<std::string_view> result;
+  _SplitOnRuntimeSeps(str, sep, collapse_empty_groups, maxsplit,
+                      [&](std::string_view piece) {
+                        result.push_back(pool.Intern(piece));
+                      });
+  return result;
+}
+
+std::vector<StringPool::Id> SplitInternedIds(std::string_view str,
+                                             StringPool& pool,
+                                             std::string_view sep,
+                                             bool collapse_empty_groups,
+                                             int maxsplit) {
+  std::vector<StringPool::Id> result;
+  _SplitOnRuntimeSeps(str, sep, collapse_empty_groups, maxsplit,
+                      [&](std::string_view piece) {
+                        result.push_back(pool.InternId(piece));
+                      });
+  return result;
 }
 
 std::vector<std::string> SplitRight(const std::string& str,
-                                    const std::string& sep,
+                                    std::string_view sep,
                                     bool collapse_empty_groups, int maxsplit) {
-  return _DoSplit(str, sep, collapse_empty_groups, maxsplit, str.size() - 1,
-                  -1);
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kSplitRight, str.size());
+  std::vector<std::string> result;
+  _SplitRightWith(str, internal::CharSet(sep), collapse_empty_groups, maxsplit,
+                  internal::AppendTo(result));
+  std::reverse(result.begin(), result.end());
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
+  return result;
 }
 
 std::string Join(const std::vector<std::string>& list, const std::string& sep) {
-  std::stringstream output;
-  for (int i = 0; i < list.size(); i++) {
-    output << list[i];
-    if (i < list.size() - 1) {
-      output << sep;
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kJoin, 0);
+  std::string result;
+  _JoinInto(list, sep, result);
+  CPPSTRING_METRICS_INPUT(
+      metrics,
+      result.size() - sep.size() * (std::max<size_t>(list.size(), 1) - 1));
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
+  return result;
+}
+
+std::pmr::vector<std::pmr::string> Split(const std::string& str,
+                                         std::pmr::memory_resource* resource,
+                                         std::string_view sep,
+                                         bool collapse_empty_groups,
+                                         int maxsplit) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kSplit, str.size());
+  std::pmr::vector<std::pmr::string> result(resource);
+  _SplitOnRuntimeSeps(str, sep, collapse_empty_groups, maxsplit,
+                      internal::AppendTo(result));
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
+  return result;
+}
+
+std::pmr::vector<std::pmr::string> SplitRight(
+    const std::string& str, std::pmr::memory_resource* resource,
+    std::string_view sep, bool collapse_empty_groups, int maxsplit) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kSplitRight, str.size());
+  std::pmr::vector<std::pmr::string> result(resource);
+  _SplitRightWith(str, internal::CharSet(sep), collapse_empty_groups, maxsplit,
+                  internal::AppendTo(result));
+  std::reverse(result.begin(), result.end());
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
+  return result;
+}
+
+std::pmr::string Join(const std::vector<std::string>& list,
+                      std::string_view sep,
+                      std::pmr::memory_resource* resource) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kJoin, 0);
+  std::pmr::string result(resource);
+  _JoinInto(list, sep, result);
+  CPPSTRING_METRICS_INPUT(
+      metrics,
+      result.size() - sep.size() * (std::max<size_t>(list.size(), 1) - 1));
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
+  return result;
+}
+
+std::pmr::string Join(const std::pmr::vector<std::pmr::string>& list,
+                      std::string_view sep,
+                      std::pmr::memory_resource* resource) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kJoin, 0);
+  std::pmr::string result(resource);
+  _JoinInto(list, sep, result);
+  CPPSTRING_METRICS_INPUT(
+      metrics,
+      result.size() - sep.size() * (std::max<size_t>(list.size(), 1) - 1));
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
+  return result;
+}
+
+KeyValueMap::const_iterator KeyValueMap::find(std::string_view key) const {
+  auto range = equal_range(key);
+  return range.first == range.second ? end() : range.first;
+}
+
+std::pair<KeyValueMap::const_iterator, KeyValueMap::const_iterator>
+KeyValueMap::equal_range(std::string_view key) const {
+  return std::equal_range(entries_.begin(), entries_.end(),
+                          value_type(key, std::string_view()), _KeyLess);
+}
+
+size_t KeyValueMap::count(std::string_view key) const {
+  auto range = equal_range(key);
+  return range.second - range.first;
+}
+
+std::string_view KeyValueMap::at(std::string_view key) const {
+  auto it = find(key);
+  if (it == end()) {
+    throw std::out_of_range("Key not found in KeyValueMap.");
+  }
+
+  return it->second;
+}
+
+KeyValueMap SplitKeyValue(std::string_view str, const std::string& pair_sep,
+                          const std::string& kv_sep, const std::string& trim,
+                          DuplicateKeys duplicates) {
+  internal::CharSet pair_set(pair_sep), kv_set(kv_sep), trim_set(trim);
+
+  KeyValueMap map;
+  auto& entries = map.entries_;
+
+  // Scan the string once, remembering where the current pair started and where
+  // its first key/value separator is.
+  size_t start = 0, kv = std::string_view::npos;
+  for (size_t i = 0; i <= str.size(); i++) {
+    if (i < str.size() && !pair_set.Contains(str[i])) {
+      if (kv == std::string_view::npos && kv_set.Contains(str[i])) {
+        kv = i;
+      }
+
+      continue;
     }
+
+    // [start, i) is a complete pair.
+    std::string_view key, value;
+    if (kv == std::string_view::npos) {
+      key = _TrimView(str.substr(start, i - start), trim_set);
+    } else {
+      key = _TrimView(str.substr(start, kv - start), trim_set);
+      value = _TrimView(str.substr(kv + 1, i - kv - 1), trim_set);
+    }
+
+    if (!key.empty() || kv != std::string_view::npos) {
+      entries.emplace_back(key, value);
+    }
+
+    start = i + 1;
+    kv = std::string_view::npos;
+  }
+
+  // Sort by key. The sort is stable, so duplicate keys stay in the order they
+  // appeared in `str`.
+  std::stable_sort(entries.begin(), entries.end(), _KeyLess);
+  if (duplicates == DuplicateKeys::kKeepAll) {
+    return map;
+  }
+
+  // Collapse runs of duplicate keys down to a single entry.
+  size_t out = 0;
+  for (size_t i = 0; i < entries.size();) {
+    size_t j = i + 1;
+    while (j < entries.size() && entries[j].first == entries[i].first) {
+      j++;
+    }
+
+    entries[out++] =
+        entries[duplicates == DuplicateKeys::kKeepFirst ? i : j - 1];
+    i = j;
+  }
+
+  entries.resize(out);
+  return map;
+}
+
+namespace internal {
+
+size_t FindLineBreak(std::string_view text, size_t pos, bool unicode,
+                     size_t* length) {
+  const char* data = text.data();
+  size_t n = text.size();
+  for (size_t i = pos; i < n; i++) {
+    i = _FindLineBreakCandidate(data, n, i, unicode);
+    if (i == n) {
+      break;
+    }
+
+    *length = _LineBreakLength(data, n, i);
+    if (*length > 0) {
+      return i;
+    }
+  }
+
+  return std::string::npos;
+}
+
+}  // namespace internal
+
+void Lines::iterator::Find(size_t start) {
+  std::string_view text = lines_->text_;
+  if (start >= text.size()) {
+    start_ = std::string::npos;
+    line_ = std::string_view();
+    return;
+  }
+
+  size_t length = 0;
+  size_t end = internal::FindLineBreak(text, start, lines_->unicode_, &length);
+  if (end == std::string::npos) {
+    end = text.size();
+  }
+
+  start_ = start;
+  next_ = end + length;
+  line_ = text.substr(start, end - start + (lines_->keepends_ ? length : 0));
+}
+
+std::vector<std::string_view> SplitLines(std::string_view text, bool keepends,
+                                         bool unicode) {
+  std::vector<std::string_view> result;
+  for (std::string_view line : Lines(text, keepends, unicode)) {
+    result.push_back(line);
   }
 
-  return output.str();
+  return result;
 }
 
 }  // namespace string
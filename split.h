@@ -1,12 +1,100 @@
 #pragma once
 
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory_resource>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+#include "charset.h"
 #include "constants.h"
+#include "pool.h"
 
 namespace string {
 
+// Internal; don't use directly.
+namespace internal {
+
+// Split `str` from left to right. `find_sep(pos)` should return the position of
+// the first separator at or after `pos`, or std::string::npos if there is none.
+// `add(piece)` is called with each piece, in order.
+template <typename FindSepFn, typename AddFn>
+void SplitWith(std::string_view str, const FindSepFn& find_sep,
+               const AddFn& add, bool collapse_empty_groups, int maxsplit) {
+  int n_splits = 0;
+
+  size_t start = 0, sep = find_sep(0);
+  while (sep != std::string::npos) {
+    // Add everything from the last separator until now to the list.
+    if (sep > start) {
+      add(str.substr(start, sep - start));
+      n_splits++;
+    } else if (!collapse_empty_groups) {
+      add(std::string_view());
+      n_splits++;
+    }
+
+    start = sep + 1;
+
+    // If we have split too many, then stop.
+    if (maxsplit >= 0 && n_splits >= maxsplit) {
+      break;
+    }
+
+    sep = find_sep(start);
+  }
+
+  // Add any remaining data.
+  if (start < str.size() || !collapse_empty_groups) {
+    add(str.substr(start));
+  }
+}
+
+// Split `str` on a set of separators.
+template <typename AddFn>
+void SplitOnSet(std::string_view str, const CharSet& seps,
+                bool collapse_empty_groups, int maxsplit, const AddFn& add) {
+  SplitWith(
+      str, [str, &seps](size_t pos) { return FindFirstOf(str, seps, pos); },
+      add, collapse_empty_groups, maxsplit);
+}
+
+// Split `str` on a single separator. This uses memchr, which will generally be
+// vectorized by the C library.
+template <typename AddFn>
+void SplitOnChar(std::string_view str, char sep, bool collapse_empty_groups,
+                 int maxsplit, const AddFn& add) {
+  SplitWith(str,
+            [str, sep](size_t pos) -> size_t {
+              if (pos >= str.size()) {
+                return std::string::npos;
+              }
+
+              auto found = static_cast<const char*>(
+                  memchr(str.data() + pos, sep, str.size() - pos));
+              return found ? found - str.data() : std::string::npos;
+            },
+            add, collapse_empty_groups, maxsplit);
+}
+
+// Get a function which appends each piece it is called with to `pieces`.
+template <typename Container>
+auto AppendTo(Container& pieces) {
+  return [&pieces](std::string_view piece) { pieces.emplace_back(piece); };
+}
+
+// Find the first line break in `text` at or after `pos`, and store its length
+// in `length` ("\r\n" is a single line break of length 2). Returns
+// std::string::npos if there is none. See SplitLines for which line breaks are
+// recognised.
+size_t FindLineBreak(std::string_view text, size_t pos, bool unicode,
+                     size_t* length);
+
+}  // namespace internal
+
 /**
  * @brief      Split a string into components based on a list of separators.
  *
@@ -40,10 +128,118 @@ namespace string {
  * @see        SplitRight
  */
 std::vector<std::string> Split(const std::string& str,
-                               const std::string& sep = kWhitespace,
+                               std::string_view sep = kWhitespace,
                                bool collapse_empty_groups = false,
                                int maxsplit = -1);
 
+/**
+ * @brief      Split a string on separators which are known at compile time.
+ *
+ * @details    Identical to Split, except that the separators are given as
+ *             template arguments, so the lookup table is built at compile time.
+ *             When only a single separator is given, a memchr based search is
+ *             used.
+ *
+ *                 Split<','>("a,b,c") -> {"a", "b", "c"}
+ *                 Split<',', '|'>("a,b|c") -> {"a", "b", "c"}
+ *
+ * @param[in]  str                     The string to split.
+ * @param[in]  collapse_empty_groups   When true, collapse adjacent delimiters
+ *                                     into a single delimiter.
+ * @param[in]  maxsplit                The maximum number of splits to perform.
+ *                                     Set to -1 for unlimited.
+ *
+ * @tparam     Sep   The separators to split by.
+ *
+ * @return     A vector of strings, which are the parts of `str`.
+ * @see        Split
+ */
+template <char Sep, char... Seps>
+std::vector<std::string> Split(const std::string& str,
+                               bool collapse_empty_groups = false,
+                               int maxsplit = -1) {
+  std::vector<std::string> result;
+  if (sizeof...(Seps) == 0) {
+    internal::SplitOnChar(str, Sep, collapse_empty_groups, maxsplit,
+                          internal::AppendTo(result));
+    return result;
+  }
+
+  static constexpr internal::CharSet kSeps =
+      internal::MakeCharSet<Sep, Seps...>();
+  internal::SplitOnSet(str, kSeps, collapse_empty_groups, maxsplit,
+                       internal::AppendTo(result));
+  return result;
+}
+
+/**
+ * @brief      Split a string on all characters within a CharClass.
+ *
+ *                 Split<CharClass::Whitespace>("a b\tc") -> {"a", "b", "c"}
+ *
+ * @param[in]  str                     The string to split.
+ * @param[in]  collapse_empty_groups   When true, collapse adjacent delimiters
+ *                                     into a single delimiter.
+ * @param[in]  maxsplit                The maximum number of splits to perform.
+ *                                     Set to -1 for unlimited.
+ *
+ * @tparam     Class  The class of characters to split by.
+ *
+ * @return     A vector of strings, which are the parts of `str`.
+ * @see        Split
+ */
+template <CharClass Class>
+std::vector<std::string> Split(const std::string& str,
+                               bool collapse_empty_groups = false,
+                               int maxsplit = -1) {
+  static constexpr internal::CharSet kSeps = internal::CharClassSet(Class);
+  std::vector<std::string> result;
+  internal::SplitOnSet(str, kSeps, collapse_empty_groups, maxsplit,
+                       internal::AppendTo(result));
+  return result;
+}
+
+/**
+ * @brief      Same as Split, but interns each piece into `pool`.
+ *
+ * @details    Each distinct piece is only stored once in `pool`, however many
+ *             times it occurs, and equal pieces have the same data pointer.
+ *             This saves a lot of memory when the same tokens occur over and
+ *             over, e.g. when splitting many log lines. For example:
+ *
+ *                 StringPool pool;
+ *                 auto a = SplitInterned("GET /a", pool, " ");
+ *                 auto b = SplitInterned("GET /b", pool, " ");
+ *                 a[0].data() == b[0].data() -> true
+ *
+ * @param[in]  str                     The string to split.
+ * @param      pool                    The pool to intern the pieces into.
+ * @param[in]  sep                     The separators to split by.
+ * @param[in]  collapse_empty_groups   When true, collapse adjacent delimiters
+ *                                     into a single delimiter.
+ * @param[in]  maxsplit                The maximum number of splits to perform.
+ *                                     Set to -1 for unlimited.
+ *
+ * @return     Views of the interned pieces of `str`, which live as long as
+ *             `pool`.
+ * @see        Split
+ * @see        StringPool
+ */
+std::vector<std::string_view> SplitInterned(std::string_view str,
+                                            StringPool& pool,
+                                            std::string_view sep = kWhitespace,
+                                            bool collapse_empty_groups = false,
+                                            int maxsplit = -1);
+
+/**
+ * @brief      Same as SplitInterned, but returns the id of each piece.
+ * @see        SplitInterned
+ * @see        StringPool::Get
+ */
+std::vector<StringPool::Id> SplitInternedIds(
+    std::string_view str, StringPool& pool, std::string_view sep = kWhitespace,
+    bool collapse_empty_groups = false, int maxsplit = -1);
+
 /**
  * @brief      Same as Split, but starts scanning from the RHS of the string.
  *
@@ -58,7 +254,7 @@ std::vector<std::string> Split(const std::string& str,
  * @see        Split
  */
 std::vector<std::string> SplitRight(const std::string& str,
-                                    const std::string& sep = kWhitespace,
+                                    std::string_view sep = kWhitespace,
                                     bool collapse_empty_groups = false,
                                     int maxsplit = -1);
 
@@ -72,4 +268,279 @@ std::vector<std::string> SplitRight(const std::string& str,
  */
 std::string Join(const std::vector<std::string>& list, const std::string& sep);
 
+/**
+ * @brief      Same as Split, but allocates the result from `resource`.
+ *
+ * @details    Both the vector and each string in it use `resource`, so the
+ *             whole result can be released at once by using an arena such as
+ *             std::pmr::monotonic_buffer_resource.
+ *
+ * @param[in]  str                     The string to split.
+ * @param      resource                The memory resource to allocate from.
+ * @param[in]  sep                     The separators to split by.
+ * @param[in]  collapse_empty_groups   When true, collapse adjacent delimiters
+ *                                     into a single delimiter.
+ * @param[in]  maxsplit                The maximum number of splits to perform.
+ *                                     Set to -1 for unlimited.
+ *
+ * @return     A vector of strings, which are the parts of `str`.
+ * @see        Split
+ */
+std::pmr::vector<std::pmr::string> Split(const std::string& str,
+                                         std::pmr::memory_resource* resource,
+                                         std::string_view sep = kWhitespace,
+                                         bool collapse_empty_groups = false,
+                                         int maxsplit = -1);
+
+/**
+ * @brief      Same as SplitRight, but allocates the result from `resource`.
+ * @see        SplitRight
+ */
+std::pmr::vector<std::pmr::string> SplitRight(
+    const std::string& str, std::pmr::memory_resource* resource,
+    std::string_view sep = kWhitespace, bool collapse_empty_groups = false,
+    int maxsplit = -1);
+
+/**
+ * @brief      Same as Join, but allocates the result from `resource`.
+ * @see        Join
+ */
+std::pmr::string Join(const std::vector<std::string>& list,
+                      std::string_view sep,
+                      std::pmr::memory_resource* resource);
+
+/**
+ * @brief      Same as Join, but joins strings which were allocated from a
+ *             memory resource, and allocates the result from `resource`.
+ * @see        Join
+ */
+std::pmr::string Join(const std::pmr::vector<std::pmr::string>& list,
+                      std::string_view sep,
+                      std::pmr::memory_resource* resource);
+
+/**
+ * @brief      A lazy range over the lines of a string.
+ *
+ * @details    Each line is found only when the iterator reaches it, so this can
+ *             stop early without scanning the rest of the string:
+ *
+ *                 for (std::string_view line : Lines(text)) {
+ *                   if (line.empty()) break;
+ *                   ...
+ *                 }
+ *
+ *             The lines are the same as those returned by SplitLines, and are
+ *             views into `text`, so `text` must outlive the range.
+ *
+ * @see        SplitLines
+ */
+class Lines {
+ public:
+  class iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef std::string_view value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const std::string_view* pointer;
+    typedef const std::string_view& reference;
+
+    iterator() = default;
+
+    reference operator*() const { return line_; }
+    pointer operator->() const { return &line_; }
+
+    iterator& operator++() {
+      Find(next_);
+      return *this;
+    }
+
+    iterator operator++(int) {
+      iterator copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    friend bool operator==(const iterator& a, const iterator& b) {
+      return a.start_ == b.start_;
+    }
+
+    friend bool operator!=(const iterator& a, const iterator& b) {
+      return !(a == b);
+    }
+
+   private:
+    friend class Lines;
+
+    iterator(const Lines* lines, size_t start) : lines_(lines) { Find(start); }
+
+    // Move to the line starting at `start`.
+    void Find(size_t start);
+
+    const Lines* lines_ = nullptr;
+    size_t start_ = std::string::npos;
+    size_t next_ = std::string::npos;
+    std::string_view line_;
+  };
+
+  typedef iterator const_iterator;
+
+  /**
+   * @param[in]  text      The string to split into lines.
+   * @param[in]  keepends  When true, each line includes its line break.
+   * @param[in]  unicode   When true, also break lines on the Unicode line
+   *                       breaks listed in SplitLines.
+   */
+  explicit Lines(std::string_view text, bool keepends = false,
+                 bool unicode = false)
+      : text_(text), keepends_(keepends), unicode_(unicode) {}
+
+  iterator begin() const { return iterator(this, 0); }
+  iterator end() const { return iterator(); }
+
+ private:
+  std::string_view text_;
+  bool keepends_;
+  bool unicode_;
+};
+
+/**
+ * @brief      Split a string into lines.
+ *
+ * @details    This follows Python's `splitlines`. Lines end at "\n", "\r" or
+ *             "\r\n", and a line break at the very end of `text` doesn't start
+ *             another, empty line. For example:
+ *
+ *                 SplitLines("a\r\nb\n\nc\n") -> {"a", "b", "", "c"}
+ *                 SplitLines("a\r\nb\n", true) -> {"a\r\n", "b\n"}
+ *
+ *             When `unicode` is set, lines also end at "\v", "\f", "\x1c",
+ *             "\x1d", "\x1e", and the UTF-8 encodings of U+0085 (NEL), U+2028
+ *             (LINE SEPARATOR) and U+2029 (PARAGRAPH SEPARATOR), like Python's
+ *             `str.splitlines`.
+ *
+ *             Line breaks are found 32 or 16 bytes at a time with AVX2 or SSE2
+ *             where the CPU supports them. No copies are made: the lines are
+ *             views into `text`, so `text` must outlive them.
+ *
+ * @param[in]  text      The string to split into lines.
+ * @param[in]  keepends  When true, each line includes its line break.
+ * @param[in]  unicode   When true, also break lines on the Unicode line
+ *                       breaks above.
+ *
+ * @return     A vector of the lines of `text`.
+ * @see        Lines
+ */
+std::vector<std::string_view> SplitLines(std::string_view text,
+                                         bool keepends = false,
+                                         bool unicode = false);
+
+/**
+ * What SplitKeyValue should do when a key appears more than once.
+ * @see        SplitKeyValue
+ */
+enum class DuplicateKeys {
+  kKeepFirst,
+  kKeepLast,
+  kKeepAll,
+};
+
+/**
+ * @brief      A read-only, flat map of keys to values, returned by
+ *             SplitKeyValue.
+ *
+ * @details    Entries are stored in a single vector sorted by key, so lookups
+ *             are a binary search and iteration is in key order. Keys and
+ *             values are views into the string which was split, so that string
+ *             must outlive the map.
+ *
+ * @see        SplitKeyValue
+ */
+class KeyValueMap {
+ public:
+  typedef std::pair<std::string_view, std::string_view> value_type;
+  typedef std::vector<value_type>::const_iterator const_iterator;
+
+  const_iterator begin() const { return entries_.begin(); }
+  const_iterator end() const { return entries_.end(); }
+  size_t size() const { return entries_.size(); }
+  bool empty() const { return entries_.empty(); }
+
+  /**
+   * @brief      Find the first entry with the given key.
+   *
+   * @param[in]  key   The key to search for.
+   *
+   * @return     An iterator to the entry, or `end()` if there is none.
+   */
+  const_iterator find(std::string_view key) const;
+
+  /**
+   * @brief      Get all entries with the given key.
+   *
+   * @details    There will only be more than one entry when the map was built
+   *             with `DuplicateKeys::kKeepAll`.
+   *
+   * @param[in]  key   The key to search for.
+   *
+   * @return     A [first, last) range of all entries with key `key`.
+   */
+  std::pair<const_iterator, const_iterator> equal_range(
+      std::string_view key) const;
+
+  /**
+   * @brief      Count the number of entries with the given key.
+   */
+  size_t count(std::string_view key) const;
+
+  /**
+   * @brief      Get the value of the first entry with the given key.
+   *
+   * @param[in]  key   The key to search for.
+   *
+   * @throws     std::out_of_range Thrown if the key isn't in the map.
+   *
+   * @return     The value associated with `key`.
+   */
+  std::string_view at(std::string_view key) const;
+
+ private:
+  friend KeyValueMap SplitKeyValue(std::string_view, const std::string&,
+                                   const std::string&, const std::string&,
+                                   DuplicateKeys);
+
+  std::vector<value_type> entries_;
+};
+
+/**
+ * @brief      Split a string of key/value pairs into a map in a single pass.
+ *
+ * @details    The string is split into pairs on any character within
+ *             `pair_sep`, and each pair is split into a key and a value on the
+ *             first character within `kv_sep`. For example:
+ *
+ *                 SplitKeyValue("a=1&b=2") -> {{"a", "1"}, {"b", "2"}}
+ *                 SplitKeyValue("a=1; b=2", ";", "=", " ") ->
+ *                     {{"a", "1"}, {"b", "2"}}
+ *
+ *             A pair with no `kv_sep` character in it is a key with an empty
+ *             value. Empty pairs (e.g. from `"a=1&&b=2"`) are skipped.
+ *
+ *             No copies are made: the keys and values in the returned map are
+ *             views into `str`, so `str` must outlive the map.
+ *
+ * @param[in]  str         The string to split.
+ * @param[in]  pair_sep    The separators between each pair.
+ * @param[in]  kv_sep      The separators between a key and its value.
+ * @param[in]  trim        Characters to trim from both sides of each key and
+ *                         value.
+ * @param[in]  duplicates  What to do when a key appears more than once.
+ *
+ * @return     A map of all keys to their values.
+ */
+KeyValueMap SplitKeyValue(std::string_view str,
+                          const std::string& pair_sep = "&",
+                          const std::string& kv_sep = "=",
+                          const std::string& trim = "",
+                          DuplicateKeys duplicates = DuplicateKeys::kKeepLast);
+
 }  // namespace string
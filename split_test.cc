@@ -169,3 +169,347 @@ TEST(TestJoin, TestJoinWithEmptySepJustJoinsCharacters) {
 TEST(TestJoin, TestJoinWithEmptySepAndEmptyListReturnsEmptyString) {
   ASSERT_STREQ("", string::Join({}, "").c_str());
 }
+
+TEST(TestSplitStatic, TestSplitStaticWithSingleSep) {
+  std::vector<std::string> out{"a", "b", "c"};
+  ASSERT_EQ(out, string::Split<','>("a,b,c"));
+}
+
+TEST(TestSplitStatic, TestSplitStaticWithMultipleSeps) {
+  std::vector<std::string> out{"a", "b", "c"};
+  ASSERT_EQ(out, (string::Split<',', '|'>("a,b|c")));
+}
+
+TEST(TestSplitStatic, TestSplitStaticWithSepsAtEndIncludesEmptySpaces) {
+  std::vector<std::string> out{"", "a", "b", "c", ""};
+  ASSERT_EQ(out, string::Split<','>(",a,b,c,"));
+}
+
+TEST(TestSplitStatic, TestSplitStaticWithCollapseEmptyGroups) {
+  std::vector<std::string> out{"a", "b", "c"};
+  ASSERT_EQ(out, (string::Split<',', '|'>("||a,|,b,c||", true)));
+}
+
+TEST(TestSplitStatic, TestSplitStaticRespectsMaxsplit) {
+  std::vector<std::string> out{"a", "b,c||"};
+  ASSERT_EQ(out, (string::Split<',', '|'>("||a,b,c||", true, 1)));
+}
+
+TEST(TestSplitStatic, TestSplitStaticWithCharClass) {
+  std::vector<std::string> out{"a", "b", "c"};
+  ASSERT_EQ(out, string::Split<string::CharClass::Whitespace>(" a\tb\r\nc ",
+                                                               true));
+}
+
+TEST(TestSplitStatic, TestSplitStaticMatchesRuntimeSplit) {
+  for (const std::string str : {"", ",", "a", ",,a,,b,", "a,b,,c,d"}) {
+    for (int maxsplit : {-1, 0, 1, 2}) {
+      ASSERT_EQ(string::Split(str, ",", false, maxsplit),
+                string::Split<','>(str, false, maxsplit));
+      ASSERT_EQ(string::Split(str, ",", true, maxsplit),
+                string::Split<','>(str, true, maxsplit));
+    }
+  }
+}
+
+TEST(TestSplitKeyValue, TestSplitKeyValueWithBasicString) {
+  auto map = string::SplitKeyValue("a=1&b=2&c=3");
+  ASSERT_EQ(3, map.size());
+  ASSERT_EQ("1", map.at("a"));
+  ASSERT_EQ("2", map.at("b"));
+  ASSERT_EQ("3", map.at("c"));
+}
+
+TEST(TestSplitKeyValue, TestSplitKeyValueOnlySplitsOnFirstKeyValueSep) {
+  auto map = string::SplitKeyValue("a=1=2&b==");
+  ASSERT_EQ("1=2", map.at("a"));
+  ASSERT_EQ("=", map.at("b"));
+}
+
+TEST(TestSplitKeyValue, TestSplitKeyValueWithMissingValue) {
+  auto map = string::SplitKeyValue("a&b=");
+  ASSERT_EQ(2, map.size());
+  ASSERT_EQ("", map.at("a"));
+  ASSERT_EQ("", map.at("b"));
+}
+
+TEST(TestSplitKeyValue, TestSplitKeyValueSkipsEmptyPairs) {
+  auto map = string::SplitKeyValue("&a=1&&b=2&");
+  ASSERT_EQ(2, map.size());
+}
+
+TEST(TestSplitKeyValue, TestSplitKeyValueWithCustomSepsAndTrim) {
+  auto map = string::SplitKeyValue(" a = 1 ; b=2;c :3 ", ";", "=:", " ");
+  ASSERT_EQ("1", map.at("a"));
+  ASSERT_EQ("2", map.at("b"));
+  ASSERT_EQ("3", map.at("c"));
+}
+
+TEST(TestSplitKeyValue, TestSplitKeyValueIteratesInKeyOrder) {
+  auto map = string::SplitKeyValue("c=3&a=1&b=2");
+  std::vector<std::string> keys;
+  for (const auto& entry : map) {
+    keys.emplace_back(entry.first);
+  }
+
+  std::vector<std::string> out{"a", "b", "c"};
+  ASSERT_EQ(out, keys);
+}
+
+TEST(TestSplitKeyValue, TestSplitKeyValueMissingKey) {
+  auto map = string::SplitKeyValue("a=1");
+  ASSERT_EQ(map.end(), map.find("b"));
+  ASSERT_EQ(0, map.count("b"));
+  ASSERT_THROW(map.at("b"), std::out_of_range);
+}
+
+TEST(TestSplitKeyValue, TestSplitKeyValueDuplicateKeys) {
+  const std::string str = "a=1&b=2&a=3&a=4";
+  using string::DuplicateKeys;
+
+  auto last =
+      string::SplitKeyValue(str, "&", "=", "", DuplicateKeys::kKeepLast);
+  ASSERT_EQ(2, last.size());
+  ASSERT_EQ("4", last.at("a"));
+
+  auto first =
+      string::SplitKeyValue(str, "&", "=", "", DuplicateKeys::kKeepFirst);
+  ASSERT_EQ(2, first.size());
+  ASSERT_EQ("1", first.at("a"));
+
+  auto all = string::SplitKeyValue(str, "&", "=", "", DuplicateKeys::kKeepAll);
+  ASSERT_EQ(4, all.size());
+  ASSERT_EQ(3, all.count("a"));
+
+  std::vector<std::string> values;
+  auto range = all.equal_range("a");
+  for (auto it = range.first; it != range.second; ++it) {
+    values.emplace_back(it->second);
+  }
+
+  std::vector<std::string> out{"1", "3", "4"};
+  ASSERT_EQ(out, values);
+}
+
+TEST(TestSplitInterned, TestSplitInternedSharesRepeatedPieces) {
+  string::StringPool pool;
+  auto a = string::SplitInterned("GET /a 200", pool, " ");
+  auto b = string::SplitInterned("GET /b 200", pool, " ");
+  std::vector<std::string_view> out{"GET", "/a", "200"};
+  ASSERT_EQ(out, a);
+  ASSERT_EQ(a[0].data(), b[0].data());
+  ASSERT_EQ(a[2].data(), b[2].data());
+  ASSERT_EQ(4, pool.size());
+}
+
+TEST(TestSplitInterned, TestSplitInternedMatchesSplit) {
+  string::StringPool pool;
+  std::string str = "a,|,b,c,,";
+  for (bool collapse : {false, true}) {
+    auto expected = string::Split(str, ",|", collapse, 2);
+    auto pieces = string::SplitInterned(str, pool, ",|", collapse, 2);
+    ASSERT_EQ(expected.size(), pieces.size());
+    for (size_t i = 0; i < pieces.size(); i++) {
+      ASSERT_EQ(expected[i], pieces[i]);
+    }
+  }
+}
+
+TEST(TestSplitInterned, TestSplitInternedIds) {
+  string::StringPool pool;
+  auto ids = string::SplitInternedIds("x y x", pool);
+  ASSERT_EQ(3, ids.size());
+  ASSERT_EQ(ids[0], ids[2]);
+  ASSERT_NE(ids[0], ids[1]);
+  ASSERT_EQ("y", pool.Get(ids[1]));
+}
+
+TEST(TestSplitMemoryResource, TestSplitAllocatesFromResource) {
+  // Everything must come from the buffer, since there is no upstream.
+  char buffer[4096];
+  std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+                                            std::pmr::null_memory_resource());
+
+  auto pieces = string::Split("a long first piece,b,,c", &arena, ",");
+  ASSERT_EQ(4, pieces.size());
+  ASSERT_EQ("a long first piece", pieces[0]);
+  ASSERT_EQ("", pieces[2]);
+  ASSERT_EQ(&arena, pieces.get_allocator().resource());
+  ASSERT_EQ(&arena, pieces[0].get_allocator().resource());
+
+  auto right = string::SplitRight("a,b,c", &arena, ",", false, 1);
+  ASSERT_EQ(2, right.size());
+  ASSERT_EQ("a,b", right[0]);
+  ASSERT_EQ("c", right[1]);
+
+  auto joined = string::Join(pieces, "|", &arena);
+  ASSERT_EQ("a long first piece|b||c", joined);
+  ASSERT_EQ(&arena, joined.get_allocator().resource());
+
+  ASSERT_EQ("x-y", string::Join(std::vector<std::string>{"x", "y"}, "-",
+                                &arena));
+}
+
+TEST(TestSplitMemoryResource, TestSplitMatchesSplit) {
+  std::pmr::monotonic_buffer_resource arena;
+  for (std::string str : {"", ",", "a,,b", ",a,b,", "abc"}) {
+    for (bool collapse : {false, true}) {
+      for (int maxsplit : {-1, 0, 1, 2}) {
+        auto expected = string::Split(str, ",", collapse, maxsplit);
+        auto pieces = string::Split(str, &arena, ",", collapse, maxsplit);
+        ASSERT_EQ(expected.size(), pieces.size());
+        for (size_t i = 0; i < pieces.size(); i++) {
+          ASSERT_EQ(expected[i], std::string_view(pieces[i]));
+        }
+
+        auto expected_right =
+            string::SplitRight(str, ",", collapse, maxsplit);
+        auto right = string::SplitRight(str, &arena, ",", collapse, maxsplit);
+        ASSERT_EQ(expected_right.size(), right.size());
+        for (size_t i = 0; i < right.size(); i++) {
+          ASSERT_EQ(expected_right[i], std::string_view(right[i]));
+        }
+      }
+    }
+  }
+}
+
+namespace {
+
+typedef std::vector<std::string_view> LineViews;
+
+// A simple reference for SplitLines, which checks one byte at a time.
+LineViews SplitLinesReference(std::string_view text, bool keepends,
+                          bool unicode) {
+  LineViews lines;
+  size_t start = 0;
+  for (size_t i = 0; i < text.size();) {
+    size_t length = 0;
+    if (text.substr(i, 2) == "\r\n") {
+      length = 2;
+    } else if (text[i] == '\n' || text[i] == '\r') {
+      length = 1;
+    } else if (unicode) {
+      if (std::string_view("\v\f\x1c\x1d\x1e").find(text[i]) !=
+          std::string_view::npos) {
+        length = 1;
+      } else if (text.substr(i, 2) == "\xc2\x85") {
+        length = 2;
+      } else if (text.substr(i, 3) == "\u2028" ||
+                 text.substr(i, 3) == "\u2029") {
+        length = 3;
+      }
+    }
+
+    if (length == 0) {
+      i++;
+      continue;
+    }
+
+    lines.push_back(text.substr(start, i - start + (keepends ? length : 0)));
+    i += length;
+    start = i;
+  }
+
+  if (start < text.size()) {
+    lines.push_back(text.substr(start));
+  }
+
+  return lines;
+}
+
+}  // namespace
+
+TEST(TestSplitLines, TestSplitLines) {
+  ASSERT_EQ(LineViews(), string::SplitLines(""));
+  ASSERT_EQ(LineViews({""}), string::SplitLines("\n"));
+  ASSERT_EQ(LineViews({"abc"}), string::SplitLines("abc"));
+  ASSERT_EQ(LineViews({"a", "b", "", "c"}),
+            string::SplitLines("a\r\nb\n\nc\n"));
+  ASSERT_EQ(LineViews({"a", "", "b"}), string::SplitLines("a\n\rb"));
+  ASSERT_EQ(LineViews({"a", "b"}), string::SplitLines("a\rb"));
+}
+
+TEST(TestSplitLines, TestSplitLinesKeepEnds) {
+  ASSERT_EQ(LineViews({"a\r\n", "b\n", "\n", "c"}),
+            string::SplitLines("a\r\nb\n\nc", true));
+  ASSERT_EQ(LineViews({"a\r", "\r\n"}), string::SplitLines("a\r\r\n", true));
+}
+
+TEST(TestSplitLines, TestSplitLinesUnicode) {
+  std::string_view text = "a\vb\fc\x1c" "d\u2028e\u2029f\xc2\x85g";
+  ASSERT_EQ(LineViews({text}), string::SplitLines(text));
+  ASSERT_EQ(LineViews({"a", "b", "c", "d", "e", "f", "g"}),
+            string::SplitLines(text, false, true));
+
+  // Other code points which share a lead byte aren't line breaks.
+  ASSERT_EQ(LineViews({"é\u2027\xe2\x80"}),
+            string::SplitLines("é\u2027\xe2\x80", false, true));
+}
+
+TEST(TestSplitLines, TestSplitLinesReturnsViews) {
+  std::string text = "first\nsecond";
+  auto lines = string::SplitLines(text);
+  ASSERT_EQ(2, lines.size());
+  ASSERT_EQ(text.data(), lines[0].data());
+  ASSERT_EQ(text.data() + 6, lines[1].data());
+}
+
+TEST(TestSplitLines, TestCrLfAcrossBlockBoundary) {
+  // Put the "\r" at the end of a 16 and 32 byte block, with the "\n" in the
+  // next one.
+  for (size_t pad : {15, 31, 63}) {
+    std::string text = std::string(pad, 'x') + "\r\ny";
+    ASSERT_EQ(LineViews({std::string_view(text).substr(0, pad), "y"}),
+              string::SplitLines(text));
+  }
+}
+
+TEST(TestSplitLines, TestAgainstReference) {
+  const std::vector<std::string> pieces = {
+      "a", "\n", "\r", "\r\n", "\v", "\x1d", "\xc2\x85", "\u2028", "\u2029",
+      "\xc2", "\xe2\x80", "é", std::string(40, 'z')};
+
+  srand(1);
+  for (int i = 0; i < 20000; i++) {
+    std::string text;
+    int n = rand() % 30;
+    for (int j = 0; j < n; j++) {
+      text += pieces[rand() % pieces.size()];
+    }
+
+    for (bool keepends : {false, true}) {
+      for (bool unicode : {false, true}) {
+        ASSERT_EQ(SplitLinesReference(text, keepends, unicode),
+                  string::SplitLines(text, keepends, unicode))
+            << text;
+      }
+    }
+  }
+}
+
+TEST(TestLines, TestLinesIsLazy) {
+  std::string text = "a\nb\r\nc";
+  string::Lines lines(text);
+  auto it = lines.begin();
+  ASSERT_EQ("a", *it);
+  ASSERT_EQ(1, it->size());
+  ASSERT_EQ("b", *++it);
+  ASSERT_EQ("b", *it++);
+  ASSERT_EQ("c", *it);
+  ASSERT_TRUE(++it == lines.end());
+}
+
+TEST(TestLines, TestLinesMatchesSplitLines) {
+  std::string text = "one\r\ntwo\n\nthree\u2028four\r";
+  for (bool keepends : {false, true}) {
+    for (bool unicode : {false, true}) {
+      LineViews lines;
+      for (std::string_view line : string::Lines(text, keepends, unicode)) {
+        lines.push_back(line);
+      }
+
+      ASSERT_EQ(string::SplitLines(text, keepends, unicode), lines);
+    }
+  }
+}
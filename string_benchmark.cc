@@ -0,0 +1,355 @@
+// Benchmarks for the public string functions, each next to a baseline written
+// with the standard library (or snprintf) which does the same job.
+//
+// To compare two builds, save the results of each as JSON and diff them with
+// google-benchmark's tools/compare.py:
+//
+//     string_benchmark --benchmark_out=before.json --benchmark_out_format=json
+//     compare.py benchmarks before.json after.json
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "format.h"
+#include "split.h"
+#include "util.h"
+
+namespace {
+
+const char* const kLevels[] = {"INFO", "WARN", "DEBUG", "ERROR"};
+const char* const kPaths[] = {"/api/v1/users", "/api/v1/orders/checkout",
+                              "/static/app.js", "/healthz"};
+
+// Build about `size` bytes of log lines, like:
+//
+//   2026-10-19T12:00:07Z INFO [worker-3] GET /healthz status=200 latency_ms=7
+std::string MakeLogs(size_t size) {
+  std::string logs;
+  char line[256];
+  for (unsigned i = 0; logs.size() < size; i++) {
+    snprintf(line, sizeof(line),
+             "2026-10-19T12:%02u:%02uZ %s [worker-%u] GET %s status=%u "
+             "latency_ms=%u\n",
+             i / 60 % 60, i % 60, kLevels[i * 7 % 4], i % 16,
+             kPaths[i * 13 % 4], i % 11 == 0 ? 500 : 200, i * 37 % 250);
+    logs += line;
+  }
+
+  logs.resize(size);
+  return logs;
+}
+
+// Build `size` bytes of CSV, where about one byte in `density` is a comma.
+std::string MakeCsv(size_t size, size_t density) {
+  std::string csv;
+  for (size_t i = 0; csv.size() < size; i++) {
+    std::string field(density - 1, 'a' + i % 26);
+    csv += field;
+    csv += (i % 8 == 7) ? '\n' : ',';
+  }
+
+  csv.resize(size);
+  return csv;
+}
+
+// Build an HTML template with `n_tags` distinct {tag_i} tags, and the map to
+// fill it with.
+std::string MakeTemplate(int n_tags, string::FormatMapType* args) {
+  std::string html = "<html><body>\n";
+  for (int i = 0; i < n_tags; i++) {
+    std::string tag = "tag_" + std::to_string(i);
+    html += "  <div class=\"row\"><span>" + tag + "</span>{" + tag +
+            "}</div>\n";
+    (*args)[tag] = "value " + std::to_string(i);
+  }
+
+  return html + "</body></html>\n";
+}
+
+void SetBytes(benchmark::State& state, size_t bytes) {
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+
+// Split/Join: parameterized by input size and by the spacing between commas.
+
+void BM_Split(benchmark::State& state) {
+  std::string csv = MakeCsv(state.range(0), state.range(1));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(string::Split(csv, ",\n"));
+  }
+
+  SetBytes(state, csv.size());
+}
+BENCHMARK(BM_Split)->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {2, 8, 64}});
+
+void BM_SplitCompileTime(benchmark::State& state) {
+  std::string csv = MakeCsv(state.range(0), state.range(1));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(string::Split<',', '\n'>(csv));
+  }
+
+  SetBytes(state, csv.size());
+}
+BENCHMARK(BM_SplitCompileTime)
+    ->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {2, 8, 64}});
+
+void BM_SplitBaseline(benchmark::State& state) {
+  std::string csv = MakeCsv(state.range(0), state.range(1));
+  for (auto _ : state) {
+    std::vector<std::string> pieces;
+    size_t start = 0, sep = csv.find_first_of(",\n");
+    while (sep != std::string::npos) {
+      pieces.push_back(csv.substr(start, sep - start));
+      start = sep + 1;
+      sep = csv.find_first_of(",\n", start);
+    }
+
+    pieces.push_back(csv.substr(start));
+    benchmark::DoNotOptimize(pieces);
+  }
+
+  SetBytes(state, csv.size());
+}
+BENCHMARK(BM_SplitBaseline)
+    ->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {2, 8, 64}});
+
+void BM_Join(benchmark::State& state) {
+  auto pieces = string::Split(MakeCsv(state.range(0), state.range(1)), ",");
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(string::Join(pieces, ", "));
+  }
+
+  SetBytes(state, state.range(0));
+}
+BENCHMARK(BM_Join)->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {2, 64}});
+
+void BM_JoinBaseline(benchmark::State& state) {
+  auto pieces = string::Split(MakeCsv(state.range(0), state.range(1)), ",");
+  for (auto _ : state) {
+    std::ostringstream stream;
+    for (size_t i = 0; i < pieces.size(); i++) {
+      if (i > 0) {
+        stream << ", ";
+      }
+
+      stream << pieces[i];
+    }
+
+    benchmark::DoNotOptimize(stream.str());
+  }
+
+  SetBytes(state, state.range(0));
+}
+BENCHMARK(BM_JoinBaseline)->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {2, 64}});
+
+// Replace/Count/In: parameterized by input size and needle length. The needle
+// is the tail of a common log field, so there are near misses as well as
+// matches.
+
+std::string MakeNeedle(size_t length) {
+  std::string needle = "status=500 latency_ms=";
+  return needle.substr(needle.size() - std::min(length, needle.size()));
+}
+
+void BM_Replace(benchmark::State& state) {
+  std::string logs = MakeLogs(state.range(0));
+  std::string needle = MakeNeedle(state.range(1));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(string::Replace(logs, needle, "<redacted>"));
+  }
+
+  SetBytes(state, logs.size());
+}
+BENCHMARK(BM_Replace)->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {1, 4, 22}});
+
+void BM_ReplaceBaseline(benchmark::State& state) {
+  std::string logs = MakeLogs(state.range(0));
+  std::string needle = MakeNeedle(state.range(1));
+  for (auto _ : state) {
+    std::string result = logs;
+    size_t pos = result.find(needle);
+    while (pos != std::string::npos) {
+      result.replace(pos, needle.size(), "<redacted>");
+      pos = result.find(needle, pos + 10);
+    }
+
+    benchmark::DoNotOptimize(result);
+  }
+
+  SetBytes(state, logs.size());
+}
+BENCHMARK(BM_ReplaceBaseline)
+    ->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {1, 4, 22}});
+
+void BM_Count(benchmark::State& state) {
+  std::string logs = MakeLogs(state.range(0));
+  std::string needle = MakeNeedle(state.range(1));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(string::Count(logs, needle));
+  }
+
+  SetBytes(state, logs.size());
+}
+BENCHMARK(BM_Count)->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {1, 4, 22}});
+
+void BM_CountBaseline(benchmark::State& state) {
+  std::string logs = MakeLogs(state.range(0));
+  std::string needle = MakeNeedle(state.range(1));
+  for (auto _ : state) {
+    int count = 0;
+    for (size_t pos = logs.find(needle); pos != std::string::npos;
+         pos = logs.find(needle, pos + needle.size())) {
+      count++;
+    }
+
+    benchmark::DoNotOptimize(count);
+  }
+
+  SetBytes(state, logs.size());
+}
+BENCHMARK(BM_CountBaseline)
+    ->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {1, 4, 22}});
+
+void BM_In(benchmark::State& state) {
+  // A needle which never occurs, so the whole input is scanned.
+  std::string logs = MakeLogs(state.range(0));
+  std::string needle = MakeNeedle(state.range(1)) + "~";
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(string::In(logs, needle));
+  }
+
+  SetBytes(state, logs.size());
+}
+BENCHMARK(BM_In)->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {1, 4, 22}});
+
+void BM_InBaseline(benchmark::State& state) {
+  std::string logs = MakeLogs(state.range(0));
+  std::string needle = MakeNeedle(state.range(1)) + "~";
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(logs.find(needle) != std::string::npos);
+  }
+
+  SetBytes(state, logs.size());
+}
+BENCHMARK(BM_InBaseline)
+    ->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {1, 4, 22}});
+
+// Trim/ToLower: parameterized by input size.
+
+void BM_Trim(benchmark::State& state) {
+  std::string padded = std::string(16, ' ') + MakeLogs(state.range(0)) +
+                       std::string(16, '\n');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(string::Trim(padded, string::kWhitespace));
+  }
+
+  SetBytes(state, padded.size());
+}
+BENCHMARK(BM_Trim)->Range(1 << 6, 1 << 20);
+
+void BM_TrimBaseline(benchmark::State& state) {
+  std::string padded = std::string(16, ' ') + MakeLogs(state.range(0)) +
+                       std::string(16, '\n');
+  for (auto _ : state) {
+    size_t start = padded.find_first_not_of(string::kWhitespace);
+    size_t end = padded.find_last_not_of(string::kWhitespace);
+    benchmark::DoNotOptimize(start == std::string::npos
+                                 ? std::string()
+                                 : padded.substr(start, end - start + 1));
+  }
+
+  SetBytes(state, padded.size());
+}
+BENCHMARK(BM_TrimBaseline)->Range(1 << 6, 1 << 20);
+
+void BM_ToLower(benchmark::State& state) {
+  std::string logs = MakeLogs(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(string::ToLower(logs));
+  }
+
+  SetBytes(state, logs.size());
+}
+BENCHMARK(BM_ToLower)->Range(1 << 6, 1 << 20);
+
+void BM_ToLowerBaseline(benchmark::State& state) {
+  std::string logs = MakeLogs(state.range(0));
+  for (auto _ : state) {
+    std::string result = logs;
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    benchmark::DoNotOptimize(result);
+  }
+
+  SetBytes(state, logs.size());
+}
+BENCHMARK(BM_ToLowerBaseline)->Range(1 << 6, 1 << 20);
+
+// Format: parameterized by the number of tags.
+
+void BM_FormatMap(benchmark::State& state) {
+  string::FormatMapType args;
+  std::string html = MakeTemplate(state.range(0), &args);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(string::FormatMap(html, args));
+  }
+
+  SetBytes(state, html.size());
+}
+BENCHMARK(BM_FormatMap)->RangeMultiplier(4)->Range(1, 256);
+
+void BM_FormatMapBaseline(benchmark::State& state) {
+  // The same template, with each tag at a known position, as you would write
+  // it by hand with an ostringstream.
+  string::FormatMapType args;
+  std::string html = MakeTemplate(state.range(0), &args);
+  std::vector<std::string> values(state.range(0));
+  for (int i = 0; i < state.range(0); i++) {
+    values[i] = "value " + std::to_string(i);
+  }
+
+  for (auto _ : state) {
+    std::ostringstream stream;
+    stream << "<html><body>\n";
+    for (int i = 0; i < state.range(0); i++) {
+      stream << "  <div class=\"row\"><span>tag_" << i << "</span>"
+             << values[i] << "</div>\n";
+    }
+
+    stream << "</body></html>\n";
+    benchmark::DoNotOptimize(stream.str());
+  }
+
+  SetBytes(state, html.size());
+}
+BENCHMARK(BM_FormatMapBaseline)->RangeMultiplier(4)->Range(1, 256);
+
+void BM_Format(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        string::Format("{} [worker-{:d}] {} status={:d} latency={:.2f}ms",
+                       {"INFO", 3, "/api/v1/users", 200, 12.5}));
+  }
+}
+BENCHMARK(BM_Format);
+
+void BM_FormatBaseline(benchmark::State& state) {
+  char buffer[256];
+  for (auto _ : state) {
+    snprintf(buffer, sizeof(buffer),
+             "%s [worker-%d] %s status=%d latency=%.2fms", "INFO", 3,
+             "/api/v1/users", 200, 12.5);
+    benchmark::DoNotOptimize(std::string(buffer));
+  }
+}
+BENCHMARK(BM_FormatBaseline);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,49 @@
+// Generated by gen_unicode_tables.py from Unicode 14.0.0; don't edit.
+#pragma once
+
+#include <cstdint>
+
+namespace string {
+
+// Internal; don't use directly.
+namespace internal {
+
+// Code points at or above this have no case mappings.
+constexpr char32_t kCaseMaxCodePoint = 0x20000;
+
+// Each block covers 1 << kCaseBlockShift code points.
+constexpr int kCaseBlockShift = 6;
+
+// Two-stage tables of deltas to add to a code point to get its lower-case or
+// upper-case form. Stage 1 gives the block for a code point, and stage 2 holds
+// the deltas for each block.
+extern const uint8_t kLowerStage1[2048];
+extern const int32_t kLowerStage2[3392];
+extern const uint8_t kUpperStage1[2048];
+extern const int32_t kUpperStage2[3648];
+
+// Look up a code point in a pair of two-stage tables.
+inline char32_t CaseMapCodePoint(const uint8_t* stage1, const int32_t* stage2,
+                                 char32_t cp) {
+  if (cp >= kCaseMaxCodePoint) {
+    return cp;
+  }
+
+  uint32_t block = stage1[cp >> kCaseBlockShift];
+  uint32_t offset = cp & ((1 << kCaseBlockShift) - 1);
+  return cp + stage2[(block << kCaseBlockShift) + offset];
+}
+
+// Get the simple lower-case mapping of a code point.
+inline char32_t ToLowerCodePoint(char32_t cp) {
+  return CaseMapCodePoint(kLowerStage1, kLowerStage2, cp);
+}
+
+// Get the simple upper-case mapping of a code point.
+inline char32_t ToUpperCodePoint(char32_t cp) {
+  return CaseMapCodePoint(kUpperStage1, kUpperStage2, cp);
+}
+
+}  // namespace internal
+
+}  // namespace string
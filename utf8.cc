@@ -0,0 +1,557 @@
+#include "utf8.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include <string.h>
+
+#include "ascii.h"
+#include "simd.h"
+#include "unicode_tables.h"
+
+namespace string {
+
+namespace internal {
+
+size_t DecodeUtf8(const char* data, size_t n, char32_t* cp) {
+  if (n == 0) {
+    return 0;
+  }
+
+  auto b0 = static_cast<unsigned char>(data[0]);
+  if (b0 < 0x80) {
+    *cp = b0;
+    return 1;
+  }
+
+  // Work out the length of the sequence and the smallest code point it can
+  // hold, so that overlong forms can be rejected.
+  size_t length;
+  char32_t min;
+  if (b0 >= 0xc2 && b0 <= 0xdf) {
+    length = 2;
+    min = 0x80;
+    *cp = b0 & 0x1f;
+  } else if (b0 >= 0xe0 && b0 <= 0xef) {
+    length = 3;
+    min = 0x800;
+    *cp = b0 & 0x0f;
+  } else if (b0 >= 0xf0 && b0 <= 0xf4) {
+    length = 4;
+    min = 0x10000;
+    *cp = b0 & 0x07;
+  } else {
+    return 0;
+  }
+
+  if (n < length) {
+    return 0;
+  }
+
+  for (size_t i = 1; i < length; i++) {
+    auto b = static_cast<unsigned char>(data[i]);
+    if ((b & 0xc0) != 0x80) {
+      return 0;
+    }
+
+    *cp = (*cp << 6) | (b & 0x3f);
+  }
+
+  if (*cp < min || *cp > 0x10ffff || (*cp >= 0xd800 && *cp <= 0xdfff)) {
+    return 0;
+  }
+
+  return length;
+}
+
+void AppendUtf8(char32_t cp, std::string& out) {
+  if (cp < 0x80) {
+    out += static_cast<char>(cp);
+  } else if (cp < 0x800) {
+    out += static_cast<char>(0xc0 | (cp >> 6));
+    out += static_cast<char>(0x80 | (cp & 0x3f));
+  } else if (cp < 0x10000) {
+    out += static_cast<char>(0xe0 | (cp >> 12));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+    out += static_cast<char>(0x80 | (cp & 0x3f));
+  } else {
+    out += static_cast<char>(0xf0 | (cp >> 18));
+    out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+    out += static_cast<char>(0x80 | (cp & 0x3f));
+  }
+}
+
+}  // namespace internal
+
+namespace {
+
+// Apply `map` to each code point in `str`. ASCII runs are copied in bulk and
+// converted with the vectorized ASCII functions instead.
+template <typename MapFn, typename AsciiFn>
+std::string _MapCodePoints(std::string_view str, const MapFn& map,
+                           const AsciiFn& ascii) {
+  std::string result;
+  result.reserve(str.size());
+
+  size_t i = 0;
+  while (i < str.size()) {
+    size_t run = internal::AsciiPrefixLength(str.data() + i, str.size() - i);
+    if (run > 0) {
+      size_t start = result.size();
+      result.append(str.data() + i, run);
+      ascii(&result[start], run);
+      i += run;
+      if (i == str.size()) {
+        break;
+      }
+    }
+
+    char32_t cp;
+    size_t length = internal::DecodeUtf8(str.data() + i, str.size() - i, &cp);
+    if (length == 0) {
+      // Not valid UTF-8, so leave the byte alone.
+      result += str[i++];
+      continue;
+    }
+
+    char32_t mapped = map(cp);
+    if (mapped == cp) {
+      result.append(str.data() + i, length);
+    } else {
+      internal::AppendUtf8(mapped, result);
+    }
+
+    i += length;
+  }
+
+  return result;
+}
+
+bool _IsContinuation(char c) {
+  return (static_cast<unsigned char>(c) & 0xc0) == 0x80;
+}
+
+bool _IsValidUtf8Scalar(const char* data, size_t n) {
+  size_t i = 0;
+  while (i < n) {
+    i += internal::AsciiPrefixLength(data + i, n - i);
+    if (i == n) {
+      break;
+    }
+
+    char32_t cp;
+    size_t length = internal::DecodeUtf8(data + i, n - i, &cp);
+    if (length == 0) {
+      return false;
+    }
+
+    i += length;
+  }
+
+  return true;
+}
+
+size_t _CodePointLengthScalar(const char* data, size_t n) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++) {
+    count += !_IsContinuation(data[i]);
+  }
+
+  return count;
+}
+
+// Copy the ASCII bytes at the start of [data, data + n) to `out`, widening
+// them to `Char`. Returns the number of bytes copied.
+template <typename Char>
+size_t _WidenAsciiScalar(const char* data, size_t n, Char* out) {
+  size_t run = internal::AsciiPrefixLength(data, n);
+  for (size_t i = 0; i < run; i++) {
+    out[i] = static_cast<unsigned char>(data[i]);
+  }
+
+  return run;
+}
+
+#ifdef CPPSTRING_HAVE_AVX2_DISPATCH
+
+// The UTF-8 validator below is the lookup algorithm from "Validating UTF-8 In
+// Less Than One Instruction Per Byte" (Keiser and Lemire, 2021). Every error in
+// a pair of adjacent bytes can be found from the high nibble of the first byte,
+// the low nibble of the first byte and the high nibble of the second byte. Each
+// nibble is looked up in a table of the errors it could be part of, and the
+// errors which all three agree on are the ones which actually occurred.
+constexpr uint8_t kTooShort = 1 << 0;   // 11______ 0_______
+                                        // 11______ 11______
+constexpr uint8_t kTooLong = 1 << 1;    // 0_______ 10______
+constexpr uint8_t kOverlong3 = 1 << 2;  // 11100000 100_____
+constexpr uint8_t kTooLarge = 1 << 3;   // 11110100 1001____
+                                        // 11110100 101_____
+                                        // 11110101 1001____
+                                        // 11110101 101_____
+                                        // 1111011_ 1001____
+                                        // 1111011_ 101_____
+                                        // 11111___ 1001____
+                                        // 11111___ 101_____
+constexpr uint8_t kSurrogate = 1 << 4;  // 11101101 101_____
+constexpr uint8_t kOverlong2 = 1 << 5;  // 1100000_ 10______
+constexpr uint8_t kTooLarge1000 = 1 << 6;  // 11110101 1000____
+                                           // 1111011_ 1000____
+                                           // 11111___ 1000____
+constexpr uint8_t kOverlong4 = 1 << 6;  // 11110000 1000____
+constexpr uint8_t kTwoConts = 1 << 7;   // 10______ 10______
+
+// Errors which only depend on the high nibble of the first byte.
+constexpr uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+
+alignas(16) const uint8_t kByte1High[16] = {
+    // 0_______ ________
+    kTooLong, kTooLong, kTooLong, kTooLong,
+    kTooLong, kTooLong, kTooLong, kTooLong,
+    // 10______ ________
+    kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+    // 1100____ ________
+    kTooShort | kOverlong2,
+    // 1101____ ________
+    kTooShort,
+    // 1110____ ________
+    kTooShort | kOverlong3 | kSurrogate,
+    // 1111____ ________
+    kTooShort | kTooLarge | kTooLarge1000 | kOverlong4,
+};
+
+alignas(16) const uint8_t kByte1Low[16] = {
+    // ____0000 ________
+    kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+    // ____0001 ________
+    kCarry | kOverlong2,
+    // ____001_ ________
+    kCarry,
+    kCarry,
+    // ____0100 ________
+    kCarry | kTooLarge,
+    // ____0101 ________
+    kCarry | kTooLarge | kTooLarge1000,
+    // ____011_ ________
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    // ____1___ ________
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    // ____1101 ________
+    kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+};
+
+alignas(16) const uint8_t kByte2High[16] = {
+    // ________ 0_______
+    kTooShort, kTooShort, kTooShort, kTooShort,
+    kTooShort, kTooShort, kTooShort, kTooShort,
+    // ________ 1000____
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 |
+        kOverlong4,
+    // ________ 1001____
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+    // ________ 101_____
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    // ________ 11______
+    kTooShort, kTooShort, kTooShort, kTooShort,
+};
+
+// Look up each nibble of `nibbles` in a 16-byte table.
+CPPSTRING_TARGET_AVX2 __m256i _Lookup(const uint8_t* table, __m256i nibbles) {
+  __m256i t = _mm256_broadcastsi128_si256(
+      _mm_load_si128(reinterpret_cast<const __m128i*>(table)));
+  return _mm256_shuffle_epi8(t, nibbles);
+}
+
+CPPSTRING_TARGET_AVX2 __m256i _HighNibbles(__m256i v) {
+  return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0f));
+}
+
+// Get the 32 bytes which end N bytes before the end of `input`, where `prev`
+// is the block before `input`.
+template <int N>
+CPPSTRING_TARGET_AVX2 __m256i _Prev(__m256i input, __m256i prev) {
+  return _mm256_alignr_epi8(
+      input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - N);
+}
+
+struct _Utf8Checker {
+  __m256i error;
+  __m256i prev_input;
+  __m256i prev_incomplete;
+};
+
+CPPSTRING_TARGET_AVX2 void _CheckBlock(_Utf8Checker* checker, __m256i input) {
+  if (_mm256_movemask_epi8(input) == 0) {
+    // All ASCII, so the only possible error is a sequence cut off at the end
+    // of the last block.
+    checker->error = _mm256_or_si256(checker->error, checker->prev_incomplete);
+    checker->prev_incomplete = _mm256_setzero_si256();
+    checker->prev_input = input;
+    return;
+  }
+
+  __m256i prev1 = _Prev<1>(input, checker->prev_input);
+  __m256i low_nibbles = _mm256_and_si256(prev1, _mm256_set1_epi8(0x0f));
+  __m256i special_cases = _mm256_and_si256(
+      _mm256_and_si256(_Lookup(kByte1High, _HighNibbles(prev1)),
+                       _Lookup(kByte1Low, low_nibbles)),
+      _Lookup(kByte2High, _HighNibbles(input)));
+
+  // The third and fourth bytes of 3 and 4 byte sequences must be continuation
+  // bytes; these are the only places two continuation bytes can be adjacent.
+  // After the saturating subtractions, the top bit is only set for bytes two
+  // after a 3 or 4 byte lead, or three after a 4 byte lead.
+  __m256i third = _mm256_subs_epu8(_Prev<2>(input, checker->prev_input),
+                                   _mm256_set1_epi8(0xe0 - 0x80));
+  __m256i fourth = _mm256_subs_epu8(_Prev<3>(input, checker->prev_input),
+                                    _mm256_set1_epi8(0xf0 - 0x80));
+  __m256i must_be_continuation =
+      _mm256_and_si256(_mm256_or_si256(third, fourth),
+                       _mm256_set1_epi8(static_cast<char>(0x80)));
+  checker->error = _mm256_or_si256(
+      checker->error, _mm256_xor_si256(must_be_continuation, special_cases));
+
+  // Any lead bytes in the last three bytes which need more bytes than are left
+  // must be finished by the next block.
+  const __m256i max_value = _mm256_setr_epi8(
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, static_cast<char>(0xf0 - 1),
+      static_cast<char>(0xe0 - 1), static_cast<char>(0xc0 - 1));
+  checker->prev_incomplete = _mm256_subs_epu8(input, max_value);
+  checker->prev_input = input;
+}
+
+CPPSTRING_TARGET_AVX2 bool _IsValidUtf8Avx2(const char* data, size_t n) {
+  _Utf8Checker checker = {_mm256_setzero_si256(), _mm256_setzero_si256(),
+                          _mm256_setzero_si256()};
+
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    _CheckBlock(&checker, _mm256_loadu_si256(
+                              reinterpret_cast<const __m256i*>(data + i)));
+  }
+
+  if (i < n) {
+    // Pad the last block with ASCII, which will show up any sequence which is
+    // cut off.
+    alignas(32) char last[32] = {0};
+    memcpy(last, data + i, n - i);
+    _CheckBlock(&checker,
+                _mm256_load_si256(reinterpret_cast<const __m256i*>(last)));
+  }
+
+  __m256i error = _mm256_or_si256(checker.error, checker.prev_incomplete);
+  return _mm256_testz_si256(error, error);
+}
+
+CPPSTRING_TARGET_AVX2 size_t _CodePointLengthAvx2(const char* data, size_t n) {
+  size_t count = 0;
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    // Continuation bytes are [0x80, 0xbf], which are [-128, -65] when signed.
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    unsigned mask = _mm256_movemask_epi8(
+        _mm256_cmpgt_epi8(v, _mm256_set1_epi8(-65)));
+    count += __builtin_popcount(mask);
+  }
+
+  return count + _CodePointLengthScalar(data + i, n - i);
+}
+
+CPPSTRING_TARGET_AVX2 size_t _WidenAsciiAvx2(const char* data, size_t n,
+                                             char16_t* out) {
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    if (_mm256_movemask_epi8(v) != 0) {
+      break;
+    }
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 16),
+                        _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1)));
+  }
+
+  return i + _WidenAsciiScalar(data + i, n - i, out + i);
+}
+
+CPPSTRING_TARGET_AVX2 size_t _WidenAsciiAvx2(const char* data, size_t n,
+                                             char32_t* out) {
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    if (_mm256_movemask_epi8(v) != 0) {
+      break;
+    }
+
+    for (size_t j = 0; j < 32; j += 8) {
+      __m128i bytes =
+          _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data + i + j));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + j),
+                          _mm256_cvtepu8_epi32(bytes));
+    }
+  }
+
+  return i + _WidenAsciiScalar(data + i, n - i, out + i);
+}
+
+#endif  // CPPSTRING_HAVE_AVX2_DISPATCH
+
+char16_t* _EmitUtf16(char32_t cp, char16_t* out) {
+  if (cp < 0x10000) {
+    *out++ = static_cast<char16_t>(cp);
+  } else {
+    cp -= 0x10000;
+    *out++ = static_cast<char16_t>(0xd800 + (cp >> 10));
+    *out++ = static_cast<char16_t>(0xdc00 + (cp & 0x3ff));
+  }
+
+  return out;
+}
+
+char32_t* _EmitUtf32(char32_t cp, char32_t* out) {
+  *out++ = cp;
+  return out;
+}
+
+// Decode `str`, writing each code point with `emit`. Runs of ASCII are widened
+// in bulk with `widen` instead.
+template <typename Char>
+std::basic_string<Char> _Transcode(std::string_view str,
+                                   size_t (*widen)(const char*, size_t, Char*),
+                                   Char* (*emit)(char32_t, Char*)) {
+  // No code point takes more units than it has bytes.
+  std::basic_string<Char> result(str.size(), 0);
+  Char* out = &result[0];
+
+  size_t i = 0;
+  while (i < str.size()) {
+    size_t run = widen(str.data() + i, str.size() - i, out);
+    i += run;
+    out += run;
+    if (i == str.size()) {
+      break;
+    }
+
+    char32_t cp;
+    size_t length = internal::DecodeUtf8(str.data() + i, str.size() - i, &cp);
+    if (length == 0) {
+      throw std::invalid_argument("Invalid UTF-8 at byte " +
+                                  std::to_string(i) + ".");
+    }
+
+    out = emit(cp, out);
+    i += length;
+  }
+
+  result.resize(out - result.data());
+  return result;
+}
+
+}  // namespace
+
+std::string Utf8ToLower(std::string_view str) {
+  return _MapCodePoints(str, internal::ToLowerCodePoint,
+                        internal::AsciiToLower);
+}
+
+std::string Utf8ToUpper(std::string_view str) {
+  return _MapCodePoints(str, internal::ToUpperCodePoint,
+                        internal::AsciiToUpper);
+}
+
+std::string Utf8Capitalize(std::string_view str) {
+  std::string result;
+  result.reserve(str.size());
+
+  char32_t cp;
+  size_t length = internal::DecodeUtf8(str.data(), str.size(), &cp);
+  if (length == 0) {
+    return std::string(str);
+  }
+
+  internal::AppendUtf8(internal::ToUpperCodePoint(cp), result);
+  result.append(str.substr(length));
+  return result;
+}
+
+
+bool IsValidUtf8(std::string_view str) {
+#ifdef CPPSTRING_HAVE_AVX2_DISPATCH
+  if (internal::CpuHasAvx2()) {
+    return _IsValidUtf8Avx2(str.data(), str.size());
+  }
+#endif  // CPPSTRING_HAVE_AVX2_DISPATCH
+
+  return _IsValidUtf8Scalar(str.data(), str.size());
+}
+
+size_t CodePointLength(std::string_view str) {
+#ifdef CPPSTRING_HAVE_AVX2_DISPATCH
+  if (internal::CpuHasAvx2()) {
+    return _CodePointLengthAvx2(str.data(), str.size());
+  }
+#endif  // CPPSTRING_HAVE_AVX2_DISPATCH
+
+  return _CodePointLengthScalar(str.data(), str.size());
+}
+
+std::string_view Utf8Truncate(std::string_view str, size_t max_bytes) {
+  if (str.size() <= max_bytes) {
+    return str;
+  }
+
+  // Back up to the start of the code point which would be cut.
+  size_t n = max_bytes;
+  while (n > 0 && _IsContinuation(str[n])) {
+    n--;
+  }
+
+  return str.substr(0, n);
+}
+
+std::string_view Utf8TruncateCodePoints(std::string_view str,
+                                        size_t max_code_points) {
+  size_t count = 0;
+  for (size_t i = 0; i < str.size(); i++) {
+    if (!_IsContinuation(str[i]) && count++ == max_code_points) {
+      return str.substr(0, i);
+    }
+  }
+
+  return str;
+}
+
+std::u16string Utf8ToUtf16(std::string_view str) {
+  size_t (*widen)(const char*, size_t, char16_t*) = _WidenAsciiScalar;
+#ifdef CPPSTRING_HAVE_AVX2_DISPATCH
+  if (internal::CpuHasAvx2()) {
+    widen = _WidenAsciiAvx2;
+  }
+#endif  // CPPSTRING_HAVE_AVX2_DISPATCH
+
+  return _Transcode(str, widen, _EmitUtf16);
+}
+
+std::u32string Utf8ToUtf32(std::string_view str) {
+  size_t (*widen)(const char*, size_t, char32_t*) = _WidenAsciiScalar;
+#ifdef CPPSTRING_HAVE_AVX2_DISPATCH
+  if (internal::CpuHasAvx2()) {
+    widen = _WidenAsciiAvx2;
+  }
+#endif  // CPPSTRING_HAVE_AVX2_DISPATCH
+
+  return _Transcode(str, widen, _EmitUtf32);
+}
+
+}  // namespace string
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace string {
+
+// Internal; don't use directly.
+namespace internal {
+
+// Decode the UTF-8 sequence at the start of [data, data + n) into `cp`.
+// Returns the length of the sequence, or 0 if it is not valid UTF-8 (including
+// overlong forms, surrogates and code points above U+10FFFF).
+size_t DecodeUtf8(const char* data, size_t n, char32_t* cp);
+
+// Append the UTF-8 encoding of `cp` to `out`.
+void AppendUtf8(char32_t cp, std::string& out);
+
+}  // namespace internal
+
+/**
+ * @brief      Convert the given UTF-8 string to lowercase.
+ *
+ * @details    Unlike ToLower, this converts every character with a simple
+ *             (one-to-one) lowercase mapping in the Unicode database, not just
+ *             ASCII letters. For example:
+ *
+ *                 Utf8ToLower("ÀÉÎ ΣΑΣ") -> "àéî σασ"
+ *
+ *             Mappings which need context or expand to several characters
+ *             (e.g. final sigma) aren't applied. Some characters have a
+ *             mapping whose encoding is a different length, so the result may
+ *             not be the same length as `str`. Bytes which aren't valid UTF-8
+ *             are copied as they are.
+ *
+ *             Runs of ASCII are detected 32 bytes at a time and converted
+ *             without being decoded, so mostly-ASCII strings cost about as
+ *             much as they would with ToLower.
+ *
+ * @param[in]  str   The string to convert.
+ *
+ * @return     A version of the string with all letters in their lowercase form.
+ * @see        ToLower
+ * @see        Utf8ToUpper
+ */
+std::string Utf8ToLower(std::string_view str);
+
+/**
+ * @brief      Convert the given UTF-8 string to uppercase.
+ *
+ * @details    The same as Utf8ToLower, but uses each character's simple
+ *             uppercase mapping. For example:
+ *
+ *                 Utf8ToUpper("straße") -> "STRAßE"
+ *
+ * @param[in]  str   The string to convert.
+ *
+ * @return     A version of the string with all letters in their uppercase form.
+ * @see        ToUpper
+ * @see        Utf8ToLower
+ */
+std::string Utf8ToUpper(std::string_view str);
+
+/**
+ * @brief      Capitalize the given UTF-8 string.
+ *
+ * @details    Converts the first character of `str` to uppercase, and leaves
+ *             the rest as they are. For example:
+ *
+ *                 Utf8Capitalize("éclair") -> "Éclair"
+ *
+ * @param[in]  str   The string to capitalize.
+ *
+ * @return     A version of the string with the first letter capitalized.
+ * @see        Capitalize
+ */
+std::string Utf8Capitalize(std::string_view str);
+
+/**
+ * @brief      Check whether the given string is valid UTF-8.
+ *
+ * @details    Overlong encodings, surrogates, code points above U+10FFFF and
+ *             truncated sequences are all invalid. If the CPU supports AVX2,
+ *             32 bytes are checked at a time using lookup tables on the high
+ *             and low nibbles of each pair of adjacent bytes; otherwise, runs
+ *             of ASCII are skipped and everything else is decoded.
+ *
+ * @param[in]  str   The string to check.
+ *
+ * @return     `true` iff `str` is valid UTF-8.
+ */
+bool IsValidUtf8(std::string_view str);
+
+/**
+ * @brief      Count the number of code points in the given UTF-8 string.
+ *
+ * @details    `str` is assumed to be valid UTF-8; every byte which isn't a
+ *             continuation byte is counted. For example:
+ *
+ *                 CodePointLength("naïve") -> 5
+ *
+ * @param[in]  str   The string to count.
+ *
+ * @return     The number of code points in `str`.
+ */
+size_t CodePointLength(std::string_view str);
+
+/**
+ * @brief      Truncate the given UTF-8 string to at most `max_bytes` bytes,
+ *             without cutting a code point in half.
+ *
+ * @details    For example:
+ *
+ *                 Utf8Truncate("naïve", 3) -> "na"
+ *
+ * @param[in]  str        The string to truncate.
+ * @param[in]  max_bytes  The maximum length of the result, in bytes.
+ *
+ * @return     The longest prefix of `str` which is at most `max_bytes` long
+ *             and ends on a code point boundary.
+ */
+std::string_view Utf8Truncate(std::string_view str, size_t max_bytes);
+
+/**
+ * @brief      Truncate the given UTF-8 string to at most `max_code_points` code
+ *             points.
+ *
+ * @details    For example:
+ *
+ *                 Utf8TruncateCodePoints("naïve", 3) -> "naï"
+ *
+ * @param[in]  str              The string to truncate.
+ * @param[in]  max_code_points  The maximum length of the result, in code
+ *                              points.
+ *
+ * @return     The prefix of `str` with the first `max_code_points` code points.
+ * @see        CodePointLength
+ */
+std::string_view Utf8TruncateCodePoints(std::string_view str,
+                                        size_t max_code_points);
+
+/**
+ * @brief      Convert the given UTF-8 string to UTF-16.
+ *
+ * @details    Code points above U+FFFF are encoded as surrogate pairs. Blocks
+ *             of ASCII are widened without being decoded, using AVX2 if the CPU
+ *             supports it.
+ *
+ * @param[in]  str   The string to convert.
+ *
+ * @return     `str`, encoded as UTF-16.
+ *
+ * @throws     std::invalid_argument Thrown if `str` isn't valid UTF-8.
+ * @see        IsValidUtf8
+ */
+std::u16string Utf8ToUtf16(std::string_view str);
+
+/**
+ * @brief      Convert the given UTF-8 string to UTF-32.
+ *
+ * @details    The same as Utf8ToUtf16, but produces one element per code
+ *             point.
+ *
+ * @param[in]  str   The string to convert.
+ *
+ * @return     `str`, encoded as UTF-32.
+ *
+ * @throws     std::invalid_argument Thrown if `str` isn't valid UTF-8.
+ * @see        IsValidUtf8
+ */
+std::u32string Utf8ToUtf32(std::string_view str);
+
+}  // namespace string
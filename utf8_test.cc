@@ -0,0 +1,237 @@
+#include "utf8.h"
+
+#include <gtest/gtest.h>
+
+#include "util.h"
+
+TEST(TestUtf8CaseMapping, TestAscii) {
+  ASSERT_EQ("hello, world!", string::Utf8ToLower("Hello, World!"));
+  ASSERT_EQ("HELLO, WORLD!", string::Utf8ToUpper("Hello, World!"));
+  ASSERT_EQ("Hello", string::Utf8Capitalize("hello"));
+  ASSERT_EQ("", string::Utf8ToLower(""));
+  ASSERT_EQ("", string::Utf8Capitalize(""));
+}
+
+TEST(TestUtf8CaseMapping, TestLatin1) {
+  ASSERT_EQ("àéîõü", string::Utf8ToLower("ÀÉÎÕÜ"));
+  ASSERT_EQ("ÀÉÎÕÜ", string::Utf8ToUpper("àéîõü"));
+  ASSERT_EQ("Éclair", string::Utf8Capitalize("éclair"));
+}
+
+TEST(TestUtf8CaseMapping, TestGreekAndCyrillic) {
+  ASSERT_EQ("αβγ δ", string::Utf8ToLower("ΑΒΓ Δ"));
+  ASSERT_EQ("ΑΒΓ Δ", string::Utf8ToUpper("αβγ δ"));
+  ASSERT_EQ("привет", string::Utf8ToLower("ПРИВЕТ"));
+  ASSERT_EQ("ПРИВЕТ", string::Utf8ToUpper("привет"));
+}
+
+TEST(TestUtf8CaseMapping, TestMappingsWhichChangeLength) {
+  // U+0131 (2 bytes) -> 'I' (1 byte), and U+017F (2 bytes) -> 'S' (1 byte).
+  ASSERT_EQ("IS", string::Utf8ToUpper("ıſ"));
+
+  // U+023A (2 bytes) -> U+2C65 (3 bytes).
+  ASSERT_EQ("ⱥ", string::Utf8ToLower("Ⱥ"));
+}
+
+TEST(TestUtf8CaseMapping, TestOnlySimpleMappings) {
+  // ß uppercases to "SS", which isn't a one-to-one mapping.
+  ASSERT_EQ("STRAßE", string::Utf8ToUpper("straße"));
+}
+
+TEST(TestUtf8CaseMapping, TestSimpleMappingsOfSpecialCases) {
+  // These have multi-character full mappings, but one-to-one simple ones.
+  // U+0130 -> 'i', not "i" followed by U+0307.
+  ASSERT_EQ("i", string::Utf8ToLower("İ"));
+
+  // U+1F80 -> U+1F88, not U+1F08 followed by U+0399.
+  ASSERT_EQ("ᾈ", string::Utf8ToUpper("ᾀ"));
+  ASSERT_EQ("ᾼῌῼ", string::Utf8ToUpper("ᾳῃῳ"));
+}
+
+TEST(TestUtf8CaseMapping, TestCharactersWithoutCase) {
+  ASSERT_EQ("日本語 123", string::Utf8ToLower("日本語 123"));
+  ASSERT_EQ("日本語 123", string::Utf8ToUpper("日本語 123"));
+  ASSERT_EQ("日本", string::Utf8Capitalize("日本"));
+}
+
+TEST(TestUtf8CaseMapping, TestSupplementaryPlane) {
+  // Deseret.
+  ASSERT_EQ("\U00010428", string::Utf8ToLower("\U00010400"));
+  ASSERT_EQ("\U00010400", string::Utf8ToUpper("\U00010428"));
+}
+
+TEST(TestUtf8CaseMapping, TestInvalidBytesAreKept) {
+  std::string invalid = "A\xff" "B\xc3" "C\xe0\x80\x80" "D\xed\xa0\x80";
+  ASSERT_EQ("a\xff" "b\xc3" "c\xe0\x80\x80" "d\xed\xa0\x80",
+            string::Utf8ToLower(invalid));
+  ASSERT_EQ("\xff" "abc", string::Utf8Capitalize("\xff" "abc"));
+
+  // A truncated sequence at the end.
+  ASSERT_EQ("é\xc3", string::Utf8ToLower("É\xc3"));
+}
+
+TEST(TestUtf8CaseMapping, TestLongMixedStrings) {
+  std::string ascii(100, 'A');
+  std::string upper, lower;
+  for (int i = 0; i < 10; i++) {
+    upper += ascii + "ÉΣЖ";
+    lower += string::ToLower(ascii) + "éσж";
+  }
+
+  ASSERT_EQ(lower, string::Utf8ToLower(upper));
+  ASSERT_EQ(upper, string::Utf8ToUpper(lower));
+}
+
+TEST(TestUtf8CaseMapping, TestMatchesAsciiFunctionsOnAscii) {
+  std::string all;
+  for (int c = 0; c < 128; c++) {
+    all += static_cast<char>(c);
+  }
+
+  for (int i = 0; i < 5; i++) {
+    all += all;
+  }
+
+  ASSERT_EQ(string::ToLower(all), string::Utf8ToLower(all));
+  ASSERT_EQ(string::ToUpper(all), string::Utf8ToUpper(all));
+}
+
+namespace {
+
+// A simple reference validator, which decodes one code point at a time.
+bool IsValidUtf8Reference(const std::string& str) {
+  size_t i = 0;
+  while (i < str.size()) {
+    char32_t cp;
+    size_t length = string::internal::DecodeUtf8(&str[i], str.size() - i, &cp);
+    if (length == 0) {
+      return false;
+    }
+
+    i += length;
+  }
+
+  return true;
+}
+
+}  // namespace
+
+TEST(TestUtf8Validation, TestValidStrings) {
+  ASSERT_TRUE(string::IsValidUtf8(""));
+  ASSERT_TRUE(string::IsValidUtf8("hello"));
+  ASSERT_TRUE(string::IsValidUtf8("naïve café"));
+  ASSERT_TRUE(string::IsValidUtf8("日本語 \U0001F600 \U0010FFFF"));
+}
+
+TEST(TestUtf8Validation, TestInvalidStrings) {
+  ASSERT_FALSE(string::IsValidUtf8("\x80"));
+  ASSERT_FALSE(string::IsValidUtf8("abc\xc3"));
+  ASSERT_FALSE(string::IsValidUtf8("\xc0\xaf"));
+  ASSERT_FALSE(string::IsValidUtf8("\xe0\x80\xaf"));
+  ASSERT_FALSE(string::IsValidUtf8("\xed\xa0\x80"));
+  ASSERT_FALSE(string::IsValidUtf8("\xf4\x90\x80\x80"));
+  ASSERT_FALSE(string::IsValidUtf8("\xf8\x88\x80\x80\x80"));
+  ASSERT_FALSE(string::IsValidUtf8("\xc3\xa9\xa9"));
+}
+
+TEST(TestUtf8Validation, TestAllShortSequences) {
+  // Every 1 and 2 byte string, and every 3 byte string starting with a lead
+  // byte, surrounded by enough ASCII to land on each side of a block boundary.
+  for (int a = 0; a < 256; a++) {
+    for (int b = 0; b < 256; b++) {
+      for (int c = (a >= 0xe0 ? 0 : 255); c < 256; c++) {
+        std::string seq = {static_cast<char>(a), static_cast<char>(b)};
+        if (a >= 0xe0) {
+          seq += static_cast<char>(c);
+        }
+
+        for (size_t pad : {0, 30, 62}) {
+          std::string str = std::string(pad, 'x') + seq;
+          ASSERT_EQ(IsValidUtf8Reference(str), string::IsValidUtf8(str))
+              << a << " " << b << " " << c << " " << pad;
+        }
+      }
+    }
+  }
+}
+
+TEST(TestUtf8Validation, TestAgainstReference) {
+  const std::vector<std::string> pieces = {
+      "a", "bc", "é", "日", "\U0001F600", "\x80", "\xc3", "\xe6\x97",
+      "\xf0\x9f\x98", "\xed\xa0\x80", "\xc0\x80", std::string(40, 'z')};
+
+  srand(1);
+  for (int i = 0; i < 20000; i++) {
+    std::string str;
+    int n = rand() % 40;
+    for (int j = 0; j < n; j++) {
+      // Mostly valid pieces, so that long valid strings are common.
+      size_t k = rand() % pieces.size();
+      if (k >= 5 && k <= 10 && rand() % 4 != 0) {
+        k = rand() % 5;
+      }
+
+      str += pieces[k];
+    }
+
+    ASSERT_EQ(IsValidUtf8Reference(str), string::IsValidUtf8(str)) << str;
+  }
+}
+
+TEST(TestUtf8Length, TestCodePointLength) {
+  ASSERT_EQ(0, string::CodePointLength(""));
+  ASSERT_EQ(5, string::CodePointLength("naïve"));
+  ASSERT_EQ(3, string::CodePointLength("日本語"));
+  ASSERT_EQ(1, string::CodePointLength("\U0001F600"));
+
+  std::string str;
+  for (int i = 0; i < 50; i++) {
+    str += "aé日\U0001F600";
+  }
+
+  ASSERT_EQ(200, string::CodePointLength(str));
+}
+
+TEST(TestUtf8Truncate, TestTruncateBytes) {
+  ASSERT_EQ("na", string::Utf8Truncate("naïve", 3));
+  ASSERT_EQ("naï", string::Utf8Truncate("naïve", 4));
+  ASSERT_EQ("naïve", string::Utf8Truncate("naïve", 100));
+  ASSERT_EQ("", string::Utf8Truncate("日本", 2));
+  ASSERT_EQ("日", string::Utf8Truncate("日本", 5));
+  ASSERT_EQ("", string::Utf8Truncate("abc", 0));
+}
+
+TEST(TestUtf8Truncate, TestTruncateCodePoints) {
+  ASSERT_EQ("naï", string::Utf8TruncateCodePoints("naïve", 3));
+  ASSERT_EQ("naïve", string::Utf8TruncateCodePoints("naïve", 5));
+  ASSERT_EQ("naïve", string::Utf8TruncateCodePoints("naïve", 100));
+  ASSERT_EQ("", string::Utf8TruncateCodePoints("naïve", 0));
+  ASSERT_EQ("日\U0001F600",
+            string::Utf8TruncateCodePoints("日\U0001F600本", 2));
+}
+
+TEST(TestUtf8Transcode, TestUtf16) {
+  ASSERT_EQ(u"", string::Utf8ToUtf16(""));
+  ASSERT_EQ(u"naïve 日本", string::Utf8ToUtf16("naïve 日本"));
+  ASSERT_EQ(u"\U0001F600!", string::Utf8ToUtf16("\U0001F600!"));
+
+  std::string ascii(100, 'q');
+  ASSERT_EQ(std::u16string(100, u'q') + u"é" + std::u16string(100, u'q'),
+            string::Utf8ToUtf16(ascii + "é" + ascii));
+}
+
+TEST(TestUtf8Transcode, TestUtf32) {
+  ASSERT_EQ(U"", string::Utf8ToUtf32(""));
+  ASSERT_EQ(U"naïve 日本", string::Utf8ToUtf32("naïve 日本"));
+  ASSERT_EQ(U"\U0001F600!", string::Utf8ToUtf32("\U0001F600!"));
+
+  std::string ascii(100, 'q');
+  ASSERT_EQ(std::u32string(100, U'q') + U"\U0001F600" +
+                std::u32string(100, U'q'),
+            string::Utf8ToUtf32(ascii + "\U0001F600" + ascii));
+}
+
+TEST(TestUtf8Transcode, TestInvalidThrows) {
+  ASSERT_THROW(string::Utf8ToUtf16("abc\xff"), std::invalid_argument);
+  ASSERT_THROW(string::Utf8ToUtf32("\xed\xa0\x80"), std::invalid_argument);
+}
@@ -1,111 +1,452 @@
 #include "util.h"
 
 #include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include <string.h>
+
+#include "ascii.h"
+#include "metrics.h"
 
 namespace string {
 
-int Count(const std::string& str, const std::string& sub) {
-  if (str.length() == 0 || sub.length() == 0) {
+namespace {
+
+// Find the positions of up to `count` non-overlapping matches of `old` in
+// `str`, and add them to `matches`. Set `count` to -1 for unlimited.
+template <typename Vector>
+void _FindMatches(std::string_view str, const Searcher& old, int count,
+                  Vector& matches) {
+  size_t start = old.Find(str);
+  while (start != std::string::npos) {
+    // Make sure we aren't over our limit.
+    if (count >= 0 && matches.size() >= static_cast<size_t>(count)) {
+      break;
+    }
+
+    matches.push_back(start);
+
+    // An empty needle matches between every character, so step over one
+    // character to avoid matching at the same position forever.
+    start = old.Find(str, start + std::max<size_t>(old.size(), 1));
+  }
+}
+
+// Append `str` to `result`, with the `old_size` characters at each position in
+// `matches` replaced by `replacement`. `result` is only allocated once.
+template <typename Vector, typename String>
+void _ReplaceMatches(std::string_view str, const Vector& matches,
+                     size_t old_size, std::string_view replacement,
+                     String& result) {
+  result.reserve(result.size() + str.size() +
+                 matches.size() * replacement.size() -
+                 matches.size() * old_size);
+
+  size_t last_end = 0;
+  for (size_t start : matches) {
+    result.append(str.data() + last_end, start - last_end);
+    result.append(replacement.data(), replacement.size());
+    last_end = start + old_size;
+  }
+
+  result.append(str.data() + last_end, str.size() - last_end);
+}
+
+int _Count(std::string_view str, const Searcher& sub) {
+  if (str.length() == 0 || sub.empty()) {
     return 0;
   }
 
-  // Keep std::find'ing sub in str until we reach the end of the string.
+  // Keep searching for sub in str until we reach the end of the string.
   int count = 0;
-  auto pos = str.find(sub);
+  auto pos = sub.Find(str);
   while (pos != std::string::npos) {
     count++;
-    pos = str.find(sub, pos + sub.length() + 1);
+    pos = sub.Find(str, pos + sub.size());
   }
 
   return count;
 }
 
-bool In(const std::string& str, const std::string& needle) {
+bool _In(std::string_view str, const Searcher& needle) {
+  return !needle.empty() && needle.Find(str) != std::string::npos;
+}
+
+std::string _Replace(std::string_view str, const Searcher& old,
+                     std::string_view replacement, int count) {
+  // If the string won't grow, then it is cheapest to copy it once and do the
+  // replacement in place.
+  if (!old.empty() && replacement.size() <= old.size()) {
+    std::string result(str);
+    internal::ReplaceInPlace(result, old, replacement, count);
+    return result;
+  }
+
+  // Otherwise, find all of the matches up front so we know exactly how big
+  // the result will be, and only allocate once.
+  std::vector<size_t> matches;
+  _FindMatches(str, old, count, matches);
+  std::string result;
+  _ReplaceMatches(str, matches, old.size(), replacement, result);
+  return result;
+}
+
+}  // namespace
+
+int Count(std::string_view str, std::string_view sub) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kCount, str.size());
+  if (str.length() == 0 || sub.length() == 0) {
+    return 0;
+  }
+
+  return _Count(str, Searcher::Borrow(sub));
+}
+
+int Count(std::string_view str, const Searcher& sub) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kCount, str.size());
+  return _Count(str, sub);
+}
+
+bool In(std::string_view str, std::string_view needle) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kIn, str.size());
   if (needle.length() == 0) {
     return false;
   }
 
-  return str.find(needle) != std::string::npos;
+  return _In(str, Searcher::Borrow(needle));
 }
 
-bool EndsWith(const std::string& str, const std::string& suffix) {
+bool In(std::string_view str, const Searcher& needle) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kIn, str.size());
+  return _In(str, needle);
+}
+
+bool InAny(std::string_view str, const MultiSearcher& needles) {
+  return needles.MatchesAny(str);
+}
+
+std::vector<int> CountAll(std::string_view str,
+                          const MultiSearcher& needles) {
+  std::vector<int> counts(needles.size(), 0);
+  needles.ForEachMatch(str, [&counts](const MultiSearcher::Match& match) {
+    counts[match.pattern]++;
+    return true;
+  });
+
+  return counts;
+}
+
+bool EndsWith(std::string_view str, std::string_view suffix) {
   if (suffix.length() == 0) {
     return false;
   }
 
-  return str.rfind(suffix) == (str.length() - suffix.length());
+  return str.length() >= suffix.length() &&
+         str.compare(str.length() - suffix.length(), suffix.length(),
+                     suffix) == 0;
 }
 
-bool StartsWith(const std::string& str, const std::string& prefix) {
+bool EndsWith(std::string_view str, const Searcher& suffix) {
+  if (suffix.empty() || str.length() < suffix.size()) {
+    return false;
+  }
+
+  return suffix.Equals(str.substr(str.length() - suffix.size()));
+}
+
+bool EndsWithAny(std::string_view str, const SuffixMatcher& suffixes) {
+  return suffixes.Match(str) >= 0;
+}
+
+bool StartsWith(std::string_view str, std::string_view prefix) {
   if (prefix.length() == 0) {
     return false;
   }
 
-  return str.find(prefix) == 0;
+  return str.length() >= prefix.length() &&
+         str.compare(0, prefix.length(), prefix) == 0;
 }
 
-std::string Trim(const std::string& str, const std::string& tokens) {
-  return TrimRight(TrimLeft(str, tokens), tokens);
+bool StartsWith(std::string_view str, const Searcher& prefix) {
+  if (prefix.empty() || str.length() < prefix.size()) {
+    return false;
+  }
+
+  return prefix.Equals(str.substr(0, prefix.size()));
 }
 
-std::string TrimRight(const std::string& str, const std::string& tokens) {
-  auto last_non_token = str.find_last_not_of(tokens);
-  if (last_non_token == std::string::npos) {
-    return "";
+bool StartsWithAny(std::string_view str, const PrefixMatcher& prefixes) {
+  return prefixes.Match(str) >= 0;
+}
+
+int ICount(std::string_view str, std::string_view sub) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kICount, str.size());
+  if (str.length() == 0 || sub.length() == 0) {
+    return 0;
+  }
+
+  return _Count(str, Searcher::Borrow(sub, true));
+}
+
+bool IIn(std::string_view str, std::string_view needle) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kIIn, str.size());
+  if (needle.length() == 0) {
+    return false;
   }
 
-  return str.substr(0, str.size() - (str.size() - last_non_token) + 1);
+  return _In(str, Searcher::Borrow(needle, true));
 }
 
-std::string TrimLeft(const std::string& str, const std::string& tokens) {
-  auto first_non_token = str.find_first_not_of(tokens);
-  if (first_non_token == std::string::npos) {
-    return "";
+bool IEndsWith(std::string_view str, std::string_view suffix) {
+  if (suffix.length() == 0 || str.length() < suffix.length()) {
+    return false;
   }
 
-  return str.substr(first_non_token);
+  return internal::AsciiEqualsIgnoreCase(
+      str.data() + str.length() - suffix.length(), suffix.data(),
+      suffix.length());
 }
 
-std::string Capitalize(const std::string& str) {
-  if (str.empty()) {
-    return "";
+bool IStartsWith(std::string_view str, std::string_view prefix) {
+  if (prefix.length() == 0 || str.length() < prefix.length()) {
+    return false;
   }
 
+  return internal::AsciiEqualsIgnoreCase(str.data(), prefix.data(),
+                                         prefix.length());
+}
+
+bool IEquals(std::string_view a, std::string_view b) {
+  return a.length() == b.length() &&
+         internal::AsciiEqualsIgnoreCase(a.data(), b.data(), a.length());
+}
+
+std::string Trim(std::string_view str, std::string_view tokens) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kTrim, str.size());
+  std::string result(TrimView(str, tokens));
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
+  return result;
+}
+
+std::string TrimRight(std::string_view str, std::string_view tokens) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kTrim, str.size());
+  std::string result(TrimRightView(str, tokens));
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
+  return result;
+}
+
+std::string TrimLeft(std::string_view str, std::string_view tokens) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kTrim, str.size());
+  std::string result(TrimLeftView(str, tokens));
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
+  return result;
+}
+
+std::pmr::string Trim(std::string_view str, std::string_view tokens,
+                      std::pmr::memory_resource* resource) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kTrim, str.size());
+  std::pmr::string result(TrimView(str, tokens), resource);
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
+  return result;
+}
+
+std::pmr::string TrimRight(std::string_view str, std::string_view tokens,
+                           std::pmr::memory_resource* resource) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kTrim, str.size());
+  std::pmr::string result(TrimRightView(str, tokens), resource);
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
+  return result;
+}
+
+std::pmr::string TrimLeft(std::string_view str, std::string_view tokens,
+                          std::pmr::memory_resource* resource) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kTrim, str.size());
+  std::pmr::string result(TrimLeftView(str, tokens), resource);
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
+  return result;
+}
+
+std::string_view TrimView(std::string_view str, std::string_view tokens) {
+  return internal::TrimSet(str, internal::CharSet(tokens), true, true);
+}
+
+std::string_view TrimRightView(std::string_view str, std::string_view tokens) {
+  return internal::TrimSet(str, internal::CharSet(tokens), false, true);
+}
+
+std::string_view TrimLeftView(std::string_view str, std::string_view tokens) {
+  return internal::TrimSet(str, internal::CharSet(tokens), true, false);
+}
+
+std::string Capitalize(std::string_view str) {
   std::string result(str);
-  result[0] = ::toupper(result[0]);
+  CapitalizeInPlace(result);
   return result;
 }
 
-std::string ToLower(const std::string& str) {
+void CapitalizeInPlace(std::string& str) {
+  if (!str.empty()) {
+    internal::AsciiToUpper(&str[0], 1);
+  }
+}
+
+std::string ToLower(std::string_view str) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kToLower, str.size());
   std::string result(str);
-  std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+  ToLowerInPlace(result);
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
   return result;
 }
 
-std::string ToUpper(const std::string& str) {
+void ToLowerInPlace(std::string& str) {
+  internal::AsciiToLower(&str[0], str.size());
+}
+
+std::string ToUpper(std::string_view str) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kToUpper, str.size());
   std::string result(str);
-  std::transform(result.begin(), result.end(), result.begin(), ::toupper);
+  ToUpperInPlace(result);
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
   return result;
 }
 
-std::string Replace(const std::string& str, const std::string& old,
-                    const std::string& replacement, int count) {
-  // Keep finding copies until we reach the end.
-  std::string str_replace(str);
-  size_t start = str_replace.find(old), replacements = 0;
-  while (start != std::string::npos) {
-    // Make sure we aren't over our limit.
-    if (count >= 0 && replacements >= count) {
-      break;
+void ToUpperInPlace(std::string& str) {
+  internal::AsciiToUpper(&str[0], str.size());
+}
+
+std::string Replace(std::string_view str, std::string_view old,
+                    std::string_view replacement, int count) {
+  return Replace(str, Searcher::Borrow(old), replacement, count);
+}
+
+std::string Replace(std::string_view str, const Searcher& old,
+                    std::string_view replacement, int count) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kReplace, str.size());
+  std::string result = _Replace(str, old, replacement, count);
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
+  return result;
+}
+
+std::pmr::string Replace(std::string_view str, std::string_view old,
+                         std::string_view replacement,
+                         std::pmr::memory_resource* resource, int count) {
+  return Replace(str, Searcher::Borrow(old), replacement, resource, count);
+}
+
+std::pmr::string Replace(std::string_view str, const Searcher& old,
+                         std::string_view replacement,
+                         std::pmr::memory_resource* resource, int count) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kReplace, str.size());
+  std::pmr::vector<size_t> matches(resource);
+  _FindMatches(str, old, count, matches);
+  std::pmr::string result(resource);
+  _ReplaceMatches(str, matches, old.size(), replacement, result);
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
+  return result;
+}
+
+std::string IReplace(std::string_view str, std::string_view old,
+                     std::string_view replacement, int count) {
+  CPPSTRING_METRICS_SCOPE(metrics, MetricFunction::kIReplace, str.size());
+  std::string result =
+      _Replace(str, Searcher::Borrow(old, true), replacement, count);
+  CPPSTRING_METRICS_OUTPUT(metrics, result);
+  return result;
+}
+
+namespace internal {
+
+void ReplaceInPlace(std::string& str, const Searcher& old,
+                    std::string_view replacement, int count) {
+  size_t old_size = old.size(), new_size = replacement.size();
+
+  // Same length: just overwrite each match.
+  if (!old.empty() && new_size == old_size) {
+    int replacements = 0;
+    for (size_t start = old.Find(str);
+         start != std::string::npos && (count < 0 || replacements < count);
+         start = old.Find(str, start + old_size)) {
+      memcpy(&str[start], replacement.data(), new_size);
+      replacements++;
     }
 
-    // Do the replacement.
-    str_replace.replace(start, old.size(), replacement);
-    start = str_replace.find(old, start + 1);
-    replacements++;
+    return;
   }
 
-  return str_replace;
+  // Shrinking: compact the string from left to right. We only ever write
+  // behind the position we are searching from, so the search never sees what
+  // we have written.
+  if (!old.empty() && new_size < old_size) {
+    char* data = &str[0];
+    int replacements = 0;
+    size_t read = 0, write = 0;
+    for (size_t start = old.Find(str);
+         start != std::string::npos && (count < 0 || replacements < count);
+         start = old.Find(str, read)) {
+      memmove(data + write, data + read, start - read);
+      write += start - read;
+      memcpy(data + write, replacement.data(), new_size);
+      write += new_size;
+      read = start + old_size;
+      replacements++;
+    }
+
+    memmove(data + write, data + read, str.size() - read);
+    str.resize(write + str.size() - read);
+    return;
+  }
+
+  // Growing: grow the string once, then fill it in from right to left so that
+  // nothing is overwritten before it has been moved.
+  std::vector<size_t> matches;
+  _FindMatches(str, old, count, matches);
+  size_t read = str.size();
+  str.resize(str.size() + matches.size() * (new_size - old_size));
+
+  char* data = &str[0];
+  size_t write = str.size();
+  for (auto it = matches.rbegin(); it != matches.rend(); ++it) {
+    size_t tail = read - (*it + old_size);
+    write -= tail;
+    memmove(data + write, data + *it + old_size, tail);
+    write -= new_size;
+    memcpy(data + write, replacement.data(), new_size);
+    read = *it;
+  }
+}
+
+}  // namespace internal
+
+std::string ReplaceMany(
+    std::string_view str,
+    const std::vector<std::pair<std::string, std::string>>& replacements) {
+  std::vector<std::string> olds, news;
+  for (const auto& replacement : replacements) {
+    olds.push_back(replacement.first);
+    news.push_back(replacement.second);
+  }
+
+  return ReplaceMany(str, MultiSearcher(olds), news);
+}
+
+std::string ReplaceMany(std::string_view str, const MultiSearcher& olds,
+                        const std::vector<std::string>& replacements) {
+  if (olds.size() != replacements.size()) {
+    throw std::invalid_argument("Need exactly one replacement per pattern.");
+  }
+
+  std::string result;
+  size_t last_end = 0;
+  olds.ForEachMatch(str, [&](const MultiSearcher::Match& match) {
+    result.append(str, last_end, match.start - last_end);
+    result.append(replacements[match.pattern]);
+    last_end = match.start + match.length;
+    return true;
+  });
+
+  result.append(str, last_end, std::string::npos);
+  return result;
 }
 
 }  // namespace string
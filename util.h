@@ -1,9 +1,50 @@
 #pragma once
 
+#include <memory_resource>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "charset.h"
+#include "matcher.h"
+#include "multisearch.h"
+#include "search.h"
 
 namespace string {
 
+// Internal; don't use directly.
+namespace internal {
+
+// Trim all characters in `tokens` from the requested sides of `str`, without
+// copying anything.
+inline std::string_view TrimSet(std::string_view str, const CharSet& tokens,
+                                bool left, bool right) {
+  size_t first = left ? FindFirstOf<true>(str, tokens) : 0;
+  if (first == std::string::npos) {
+    return std::string_view();
+  }
+
+  size_t last = right ? FindLastOf<true>(str, tokens) : str.size() - 1;
+  return str.substr(first, last - first + 1);
+}
+
+// Only std::string rvalues match this, so that functions can have overloads
+// which reuse the storage of an rvalue string without making calls with string
+// literals ambiguous with their std::string_view overloads.
+template <typename String>
+using IfStringRvalue =
+    typename std::enable_if<std::is_same<String, std::string>::value,
+                            std::string>::type;
+
+// Replace up to `count` occurrences of `old` in `str` with `replacement`, in
+// the storage of `str`.
+void ReplaceInPlace(std::string& str, const Searcher& old,
+                    std::string_view replacement, int count);
+
+}  // namespace internal
+
 /**
  * @brief      Count the number of occurrences of `sub` in `str`.
  *
@@ -19,7 +60,19 @@ namespace string {
  *
  * @return     The number of times `sub` occurs in `str`.
  */
-int Count(const std::string& str, const std::string& sub);
+int Count(std::string_view str, std::string_view sub);
+
+/**
+ * @brief      Count the number of non-overlapping occurrences of a precompiled
+ *             needle in `str`.
+ *
+ * @param[in]  str   The string to search.
+ * @param[in]  sub   The searcher for the substring to search for.
+ *
+ * @return     The number of times `sub` occurs in `str`.
+ * @see        Searcher
+ */
+int Count(std::string_view str, const Searcher& sub);
 
 /**
  * @brief      Determine whether `needle` is within `str.
@@ -29,7 +82,52 @@ int Count(const std::string& str, const std::string& sub);
  *
  * @return     `true` iff `needle` is within `str`.
  */
-bool In(const std::string& str, const std::string& needle);
+bool In(std::string_view str, std::string_view needle);
+
+/**
+ * @brief      Determine whether a precompiled needle is within `str`.
+ *
+ * @param[in]  str     The string to search.
+ * @param[in]  needle  The searcher for the needle to search for.
+ *
+ * @return     `true` iff `needle` is within `str`.
+ * @see        Searcher
+ */
+bool In(std::string_view str, const Searcher& needle);
+
+/**
+ * @brief      Determine whether any of the patterns in `needles` is within
+ *             `str`.
+ *
+ * @details    All patterns are searched for in a single pass over `str`.
+ *
+ * @param[in]  str      The string to search.
+ * @param[in]  needles  The searcher for the patterns to search for.
+ *
+ * @return     `true` iff at least one of the patterns is within `str`.
+ * @see        MultiSearcher
+ */
+bool InAny(std::string_view str, const MultiSearcher& needles);
+
+/**
+ * @brief      Count the number of occurrences of each pattern in `needles`
+ *             within `str`.
+ *
+ * @details    All patterns are counted in a single pass over `str`. Like
+ *             Count, only non-overlapping occurrences are counted, and where
+ *             two patterns overlap, the leftmost-longest one is counted. For
+ *             example:
+ *
+ *                 CountAll("abcab", MultiSearcher({"ab", "bc"})) -> {2, 0}
+ *
+ * @param[in]  str      The string to search.
+ * @param[in]  needles  The searcher for the patterns to search for.
+ *
+ * @return     The number of times each pattern occurs in `str`, indexed in the
+ *             same order as the patterns in `needles`.
+ * @see        MultiSearcher
+ */
+std::vector<int> CountAll(std::string_view str, const MultiSearcher& needles);
 
 /**
  * @brief      Determines if `str` ends with suffix `suffix`.
@@ -39,7 +137,29 @@ bool In(const std::string& str, const std::string& needle);
  *
  * @return     `true` iff `str` ends with `suffix`.
  */
-bool EndsWith(const std::string& str, const std::string& suffix);
+bool EndsWith(std::string_view str, std::string_view suffix);
+
+/**
+ * @brief      Determines if `str` ends with the needle of `suffix`.
+ *
+ * @param[in]  str     The string to search.
+ * @param[in]  suffix  The searcher for the suffix to search for.
+ *
+ * @return     `true` iff `str` ends with `suffix`.
+ * @see        Searcher
+ */
+bool EndsWith(std::string_view str, const Searcher& suffix);
+
+/**
+ * @brief      Determines if `str` ends with any of the suffixes in `suffixes`.
+ *
+ * @param[in]  str       The string to search.
+ * @param[in]  suffixes  The matcher for the suffixes to search for.
+ *
+ * @return     `true` iff `str` ends with at least one of `suffixes`.
+ * @see        SuffixMatcher
+ */
+bool EndsWithAny(std::string_view str, const SuffixMatcher& suffixes);
 
 /**
  * @brief      Determines if `str` starts with prefix `prefix`.
@@ -49,7 +169,92 @@ bool EndsWith(const std::string& str, const std::string& suffix);
  *
  * @return     `true` iff `str` starts with `prefix`.
  */
-bool StartsWith(const std::string& str, const std::string& prefix);
+bool StartsWith(std::string_view str, std::string_view prefix);
+
+/**
+ * @brief      Determines if `str` starts with the needle of `prefix`.
+ *
+ * @param[in]  str     The string to search.
+ * @param[in]  prefix  The searcher for the prefix to search for.
+ *
+ * @return     `true` iff `str` starts with `prefix`.
+ * @see        Searcher
+ */
+bool StartsWith(std::string_view str, const Searcher& prefix);
+
+/**
+ * @brief      Determines if `str` starts with any of the prefixes in
+ *             `prefixes`.
+ *
+ * @param[in]  str       The string to search.
+ * @param[in]  prefixes  The matcher for the prefixes to search for.
+ *
+ * @return     `true` iff `str` starts with at least one of `prefixes`.
+ * @see        PrefixMatcher
+ */
+bool StartsWithAny(std::string_view str, const PrefixMatcher& prefixes);
+
+/**
+ * @brief      Same as Count, but ignores the case of ASCII letters.
+ *
+ * @details    No copies of either string are made; bytes are case-folded as
+ *             they are compared.
+ *
+ *                 ICount("Abab", "AB") -> 2
+ *
+ * @param[in]  str   The string to search.
+ * @param[in]  sub   The substring to search for.
+ *
+ * @return     The number of times `sub` occurs in `str`, ignoring case.
+ * @see        Count
+ */
+int ICount(std::string_view str, std::string_view sub);
+
+/**
+ * @brief      Same as In, but ignores the case of ASCII letters.
+ *
+ * @param[in]  str     The string to search.
+ * @param[in]  needle  The needle to search for.
+ *
+ * @return     `true` iff `needle` is within `str`, ignoring case.
+ * @see        In
+ */
+bool IIn(std::string_view str, std::string_view needle);
+
+/**
+ * @brief      Same as EndsWith, but ignores the case of ASCII letters.
+ *
+ * @param[in]  str     The string to search.
+ * @param[in]  suffix  The suffix to search for.
+ *
+ * @return     `true` iff `str` ends with `suffix`, ignoring case.
+ * @see        EndsWith
+ */
+bool IEndsWith(std::string_view str, std::string_view suffix);
+
+/**
+ * @brief      Same as StartsWith, but ignores the case of ASCII letters.
+ *
+ * @param[in]  str     The string to search.
+ * @param[in]  prefix  The prefix to search for.
+ *
+ * @return     `true` iff `str` starts with `prefix`, ignoring case.
+ * @see        StartsWith
+ */
+bool IStartsWith(std::string_view str, std::string_view prefix);
+
+/**
+ * @brief      Determines if two strings are equal, ignoring the case of ASCII
+ *             letters.
+ *
+ *                 IEquals("Content-Type", "content-type") -> true
+ *
+ * @param[in]  a     The first string.
+ * @param[in]  b     The second string.
+ *
+ * @return     `true` iff `a` and `b` are equal, ignoring case.
+ */
+bool IEquals(std::string_view a, std::string_view b);
 
 /**
  * @brief      Trim all characters in `tokens` from either side of `str`.
@@ -61,7 +266,7 @@ bool StartsWith(const std::string& str, const std::string& prefix);
  * @see        TrimRight
  * @see        TrimLeft
  */
-std::string Trim(const std::string& str, const std::string& tokens);
+std::string Trim(std::string_view str, std::string_view tokens);
 
 /**
  * @brief      Trim all characters in `tokens` from the right side of `str`.
@@ -74,7 +279,7 @@ std::string Trim(const std::string& str, const std::string& tokens);
  * @see        Trim
  * @see        TrimLeft
  */
-std::string TrimRight(const std::string& str, const std::string& tokens);
+std::string TrimRight(std::string_view str, std::string_view tokens);
 
 /**
  * @brief      Trim all characters in `tokens` from the left side of `str`.
@@ -87,7 +292,147 @@ std::string TrimRight(const std::string& str, const std::string& tokens);
  * @see        Trim
  * @see        TrimRight
  */
-std::string TrimLeft(const std::string& str, const std::string& tokens);
+std::string TrimLeft(std::string_view str, std::string_view tokens);
+
+/**
+ * @brief      Trim all characters in `tokens` from either side of `str`,
+ *             without copying.
+ *
+ * @param[in]  str     The string to trim.
+ * @param[in]  tokens  The tokens to trim.
+ *
+ * @return     A view of `str` with all characters in `tokens` removed.
+ * @see        Trim
+ */
+std::string_view TrimView(std::string_view str, std::string_view tokens);
+
+/**
+ * @brief      Trim all characters in `tokens` from the right side of `str`,
+ *             without copying.
+ *
+ * @param[in]  str     The string to trim.
+ * @param[in]  tokens  The tokens to trim.
+ *
+ * @return     A view of `str` with all characters in `tokens` removed from the
+ *             right.
+ * @see        TrimRight
+ */
+std::string_view TrimRightView(std::string_view str, std::string_view tokens);
+
+/**
+ * @brief      Trim all characters in `tokens` from the left side of `str`,
+ *             without copying.
+ *
+ * @param[in]  str     The string to trim.
+ * @param[in]  tokens  The tokens to trim.
+ *
+ * @return     A view of `str` with all characters in `tokens` removed from the
+ *             left.
+ * @see        TrimLeft
+ */
+std::string_view TrimLeftView(std::string_view str, std::string_view tokens);
+
+/**
+ * @brief      Same as Trim, but allocates the result from `resource`.
+ * @see        Trim
+ */
+std::pmr::string Trim(std::string_view str, std::string_view tokens,
+                      std::pmr::memory_resource* resource);
+
+/**
+ * @brief      Same as TrimRight, but allocates the result from `resource`.
+ * @see        TrimRight
+ */
+std::pmr::string TrimRight(std::string_view str, std::string_view tokens,
+                           std::pmr::memory_resource* resource);
+
+/**
+ * @brief      Same as TrimLeft, but allocates the result from `resource`.
+ * @see        TrimLeft
+ */
+std::pmr::string TrimLeft(std::string_view str, std::string_view tokens,
+                          std::pmr::memory_resource* resource);
+
+/**
+ * @brief      Trim characters known at compile time from either side of `str`.
+ *
+ * @details    Identical to Trim, except that the tokens are given as template
+ *             arguments, so the lookup table is built at compile time.
+ *
+ *                 Trim<'|', ','>("|abc,") -> "abc"
+ *                 Trim<CharClass::Whitespace>(" abc\n") -> "abc"
+ *
+ * @param[in]  str     The string to trim.
+ *
+ * @tparam     Token   The tokens to trim.
+ *
+ * @return     A copy of `str` with all characters in `Token...` removed.
+ * @see        Trim
+ */
+template <char Token, char... Tokens>
+std::string Trim(std::string_view str) {
+  static constexpr internal::CharSet kTokens =
+      internal::MakeCharSet<Token, Tokens...>();
+  return std::string(internal::TrimSet(str, kTokens, true, true));
+}
+
+/**
+ * @brief      Trim all characters in a CharClass from either side of `str`.
+ *
+ * @param[in]  str     The string to trim.
+ *
+ * @tparam     Class   The class of characters to trim.
+ *
+ * @return     A copy of `str` with all characters in `Class` removed.
+ * @see        Trim
+ */
+template <CharClass Class>
+std::string Trim(std::string_view str) {
+  static constexpr internal::CharSet kTokens = internal::CharClassSet(Class);
+  return std::string(internal::TrimSet(str, kTokens, true, true));
+}
+
+/**
+ * @brief      Same as Trim<Token...>, but only trims the right side of `str`.
+ * @see        TrimRight
+ */
+template <char Token, char... Tokens>
+std::string TrimRight(std::string_view str) {
+  static constexpr internal::CharSet kTokens =
+      internal::MakeCharSet<Token, Tokens...>();
+  return std::string(internal::TrimSet(str, kTokens, false, true));
+}
+
+/**
+ * @brief      Same as Trim<Class>, but only trims the right side of `str`.
+ * @see        TrimRight
+ */
+template <CharClass Class>
+std::string TrimRight(std::string_view str) {
+  static constexpr internal::CharSet kTokens = internal::CharClassSet(Class);
+  return std::string(internal::TrimSet(str, kTokens, false, true));
+}
+
+/**
+ * @brief      Same as Trim<Token...>, but only trims the left side of `str`.
+ * @see        TrimLeft
+ */
+template <char Token, char... Tokens>
+std::string TrimLeft(std::string_view str) {
+  static constexpr internal::CharSet kTokens =
+      internal::MakeCharSet<Token, Tokens...>();
+  return std::string(internal::TrimSet(str, kTokens, true, false));
+}
+
+/**
+ * @brief      Same as Trim<Class>, but only trims the left side of `str`.
+ * @see        TrimLeft
+ */
+template <CharClass Class>
+std::string TrimLeft(std::string_view str) {
+  static constexpr internal::CharSet kTokens = internal::CharClassSet(Class);
+  return std::string(internal::TrimSet(str, kTokens, true, false));
+}
 
 /**
  * @brief      Capitalize the given string.
@@ -96,27 +441,97 @@ std::string TrimLeft(const std::string& str, const std::string& tokens);
  *
  * @return     A version of the string with the first letter capitalized.
  */
-std::string Capitalize(const std::string& str);
+std::string Capitalize(std::string_view str);
+
+/**
+ * @brief      Capitalize the given string in place.
+ *
+ * @param      str   The string to capitalize.
+ */
+void CapitalizeInPlace(std::string& str);
+
+/**
+ * @brief      Same as Capitalize, but reuses the storage of `str`.
+ *
+ * @param[in]  str   The string to capitalize.
+ *
+ * @return     `str`, with the first letter capitalized.
+ */
+template <typename String>
+internal::IfStringRvalue<String> Capitalize(String&& str) {
+  CapitalizeInPlace(str);
+  return std::move(str);
+}
 
 /**
  * @brief      Convert the given string to lowercase.
  *
+ * @details    Only ASCII letters are converted; all other bytes are left as
+ *             they are. The conversion doesn't depend on the current locale,
+ *             and is vectorized.
+ *
  * @param[in]  str   The string to convert.
  *
  * @return     A version of the string with all letters in their lowercase form.
  * @see        ToUpper
  */
-std::string ToLower(const std::string& str);
+std::string ToLower(std::string_view str);
+
+/**
+ * @brief      Convert the given string to lowercase in place.
+ *
+ * @param      str   The string to convert.
+ * @see        ToLower
+ */
+void ToLowerInPlace(std::string& str);
+
+/**
+ * @brief      Same as ToLower, but reuses the storage of `str`.
+ *
+ * @param[in]  str   The string to convert.
+ *
+ * @return     `str`, with all letters in their lowercase form.
+ */
+template <typename String>
+internal::IfStringRvalue<String> ToLower(String&& str) {
+  ToLowerInPlace(str);
+  return std::move(str);
+}
 
 /**
  * @brief      Convert the given string to uppercase.
  *
+ * @details    Only ASCII letters are converted; all other bytes are left as
+ *             they are. The conversion doesn't depend on the current locale,
+ *             and is vectorized.
+ *
  * @param[in]  str   The string to convert.
  *
  * @return     A version of the string with all letters in their uppercase form.
  * @see        ToLower
  */
-std::string ToUpper(const std::string& str);
+std::string ToUpper(std::string_view str);
+
+/**
+ * @brief      Convert the given string to uppercase in place.
+ *
+ * @param      str   The string to convert.
+ * @see        ToUpper
+ */
+void ToUpperInPlace(std::string& str);
+
+/**
+ * @brief      Same as ToUpper, but reuses the storage of `str`.
+ *
+ * @param[in]  str   The string to convert.
+ *
+ * @return     `str`, with all letters in their uppercase form.
+ */
+template <typename String>
+internal::IfStringRvalue<String> ToUpper(String&& str) {
+  ToUpperInPlace(str);
+  return std::move(str);
+}
 
 /**
  * @brief      Replace all occurrences of `old` with `replacement` in `str`.
@@ -125,6 +540,10 @@ std::string ToUpper(const std::string& str);
  *             `replacement` in `str`. This replacement will occur from left
  *             to right.
  *
+ *             This runs in linear time, and the result is allocated exactly
+ *             once. Pass `str` as an rvalue to do the replacement in its
+ *             storage instead.
+ *
  * @param[in]  str           The string to replace the contents of.
  * @param[in]  old           The string to replace.
  * @param[in]  replacement   The string to replace it with.
@@ -132,7 +551,147 @@ std::string ToUpper(const std::string& str);
  *
  * @return     A new string with the replacement performed.
  */
-std::string Replace(const std::string& str, const std::string& old,
-                    const std::string& replacement, int count = -1);
+std::string Replace(std::string_view str, std::string_view old,
+                    std::string_view replacement, int count = -1);
+
+/**
+ * @brief      Replace all occurrences of a precompiled needle with
+ *             `replacement` in `str`.
+ *
+ * @param[in]  str           The string to replace the contents of.
+ * @param[in]  old           The searcher for the string to replace.
+ * @param[in]  replacement   The string to replace it with.
+ * @param[in]  count         The number of replacements to make.
+ *
+ * @return     A new string with the replacement performed.
+ * @see        Searcher
+ */
+std::string Replace(std::string_view str, const Searcher& old,
+                    std::string_view replacement, int count = -1);
+
+/**
+ * @brief      Same as Replace, but reuses the storage of `str`.
+ *
+ * @details    When `replacement` is no longer than `old`, no allocation is
+ *             made at all. Otherwise, `str` is grown at most once.
+ *
+ * @param[in]  str           The string to replace the contents of.
+ * @param[in]  old           The string to replace.
+ * @param[in]  replacement   The string to replace it with.
+ * @param[in]  count         The number of replacements to make.
+ *
+ * @return     `str`, with the replacement performed.
+ */
+template <typename String>
+internal::IfStringRvalue<String> Replace(String&& str, std::string_view old,
+                                         std::string_view replacement,
+                                         int count = -1) {
+  internal::ReplaceInPlace(str, Searcher(old), replacement, count);
+  return std::move(str);
+}
+
+/**
+ * @brief      Same as Replace, but reuses the storage of `str`.
+ *
+ * @param[in]  str           The string to replace the contents of.
+ * @param[in]  old           The searcher for the string to replace.
+ * @param[in]  replacement   The string to replace it with.
+ * @param[in]  count         The number of replacements to make.
+ *
+ * @return     `str`, with the replacement performed.
+ * @see        Searcher
+ */
+template <typename String>
+internal::IfStringRvalue<String> Replace(String&& str, const Searcher& old,
+                                         std::string_view replacement,
+                                         int count = -1) {
+  internal::ReplaceInPlace(str, old, replacement, count);
+  return std::move(str);
+}
+
+/**
+ * @brief      Same as Replace, but allocates the result from `resource`.
+ *
+ * @details    The result, and the positions of the matches which are found
+ *             while building it, are allocated from `resource`, so a whole
+ *             batch of replacements can be released at once by using an arena
+ *             such as std::pmr::monotonic_buffer_resource. The Searcher built
+ *             for `old` still uses the global heap if `old` is long; pass a
+ *             Searcher which is built once to avoid that.
+ *
+ * @param[in]  str           The string to replace the contents of.
+ * @param[in]  old           The string to replace.
+ * @param[in]  replacement   The string to replace it with.
+ * @param      resource      The memory resource to allocate from.
+ * @param[in]  count         The number of replacements to make.
+ *
+ * @return     A new string with the replacement performed.
+ */
+std::pmr::string Replace(std::string_view str, std::string_view old,
+                         std::string_view replacement,
+                         std::pmr::memory_resource* resource, int count = -1);
+
+/**
+ * @brief      Same as Replace, but allocates the result from `resource`.
+ * @see        Searcher
+ */
+std::pmr::string Replace(std::string_view str, const Searcher& old,
+                         std::string_view replacement,
+                         std::pmr::memory_resource* resource, int count = -1);
+
+/**
+ * @brief      Same as Replace, but ignores the case of ASCII letters when
+ *             searching for `old`.
+ *
+ *                 IReplace("Hello HELLO", "hello", "bye") -> "bye bye"
+ *
+ * @param[in]  str           The string to replace the contents of.
+ * @param[in]  old           The string to replace.
+ * @param[in]  replacement   The string to replace it with.
+ * @param[in]  count         The number of replacements to make.
+ *
+ * @return     A new string with the replacement performed.
+ * @see        Replace
+ */
+std::string IReplace(std::string_view str, std::string_view old,
+                     std::string_view replacement, int count = -1);
+
+/**
+ * @brief      Replace all occurrences of several strings at once.
+ *
+ * @details    All strings are replaced in a single pass over `str`, so the
+ *             result of one replacement is never seen by another. Where two of
+ *             the strings to replace overlap, the leftmost-longest one is
+ *             replaced. For example:
+ *
+ *                 ReplaceMany("cat dog", {{"cat", "dog"}, {"dog", "cat"}})
+ *                     -> "dog cat"
+ *
+ * @param[in]  str           The string to replace the contents of.
+ * @param[in]  replacements  Pairs of {old, replacement} strings.
+ *
+ * @return     A new string with all replacements performed.
+ * @see        MultiSearcher
+ */
+std::string ReplaceMany(
+    std::string_view str,
+    const std::vector<std::pair<std::string, std::string>>& replacements);
+
+/**
+ * @brief      Replace all occurrences of several precompiled strings at once.
+ *
+ * @param[in]  str           The string to replace the contents of.
+ * @param[in]  olds          The searcher for the strings to replace.
+ * @param[in]  replacements  The replacement for each pattern in `olds`,
+ *                           indexed in the same order.
+ *
+ * @throws     std::invalid_argument Thrown if there isn't exactly one
+ *                                   replacement for each pattern.
+ *
+ * @return     A new string with all replacements performed.
+ * @see        ReplaceMany
+ */
+std::string ReplaceMany(std::string_view str, const MultiSearcher& olds,
+                        const std::vector<std::string>& replacements);
 
 }  // namespace string
@@ -1,7 +1,36 @@
 #include "util.h"
 
+#include <stdlib.h>
+
+#include <new>
+
 #include <gtest/gtest.h>
 
+namespace {
+
+// The number of allocations made through operator new by this thread.
+thread_local size_t allocations = 0;
+
+}  // namespace
+
+void* operator new(size_t size) {
+  allocations++;
+  if (void* p = malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+
+  throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  allocations++;
+  return malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { free(p); }
+
 TEST(TestCount, TestReturns0ForEmptySourceString) {
   ASSERT_EQ(0, string::Count("", "search"));
 }
@@ -178,3 +207,290 @@ TEST(TestReplace, TestReplaceDoesNoReplacementsWhenCountIs0) {
 TEST(TestReplace, TestReplaceDoesNotReplaceOveralappingReplacements) {
   ASSERT_STREQ("defba", string::Replace("ababa", "aba", "def").c_str());
 }
+
+TEST(TestTrimStatic, TestTrimStaticWithSingleToken) {
+  ASSERT_STREQ("abc", string::Trim<'|'>("|abc|").c_str());
+  ASSERT_STREQ("abc|", string::TrimLeft<'|'>("|abc|").c_str());
+  ASSERT_STREQ("|abc", string::TrimRight<'|'>("|abc|").c_str());
+}
+
+TEST(TestTrimStatic, TestTrimStaticWithMultipleTokens) {
+  ASSERT_STREQ("abc", (string::Trim<'|', ','>(",|abc,|")).c_str());
+}
+
+TEST(TestTrimStatic, TestTrimStaticWithOnlyTokensReturnsEmptyString) {
+  ASSERT_STREQ("", (string::Trim<'|', ','>(",|,|")).c_str());
+  ASSERT_STREQ("", (string::TrimLeft<'|', ','>(",|,|")).c_str());
+  ASSERT_STREQ("", (string::TrimRight<'|', ','>(",|,|")).c_str());
+}
+
+TEST(TestTrimStatic, TestTrimStaticWithCharClass) {
+  using string::CharClass;
+  ASSERT_STREQ("a b",
+               string::Trim<CharClass::Whitespace>("\t a b\r\n").c_str());
+  ASSERT_STREQ("a b\r\n",
+               string::TrimLeft<CharClass::Whitespace>("\t a b\r\n").c_str());
+  ASSERT_STREQ("abc", string::Trim<CharClass::Digit>("12abc34").c_str());
+}
+
+TEST(TestCharClass, TestConstantsAreConstexpr) {
+  static_assert(string::kAsciiLetters.size() == 52);
+  static_assert(string::kPrintable.size() == 100);
+  static_assert(string::IsDigit('7') && !string::IsDigit('a'));
+  static_assert(string::IsAllCharClass("ff00", string::CharClass::HexDigit));
+  ASSERT_EQ("\033[30m\033[1m", std::string(string::color::kGray));
+}
+
+TEST(TestCharClass, TestClassifiersMatchConstants) {
+  const std::pair<std::string_view, bool (*)(char)> classes[] = {
+      {string::kWhitespace, string::IsWhitespace},
+      {string::kDigits, string::IsDigit},
+      {string::kHexDigits, string::IsHexDigit},
+      {string::kOctDigits, string::IsOctDigit},
+      {string::kAsciiLowercase, string::IsLowercase},
+      {string::kAsciiUppercase, string::IsUppercase},
+      {string::kAsciiLetters, string::IsLetter},
+      {string::kPunctuation, string::IsPunctuation},
+      {string::kPrintable, string::IsPrintable},
+  };
+
+  for (const auto& cls : classes) {
+    for (int c = 0; c < 256; c++) {
+      bool expected = cls.first.find(static_cast<char>(c)) != std::string::npos;
+      ASSERT_EQ(expected, cls.second(static_cast<char>(c))) << c;
+    }
+  }
+}
+
+TEST(TestCharClass, TestIsAllCharClass) {
+  ASSERT_TRUE(string::IsAllCharClass("12345", string::CharClass::Digit));
+  ASSERT_FALSE(string::IsAllCharClass("123a5", string::CharClass::Digit));
+  ASSERT_FALSE(string::IsAllCharClass("", string::CharClass::Digit));
+  ASSERT_TRUE(string::IsCharClass(' ', string::CharClass::Whitespace));
+}
+
+TEST(TestCount, TestCountsAdjacentMatches) {
+  ASSERT_EQ(3, string::Count("ababab", "ab"));
+  ASSERT_EQ(2, string::Count("aaaa", "aa"));
+}
+
+TEST(TestReplace, TestReplaceDoesNotRescanReplacement) {
+  ASSERT_STREQ("aaaa", string::Replace("aa", "a", "aa").c_str());
+}
+
+TEST(TestReplace, TestReplaceEmptyStringInsertsBetweenCharacters) {
+  ASSERT_STREQ("xaxbx", string::Replace("ab", "", "x").c_str());
+  ASSERT_STREQ("xab", string::Replace("ab", "", "x", 1).c_str());
+  ASSERT_STREQ("x", string::Replace("", "", "x").c_str());
+}
+
+TEST(TestReplace, TestReplaceWithShorterReplacement) {
+  ASSERT_STREQ("x-x-x", string::Replace("abc-abc-abc", "abc", "x").c_str());
+  ASSERT_STREQ("--", string::Replace("abc-abc-abc", "abc", "").c_str());
+  ASSERT_STREQ("x-abc-abc",
+               string::Replace("abc-abc-abc", "abc", "x", 1).c_str());
+}
+
+TEST(TestReplace, TestReplaceWithLongerReplacement) {
+  ASSERT_STREQ("[a][b]-[a][b]",
+               string::Replace("ab-ab", "ab", "[a][b]").c_str());
+  ASSERT_STREQ("[a][b]-ab",
+               string::Replace("ab-ab", "ab", "[a][b]", 1).c_str());
+}
+
+TEST(TestReplace, TestReplaceRvalueReusesInput) {
+  for (const std::string replacement : {"", "x", "xy", "xyz", "wxyz"}) {
+    for (int count : {-1, 0, 1, 2}) {
+      std::string str = "xy-xy--xy-";
+      std::string expected = string::Replace(str, "xy", replacement, count);
+      ASSERT_EQ(expected,
+                string::Replace(std::move(str), "xy", replacement, count));
+    }
+  }
+}
+
+TEST(TestReplace, TestReplaceRvalueSameLengthKeepsStorage) {
+  std::string str(100, 'a');
+  const char* data = str.data();
+  std::string result = string::Replace(std::move(str), "aa", "bb");
+  ASSERT_EQ(std::string(100, 'b'), result);
+  ASSERT_EQ(data, result.data());
+}
+
+TEST(TestReplace, TestReplaceLargeInput) {
+  std::string str, expected;
+  for (int i = 0; i < 10000; i++) {
+    str += "a.b.";
+    expected += "a--b--";
+  }
+
+  ASSERT_EQ(expected, string::Replace(str, ".", "--"));
+}
+
+TEST(TestSimple, TestToLowerAndToUpperOnAllBytes) {
+  std::string all, lower, upper;
+  for (int i = 0; i < 3; i++) {
+    for (int c = 0; c < 256; c++) {
+      all += static_cast<char>(c);
+      lower += static_cast<char>((c >= 'A' && c <= 'Z') ? c + 32 : c);
+      upper += static_cast<char>((c >= 'a' && c <= 'z') ? c - 32 : c);
+    }
+  }
+
+  ASSERT_EQ(lower, string::ToLower(all));
+  ASSERT_EQ(upper, string::ToUpper(all));
+}
+
+TEST(TestSimple, TestInPlaceCaseConversion) {
+  std::string str = "Hello, World! This is a Longer String.";
+  string::ToLowerInPlace(str);
+  ASSERT_EQ("hello, world! this is a longer string.", str);
+  string::ToUpperInPlace(str);
+  ASSERT_EQ("HELLO, WORLD! THIS IS A LONGER STRING.", str);
+
+  std::string empty;
+  string::ToLowerInPlace(empty);
+  string::CapitalizeInPlace(empty);
+  ASSERT_EQ("", empty);
+}
+
+TEST(TestSimple, TestRvalueCaseConversionKeepsStorage) {
+  std::string str(64, 'a');
+  const char* data = str.data();
+  std::string result = string::ToUpper(std::move(str));
+  ASSERT_EQ(std::string(64, 'A'), result);
+  ASSERT_EQ(data, result.data());
+  ASSERT_STREQ("Abc", string::Capitalize(std::string("abc")).c_str());
+}
+
+TEST(TestTrimView, TestTrimViewReturnsSubviewOfInput) {
+  std::string str = "  abc  ";
+  auto view = string::TrimView(str, " ");
+  ASSERT_EQ("abc", view);
+  ASSERT_EQ(str.data() + 2, view.data());
+  ASSERT_EQ("abc  ", string::TrimLeftView(str, " "));
+  ASSERT_EQ("  abc", string::TrimRightView(str, " "));
+}
+
+TEST(TestTrimView, TestTrimViewWithOnlyTokensReturnsEmptyView) {
+  ASSERT_TRUE(string::TrimView(",|,|", "|,").empty());
+  ASSERT_TRUE(string::TrimLeftView(",|,|", "|,").empty());
+  ASSERT_TRUE(string::TrimRightView(",|,|", "|,").empty());
+  ASSERT_TRUE(string::TrimView("", "|,").empty());
+}
+
+TEST(TestStringView, TestFunctionsAcceptStringViews) {
+  const char buffer[] = "xxhello worldxx";
+  std::string_view view(buffer + 2, 11);
+  ASSERT_EQ(3, string::Count(view, "l"));
+  ASSERT_TRUE(string::In(view, "lo w"));
+  ASSERT_FALSE(string::In(view, "xx"));
+  ASSERT_TRUE(string::StartsWith(view, "hello"));
+  ASSERT_TRUE(string::EndsWith(view, "world"));
+  ASSERT_EQ("ello worl", string::Trim(view, "hd"));
+  ASSERT_EQ("HELLO WORLD", string::ToUpper(view));
+  ASSERT_EQ("Hello world", string::Capitalize(view));
+  ASSERT_EQ("hello there", string::Replace(view, "world", "there"));
+}
+
+TEST(TestCaseInsensitive, TestICount) {
+  ASSERT_EQ(2, string::ICount("Abab", "AB"));
+  ASSERT_EQ(0, string::ICount("Abab", ""));
+  ASSERT_EQ(0, string::ICount("", "ab"));
+}
+
+TEST(TestCaseInsensitive, TestIIn) {
+  ASSERT_TRUE(string::IIn("Content-Type: text/html", "TEXT/HTML"));
+  ASSERT_FALSE(string::IIn("Content-Type: text/html", "text/plain"));
+  ASSERT_FALSE(string::IIn("abc", ""));
+}
+
+TEST(TestCaseInsensitive, TestIStartsWithAndIEndsWith) {
+  ASSERT_TRUE(string::IStartsWith("Content-Length: 10", "content-length"));
+  ASSERT_FALSE(string::IStartsWith("Content", "content-length"));
+  ASSERT_FALSE(string::IStartsWith("Content", ""));
+  ASSERT_TRUE(string::IEndsWith("www.Example.COM", "example.com"));
+  ASSERT_FALSE(string::IEndsWith("com", "example.com"));
+  ASSERT_FALSE(string::IEndsWith("com", ""));
+}
+
+TEST(TestCaseInsensitive, TestIEquals) {
+  ASSERT_TRUE(string::IEquals("Content-Type", "content-type"));
+  ASSERT_TRUE(string::IEquals("", ""));
+  ASSERT_FALSE(string::IEquals("Content-Type", "content-typ"));
+  ASSERT_FALSE(string::IEquals("@", "`"));
+  ASSERT_TRUE(string::IEquals(std::string(100, 'a') + "Z",
+                              std::string(100, 'A') + "z"));
+  ASSERT_FALSE(string::IEquals(std::string(100, 'a') + "Z",
+                               std::string(100, 'A') + "y"));
+}
+
+TEST(TestCaseInsensitive, TestIReplace) {
+  ASSERT_STREQ("bye bye",
+               string::IReplace("Hello HELLO", "hello", "bye").c_str());
+  ASSERT_STREQ("bye HELLO",
+               string::IReplace("Hello HELLO", "hello", "bye", 1).c_str());
+}
+
+TEST(TestMemoryResource, TestReplaceAndTrimAllocateFromResource) {
+  char buffer[4096];
+  std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+                                            std::pmr::null_memory_resource());
+
+  auto replaced = string::Replace("a long string with a few words", "a",
+                                  "the", &arena);
+  ASSERT_EQ("the long string with the few words", replaced);
+  ASSERT_EQ(&arena, replaced.get_allocator().resource());
+
+  ASSERT_EQ("xbxb", string::Replace("abab", "a", "x", &arena));
+  ASSERT_EQ("xbab", string::Replace("abab", "a", "x", &arena, 1));
+  ASSERT_EQ("bb", string::Replace("abab", string::Searcher("a"), "", &arena));
+
+  auto trimmed = string::Trim("  a fairly long padded string  ", " ", &arena);
+  ASSERT_EQ("a fairly long padded string", trimmed);
+  ASSERT_EQ(&arena, trimmed.get_allocator().resource());
+  ASSERT_EQ("ab  ", string::TrimLeft("  ab  ", " ", &arena));
+  ASSERT_EQ("  ab", string::TrimRight("  ab  ", " ", &arena));
+}
+
+TEST(TestAllocations, TestOneShotSearchesDontAllocate) {
+  // Long enough to be copied out of the small string buffer, and to need a
+  // Horspool shift table.
+  std::string needle = "application/json; charset=utf-8; boundary=xyz";
+  std::string haystack = "content-type: " + needle + "\r\n";
+
+  std::string missing = needle + "!";
+
+  size_t before = allocations;
+  int count = string::Count(haystack, needle);
+  bool found = string::In(haystack, needle);
+  bool found_missing = string::In(haystack, missing);
+  size_t after = allocations;
+
+  ASSERT_EQ(1, count);
+  ASSERT_TRUE(found);
+  ASSERT_FALSE(found_missing);
+  ASSERT_EQ(before, after);
+}
+
+TEST(TestAllocations, TestCaseInsensitiveFunctionsOnlyAllocateTheResult) {
+  std::string needle = "APPLICATION/JSON; CHARSET=UTF-8; BOUNDARY=XYZ";
+  std::string haystack = "Content-Type: application/json; charset=utf-8; "
+                         "boundary=xyz\r\n";
+  std::string replacement(needle.size(), '-');
+
+  size_t before = allocations;
+  int count = string::ICount(haystack, needle);
+  bool found = string::IIn(haystack, needle);
+  bool found_short = string::IIn(haystack, "JSON");
+  size_t after_search = allocations;
+  std::string replaced = string::IReplace(haystack, needle, replacement);
+  size_t after_replace = allocations;
+
+  ASSERT_EQ(1, count);
+  ASSERT_TRUE(found);
+  ASSERT_TRUE(found_short);
+  ASSERT_EQ("Content-Type: " + replacement + "\r\n", replaced);
+  ASSERT_EQ(before, after_search);
+  ASSERT_EQ(after_search + 1, after_replace);
+}